@@ -8,6 +8,10 @@
 // Model headers
 #include "SimpleModel.h"
 #include "AssimpModelLoader.h"
+#include "VertexFetchBenchmark.h"
+
+#include "JobSystem.h"
+#include "TextureStreamer.h"
 
 #include <iostream>
 #include <iomanip>
@@ -20,7 +24,6 @@ private:
 	// For axes
 	VertexArray	axesVAO;
 	VertexBuffer<float> axesVBO;
-	BufferLayout axesLayout;
 	Shader axesShader;
 
 	// Backpack Model
@@ -35,6 +38,12 @@ private:
 	SimpleModel lampModel;
 	Shader lampShader;
 
+	// Textures are decoded on the workers and uploaded a slice per frame
+	JobSystem jobs;
+	TextureStreamer textureStreamer;
+	std::chrono::system_clock::time_point tLoadStart;
+	bool bTexturesResident = false;
+
 	// Projection matrix
 	glm::mat4 matProjection;
 	float fFov = 80.0f;
@@ -54,9 +63,9 @@ public:
 
 		// Axes
 		axesVAO.generate();
-		axesVBO.generate(3);		// 3 floats per vertex
+		axesVBO.generate(std::size(line_vertices) / 3);		// 3 floats per vertex
 		axesVBO.setBuffer(sizeof(line_vertices), (const void*)line_vertices);
-		axesLayout.setBufferLayout(axesVAO, axesVBO, 3, BufferType::FLOAT);
+		VertexLayout::apply<PositionVertex>(axesVAO, axesVBO);
 		axesShader.load("shaders/Line.glsl");
 
 		// ---------------------------- Load Models -----------------------------
@@ -64,19 +73,33 @@ public:
 		backpackShader.load("shaders/Backpack.glsl");
 		teapotShader.load("shaders/BasicAssimp.glsl");
 
-		lampModel.load("models/Cube.obj");
+		// Vertices are compressed unless started with --compress-vertices 0
+		const bool bCompressVertices = GetOption("--compress-vertices", "1") != "0";
+		backpackModel.compressVertices = bCompressVertices;
+		teapotModel.compressVertices = bCompressVertices;
+
+		lampModel.load("models/Cube.obj", bCompressVertices);
 		lampShader.load("shaders/Lamp.glsl");
 
 		InitShaders();
 
+		jobs.init();
+		textureStreamer.init(jobs);
+
 		auto dt1 = std::chrono::system_clock::now();
-		backpackModel.load("models/backpack/backpack.obj");
-		teapotModel.load("models/teapot.obj");
+		tLoadStart = dt1;
+		backpackModel.load("models/backpack/backpack.obj", textureStreamer);
+		teapotModel.load("models/teapot.obj", textureStreamer);
 		auto dt2 = std::chrono::system_clock::now();
 
 		float fTimeTaken = std::chrono::duration_cast<std::chrono::milliseconds>(dt2 - dt1).count();
 		std::cout << "Time taken to load models: " << std::fixed << std::setprecision(2) << fTimeTaken/1000 << " seconds" << std::endl;
 
+		// --vertex-fetch <draws> times the full and the compressed vertices of the backpack
+		const int nFetchDraws = atoi(GetOption("--vertex-fetch", "0").c_str());
+		if (nFetchDraws > 0)
+			VertexFetchBenchmark::run("models/backpack/backpack.obj", backpackShader, textureStreamer, nFetchDraws);
+
 		// Set projection matries in shaders
 		SetProjectionMatrix();
 
@@ -89,6 +112,18 @@ public:
 		//glClearColor(0.38f, 0.76f, 0.93f, 1.0f);
 		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
 
+		// Finish decoded textures and upload the next slice of them. Neither waits for the workers.
+		jobs.processCompleted();
+		textureStreamer.update();
+
+		if (!bTexturesResident && textureStreamer.getPendingCount() == 0 && jobs.getPendingCount() == 0)
+		{
+			std::chrono::duration<float> elapsedTime = std::chrono::system_clock::now() - tLoadStart;
+			std::cout << "Textures resident after " << std::fixed << std::setprecision(2) << elapsedTime.count() << " seconds" << std::endl;
+
+			bTexturesResident = true;
+		}
+
 		HandleInputs(fElapsedTime);
 
 		RenderModels();
@@ -143,7 +178,7 @@ public:
 		matModel = glm::scale(matModel, glm::vec3(0.2f));
 		lampShader.setMat4("matModel", matModel);
 
-		lampModel.draw();
+		lampModel.draw(lampShader);
 
 		// Render backpack
 		backpackShader.use();
@@ -157,6 +192,7 @@ public:
 		matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 		matModel = glm::scale(matModel, glm::vec3(1.0f, 1.0f, 1.0f));
 		backpackShader.setMat4("matModel", matModel);
+		backpackShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		backpackModel.Draw(backpackShader);
 
@@ -172,6 +208,7 @@ public:
 		matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 		matModel = glm::scale(matModel, glm::vec3(0.3f, 0.3f, 0.3f));
 		teapotShader.setMat4("matModel", matModel);
+		teapotShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		teapotModel.Draw(teapotShader);
 	}
@@ -249,64 +286,85 @@ public:
 
 	void HandleInputs(float fElapsedTime)
 	{
-		/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
-		if (GetKey('W').bHeld && !GetKey('S').bHeld)
-			camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
-		else if (GetKey('S').bHeld && !GetKey('W').bHeld)
-			camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
-
-		if (GetKey('A').bHeld && !GetKey('D').bHeld)
-			camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
-		else if (GetKey('D').bHeld && !GetKey('A').bHeld)
-			camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
-
-		if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
-			camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
-		else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
-			camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
-
-		// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
-		if (GetKey('C').bHeld)
+		// Benchmarks replay a camera path instead of reading the inputs
+		CameraPose pose;
+		if (GetBenchmarkPose(pose))
 		{
-			if (fFov > 10.0f)
-				fFov -= fElapsedTime * 200.0f;
-
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			backpackShader.use();
-			backpackShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
-			teapotShader.use();
-			teapotShader.setMat4("matProjection", matProjection);
-		}
+			camera.setPose(pose);
 
-		else if (GetKey('C').bReleased)
-		{
-			fFov = 80.0f;
-
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			backpackShader.use();
-			backpackShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
-			teapotShader.use();
-			teapotShader.setMat4("matProjection", matProjection);
+			if (pose.fFov != fFov)
+			{
+				fFov = pose.fFov;
+				SetProjectionMatrix();
+			}
 		}
 
-		if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
-			camera.fCameraSpeed = 20.0f;
 		else
-			camera.fCameraSpeed = 5.0f;
-
-		if (GetKey(GLFW_KEY_HOME).bPressed)
-			camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
-
-		/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
-		camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+		{
+			/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
+			if (GetKey('W').bHeld && !GetKey('S').bHeld)
+				camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
+			else if (GetKey('S').bHeld && !GetKey('W').bHeld)
+				camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
+
+			if (GetKey('A').bHeld && !GetKey('D').bHeld)
+				camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
+			else if (GetKey('D').bHeld && !GetKey('A').bHeld)
+				camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
+
+			if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
+				camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
+			else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
+				camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
+
+			// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
+			if (GetKey('C').bHeld)
+			{
+				if (fFov > 10.0f)
+					fFov -= fElapsedTime * 200.0f;
+
+				matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
+				axesShader.use();
+				axesShader.setMat4("matProjection", matProjection);
+				backpackShader.use();
+				backpackShader.setMat4("matProjection", matProjection);
+				lampShader.use();
+				lampShader.setMat4("matProjection", matProjection);
+				teapotShader.use();
+				teapotShader.setMat4("matProjection", matProjection);
+			}
+
+			else if (GetKey('C').bReleased)
+			{
+				fFov = 80.0f;
+
+				matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
+				axesShader.use();
+				axesShader.setMat4("matProjection", matProjection);
+				backpackShader.use();
+				backpackShader.setMat4("matProjection", matProjection);
+				lampShader.use();
+				lampShader.setMat4("matProjection", matProjection);
+				teapotShader.use();
+				teapotShader.setMat4("matProjection", matProjection);
+			}
+
+			if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
+				camera.fCameraSpeed = 20.0f;
+			else
+				camera.fCameraSpeed = 5.0f;
+
+			if (GetKey(GLFW_KEY_HOME).bPressed)
+				camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+
+			/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
+			camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+
+			// Saved with --record, to be replayed with --benchmark
+			pose = camera.getPose();
+			pose.fFov = fFov;
+			RecordCameraPose(pose);
+		}
 
 		// Update view matrix
 		camera.UpdateView(axesShader, "matView");
@@ -329,8 +387,17 @@ public:
 		teapotShader.setMat4("matProjection", matProjection);
 	}
 
+	bool IsReady() override
+	{
+		return textureStreamer.getPendingCount() == 0 && jobs.getPendingCount() == 0;
+	}
+
 	void Destroy() override
 	{
+		// Stop the workers first, their completions refer to the texture streamer
+		jobs.shutdown();
+		textureStreamer.free();
+
 		axesVAO.free();
 		axesVBO.free();
 
@@ -338,9 +405,10 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char* argv[])
 {
 	Window window;
+	window.ParseArguments(argc, argv, { "--compress-vertices", "--vertex-fetch" });
 	window.ConstructWindow(800, 600, "OpenGL");
 	window.Start();
 
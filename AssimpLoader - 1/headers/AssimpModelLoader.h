@@ -15,6 +15,7 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "TextureStreamer.h"
 
 #include <iostream>
 #include <string>
@@ -31,13 +32,33 @@ public:
 	std::string directory;
 	bool gammaCorrection = false;
 
+	// Meshes are uploaded with compressed vertices when set, see VertexCompression.h. Set before load().
+	bool compressVertices = false;
+	VertexCompressionStats compressionStats;
+
+	// Textures are loaded in the background when set, see load()
+	TextureStreamer* textureStreamer = nullptr;
+
 	// constructor, expects a filepath to a 3D model.
 	Model() = default;
 
 	void load(const std::string& path, bool gamma = false)
 	{
 		gammaCorrection = gamma;
+		compressionStats = VertexCompressionStats();
 		LoadModel(path);
+
+		if (compressVertices)
+			compressionStats.print(path);
+	}
+
+	// Same as above, but the textures are decoded and uploaded by 'streamer'. Meshes show a placeholder texture
+	// until theirs are resident.
+	void load(const std::string& path, TextureStreamer& streamer, bool gamma = false)
+	{
+		textureStreamer = &streamer;
+		load(path, gamma);
+		textureStreamer = nullptr;
 	}
 
 	// draws the model by drawing the loaded meshes
@@ -47,6 +68,15 @@ public:
 			meshes[i].Draw(shader);
 	}
 
+	// deletes the buffers of the meshes, textures are left alone as other models may share them
+	void free()
+	{
+		for (Mesh& mesh : meshes)
+			mesh.free();
+
+		meshes.clear();
+	}
+
 private:
 	// loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
 	void LoadModel(std::string const& path)
@@ -77,6 +107,7 @@ private:
 			// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
 			meshes.push_back(ProcessMesh(mesh, scene));
+			compressionStats.add(meshes.back().compressionStats);
 		}
 		// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
 		for (unsigned int i = 0; i < node->mNumChildren; i++)
@@ -132,7 +163,11 @@ private:
 				vertex.vBitangent = vector;
 			}
 			else
+			{
 				vertex.vTexCoords = glm::vec2(0.0f, 0.0f);
+				vertex.vTangent = glm::vec3(0.0f, 0.0f, 0.0f);
+				vertex.vBitangent = glm::vec3(0.0f, 0.0f, 0.0f);
+			}
 
 			vertices.push_back(vertex);
 		}
@@ -167,7 +202,7 @@ private:
 		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
 		// return a mesh object created from the extracted mesh data
-		return Mesh(vertices, indices, textures);
+		return Mesh(vertices, indices, textures, compressVertices);
 	}
 
 	// checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -193,7 +228,13 @@ private:
 			if (!skip)
 			{   // if texture hasn't been loaded already, load it
 				Texture texture;
-				texture.id = TextureFromFile(str.C_Str(), this->directory, gammaCorrection);
+				if (textureStreamer)
+				{
+					texture.id = 0;
+					texture.handle = textureStreamer->load(this->directory + '/' + str.C_Str());
+				}
+				else
+					texture.id = TextureFromFile(str.C_Str(), this->directory, gammaCorrection);
 				texture.type = typeName;
 				texture.path = str.C_Str();
 				textures.push_back(texture);
@@ -224,7 +265,7 @@ unsigned int TextureFromFile(const char* path, const std::string& directory, boo
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -5,6 +5,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "OpenGL_Graphics.h"
+#include "CameraPath.h"
 
 enum class CameraMovement
 {
@@ -51,13 +52,22 @@ public:
 
 	void SetCameraPos(glm::vec3 vPos);
 
-	void UpdateView(Shader shader, const std::string& viewMat4ID);
+	// Position and orientation of the camera. The field of view belongs to the projection and is left as it is.
+	void setPose(const CameraPose& pose);
+	CameraPose getPose() const;
+
+	void UpdateView(Shader& shader, const std::string& viewMat4ID);
 };
 
 void Camera::init(glm::vec3 vPos, glm::vec3 vFront)
 {
 	vCameraPos = vPos;
-	vCameraFront = vFront;
+	vCameraFront = glm::normalize(vFront);
+
+	// Keep the angles in line with the direction, otherwise the next mouse movement snaps back to the old direction
+	fYaw = glm::degrees(atan2f(vCameraFront.z, vCameraFront.x));
+	fPitch = glm::degrees(asinf(vCameraFront.y));
+
 	matView = glm::lookAt(vCameraPos, vCameraPos + vCameraFront, vCameraUp);
 }
 
@@ -144,7 +154,31 @@ void Camera::SetCameraPos(glm::vec3 vPos)
 	vCameraPos = vPos;
 }
 
-void Camera::UpdateView(Shader shader, const std::string& viewMat4ID)
+void Camera::setPose(const CameraPose& pose)
+{
+	vCameraPos = pose.vPos;
+	fYaw = pose.fYaw;
+	fPitch = glm::clamp(pose.fPitch, -89.0f, 89.0f);
+
+	glm::vec3 vDirection;
+	vDirection.x = cosf(glm::radians(fYaw)) * cosf(glm::radians(fPitch));
+	vDirection.y = sinf(glm::radians(fPitch));
+	vDirection.z = sinf(glm::radians(fYaw)) * cosf(glm::radians(fPitch));
+	vCameraFront = glm::normalize(vDirection);
+
+	matView = glm::lookAt(vCameraPos, vCameraPos + vCameraFront, vCameraUp);
+}
+
+CameraPose Camera::getPose() const
+{
+	CameraPose pose;
+	pose.vPos = vCameraPos;
+	pose.fYaw = fYaw;
+	pose.fPitch = fPitch;
+	return pose;
+}
+
+void Camera::UpdateView(Shader& shader, const std::string& viewMat4ID)
 {
 	shader.use();
 	shader.setMat4(viewMat4ID, matView);
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Position, orientation and field of view of the camera at a point in time. Angles are in degrees.
+struct CameraPose
+{
+	float fTime = 0.0f;
+	glm::vec3 vPos = glm::vec3(0.0f);
+	float fYaw = -90.0f;
+	float fPitch = 0.0f;
+	float fFov = 80.0f;
+};
+
+/**
+  * Camera path for benchmarks, made up of poses at increasing times. Positions are interpolated with Catmull-Rom
+  * splines, angles and field of view linearly.
+  *
+  * Paths are stored as text, one pose per line and '#' starting a comment:
+  *
+  *	# time  x  y  z  yaw  pitch  fov
+  *	0.0  128 100 160  -90 -20  80
+  */
+class CameraPath
+{
+private:
+	std::vector<CameraPose> m_Keys;
+
+public:
+	CameraPath() = default;
+
+	bool load(const std::string& filePath);
+	bool save(const std::string& filePath) const;
+
+	// Keys have to be added in the order of their time
+	void addKey(const CameraPose& key);
+
+	// Interpolated pose, clamped to the first and last key
+	CameraPose sample(float fTime) const;
+
+	float getStartTime() const;
+	float getDuration() const;
+	size_t getKeyCount() const;
+	bool empty() const;
+	void clear();
+
+private:
+	static glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t);
+};
+
+bool CameraPath::load(const std::string& filePath)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	m_Keys.clear();
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+
+		CameraPose key;
+		std::istringstream stream(line);
+		if (stream >> key.fTime >> key.vPos.x >> key.vPos.y >> key.vPos.z >> key.fYaw >> key.fPitch >> key.fFov)
+			addKey(key);
+	}
+
+	return !m_Keys.empty();
+}
+
+bool CameraPath::save(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	file << "# time  x  y  z  yaw  pitch  fov\n";
+
+	for (const auto& key : m_Keys)
+	{
+		file << key.fTime << ' ' << key.vPos.x << ' ' << key.vPos.y << ' ' << key.vPos.z << ' '
+			<< key.fYaw << ' ' << key.fPitch << ' ' << key.fFov << '\n';
+	}
+
+	return file.good();
+}
+
+void CameraPath::addKey(const CameraPose& key)
+{
+	// Keys out of order would break the search in sample()
+	if (!m_Keys.empty() && key.fTime <= m_Keys.back().fTime)
+		return;
+
+	m_Keys.push_back(key);
+}
+
+CameraPose CameraPath::sample(float fTime) const
+{
+	if (m_Keys.empty())
+		return CameraPose();
+
+	if (fTime <= m_Keys.front().fTime)
+		return m_Keys.front();
+
+	if (fTime >= m_Keys.back().fTime)
+		return m_Keys.back();
+
+	// First key after fTime
+	auto next = std::upper_bound(m_Keys.begin(), m_Keys.end(), fTime,
+		[](float fTime, const CameraPose& key) { return fTime < key.fTime; });
+
+	const size_t i = (size_t)(next - m_Keys.begin());
+
+	const CameraPose& k1 = m_Keys[i - 1];
+	const CameraPose& k2 = m_Keys[i];
+
+	// The end points are repeated for the outer control points
+	const CameraPose& k0 = m_Keys[i > 1 ? i - 2 : i - 1];
+	const CameraPose& k3 = m_Keys[i + 1 < m_Keys.size() ? i + 1 : i];
+
+	const float t = (fTime - k1.fTime) / (k2.fTime - k1.fTime);
+
+	CameraPose pose;
+	pose.fTime = fTime;
+	pose.vPos = CatmullRom(k0.vPos, k1.vPos, k2.vPos, k3.vPos, t);
+	pose.fYaw = k1.fYaw + (k2.fYaw - k1.fYaw) * t;
+	pose.fPitch = k1.fPitch + (k2.fPitch - k1.fPitch) * t;
+	pose.fFov = k1.fFov + (k2.fFov - k1.fFov) * t;
+
+	return pose;
+}
+
+float CameraPath::getStartTime() const
+{
+	return m_Keys.empty() ? 0.0f : m_Keys.front().fTime;
+}
+
+float CameraPath::getDuration() const
+{
+	return m_Keys.empty() ? 0.0f : m_Keys.back().fTime - m_Keys.front().fTime;
+}
+
+size_t CameraPath::getKeyCount() const
+{
+	return m_Keys.size();
+}
+
+bool CameraPath::empty() const
+{
+	return m_Keys.empty();
+}
+
+void CameraPath::clear()
+{
+	m_Keys.clear();
+}
+
+// Private utility function - point between p1 (t = 0) and p2 (t = 1)
+glm::vec3 CameraPath::CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	const float t2 = t * t;
+	const float t3 = t2 * t;
+
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
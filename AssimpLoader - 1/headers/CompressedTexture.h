@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "TextureCache.h"
+
+#include <cstring>
+
+// S3TC comes from EXT_texture_compression_s3tc, which every desktop driver has, but the loader only covers core 3.3
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Uploads block compressed textures read from the texture cache (see TextureCache.h)
+class CompressedTexture
+{
+public:
+	// Whether the driver can sample 'format'. BC4 and BC5 are core, BC1 and BC3 need S3TC. Call on the GL thread.
+	static bool isSupported(TextureCompression format);
+
+	static GLenum getInternalFormat(TextureCompression format);
+
+	// Uploads the levels [firstLevel, firstLevel + levelCount) of 'view' into the texture bound to GL_TEXTURE_2D
+	static void uploadLevels(const TextureFileView& view, uint32_t firstLevel, uint32_t levelCount);
+
+	// Uploads every level of 'view' into the texture bound to GL_TEXTURE_2D, and limits sampling to them
+	static void upload(const TextureFileView& view);
+
+private:
+	static bool HasExtension(const char* name);
+};
+
+bool CompressedTexture::isSupported(TextureCompression format)
+{
+	if (format == TextureCompression::BC4 || format == TextureCompression::BC5)
+		return true;
+
+	static const bool bS3TC = HasExtension("GL_EXT_texture_compression_s3tc");
+	return bS3TC;
+}
+
+GLenum CompressedTexture::getInternalFormat(TextureCompression format)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+	case TextureCompression::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	case TextureCompression::BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+
+	case TextureCompression::BC5:
+	default:
+		return GL_COMPRESSED_RG_RGTC2;
+	}
+}
+
+void CompressedTexture::uploadLevels(const TextureFileView& view, uint32_t firstLevel, uint32_t levelCount)
+{
+	const GLenum internalFormat = getInternalFormat(view.format());
+
+	for (uint32_t level = firstLevel; level < firstLevel + levelCount && level < view.levelCount(); level++)
+	{
+		uint32_t width, height;
+		size_t bytes;
+		const void* data = view.level(level, width, height, bytes);
+
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, internalFormat, (GLsizei)width, (GLsizei)height, 0, (GLsizei)bytes, data);
+	}
+}
+
+void CompressedTexture::upload(const TextureFileView& view)
+{
+	uploadLevels(view, 0, view.levelCount());
+
+	// The file may stop before 1x1, the texture would be incomplete if the missing levels were sampled
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)view.levelCount() - 1);
+}
+
+// Private utility function - looks 'name' up in the extensions of the current context
+bool CompressedTexture::HasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
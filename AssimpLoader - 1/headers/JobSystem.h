@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+  * Multi-producer, single-consumer queue of callbacks which doesn't use any locks (Vyukov's intrusive MPSC queue).
+  * Any thread may push, only one thread (the GL thread) may pop.
+  */
+class CompletionQueue
+{
+private:
+	struct Node
+	{
+		std::atomic<Node*> next{ nullptr };
+		std::function<void()> callback;
+	};
+
+	// Producers append at the head, the consumer removes from the tail. The stub node keeps the list non-empty.
+	std::atomic<Node*> m_Head;
+	Node* m_Tail;
+	Node m_Stub;
+
+public:
+	CompletionQueue() : m_Head(&m_Stub), m_Tail(&m_Stub)
+	{}
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	void push(std::function<void()> callback);
+
+	// Returns false if the queue is empty, or if the only remaining push is still in progress
+	bool pop(std::function<void()>& callback);
+
+	~CompletionQueue();
+
+private:
+	void PushNode(Node* node);
+};
+
+void CompletionQueue::push(std::function<void()> callback)
+{
+	Node* node = new Node;
+	node->callback = std::move(callback);
+
+	PushNode(node);
+}
+
+bool CompletionQueue::pop(std::function<void()>& callback)
+{
+	Node* tail = m_Tail;
+	Node* next = tail->next.load(std::memory_order_acquire);
+
+	// Skip the stub node
+	if (tail == &m_Stub)
+	{
+		if (!next)
+			return false;
+
+		m_Tail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next)
+	{
+		m_Tail = next;
+		callback = std::move(tail->callback);
+		delete tail;
+		return true;
+	}
+
+	// A producer has swapped the head but not linked its node yet
+	if (tail != m_Head.load(std::memory_order_acquire))
+		return false;
+
+	// 'tail' is the last node, put the stub behind it so that it can be removed
+	PushNode(&m_Stub);
+
+	next = tail->next.load(std::memory_order_acquire);
+	if (next)
+	{
+		m_Tail = next;
+		callback = std::move(tail->callback);
+		delete tail;
+		return true;
+	}
+
+	return false;
+}
+
+CompletionQueue::~CompletionQueue()
+{
+	std::function<void()> callback;
+	while (pop(callback))
+		;
+}
+
+// Private utility function - to link a node in at the head
+void CompletionQueue::PushNode(Node* node)
+{
+	node->next.store(nullptr, std::memory_order_relaxed);
+
+	Node* prev = m_Head.exchange(node, std::memory_order_acq_rel);
+	prev->next.store(node, std::memory_order_release);
+}
+
+/**
+  * Pool of worker threads for CPU-side asset work (chunk generation and meshing, OBJ parsing, image decoding).
+  *
+  * Every worker has its own queue. A worker takes the newest job from its own queue and, once that is empty, steals
+  * the oldest job from another worker's queue, so the load stays balanced without a single contended queue.
+  *
+  * Jobs which produce data for OpenGL are submitted with a completion callback. The completion is pushed into a
+  * lock-free queue when the job finishes and runs on the GL thread inside processCompleted(), so the render loop
+  * never waits for a job; it only picks up what is already done.
+  */
+class JobSystem
+{
+private:
+	using Job = std::function<void()>;
+
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_Workers;
+	std::vector<std::thread> m_Threads;
+
+	std::atomic<bool> m_bRunning{ false };
+
+	// Jobs waiting in the worker queues
+	std::atomic<size_t> m_QueuedJobs{ 0 };
+
+	// Jobs submitted whose work or completion hasn't finished yet
+	std::atomic<size_t> m_PendingJobs{ 0 };
+
+	// Round-robin target for jobs submitted from outside the pool
+	std::atomic<size_t> m_NextWorker{ 0 };
+
+	// Idle workers sleep on this
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+
+	CompletionQueue m_Completed;
+
+	// Index of the worker running on the current thread, -1 on other threads
+	inline static thread_local int t_WorkerIndex = -1;
+	inline static thread_local const JobSystem* t_JobSystem = nullptr;
+
+public:
+	JobSystem() = default;
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Starts the workers. By default one per hardware thread, minus the render and the event thread.
+	void init(unsigned int threadCount = 0);
+
+	// Stops the workers. Jobs which haven't started and completions which haven't run are dropped.
+	void shutdown();
+
+	// Runs 'job' on a worker
+	void submit(Job job);
+
+	/**
+	  * Runs 'work' on a worker, then 'complete' on the thread calling processCompleted(). Both get the same
+	  * default-constructed T, which carries the result from one to the other.
+	  */
+	template<typename T>
+	void submit(std::function<void(T&)> work, std::function<void(T&)> complete);
+
+	// Runs finished completions until there are none left or 'fBudgetMs' has passed. Call once per frame on the GL thread.
+	int processCompleted(float fBudgetMs = 2.0f);
+
+	// Number of jobs whose work or completion hasn't run yet
+	size_t getPendingCount() const;
+
+	unsigned int getThreadCount() const;
+
+	~JobSystem();
+
+private:
+	void Push(Job job);
+	bool Pop(int workerIndex, Job& job);
+	void WorkerThread(int workerIndex);
+};
+
+void JobSystem::init(unsigned int threadCount)
+{
+	shutdown();
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 2 : 1u);
+
+	m_bRunning = true;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_Workers.push_back(std::make_unique<Worker>());
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_Threads.emplace_back(&JobSystem::WorkerThread, this, (int)i);
+}
+
+void JobSystem::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_bRunning = false;
+	}
+
+	m_WakeCondition.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		if (thread.joinable())
+			thread.join();
+	}
+
+	m_Threads.clear();
+	m_Workers.clear();
+
+	// Drop the completions, whatever they refer to may be destroyed after this
+	std::function<void()> callback;
+	while (m_Completed.pop(callback))
+		;
+
+	m_QueuedJobs = 0;
+	m_PendingJobs = 0;
+}
+
+void JobSystem::submit(Job job)
+{
+	m_PendingJobs++;
+
+	Push([this, job = std::move(job)]()
+	{
+		job();
+		m_PendingJobs--;
+	});
+}
+
+template<typename T>
+void JobSystem::submit(std::function<void(T&)> work, std::function<void(T&)> complete)
+{
+	auto result = std::make_shared<T>();
+
+	m_PendingJobs++;
+
+	Push([this, result, work = std::move(work), complete = std::move(complete)]()
+	{
+		work(*result);
+
+		// m_PendingJobs is decremented in processCompleted(), after the completion ran
+		m_Completed.push([result, complete]() { complete(*result); });
+	});
+}
+
+int JobSystem::processCompleted(float fBudgetMs)
+{
+	const auto start = std::chrono::steady_clock::now();
+	int count = 0;
+
+	std::function<void()> callback;
+	while (m_Completed.pop(callback))
+	{
+		callback();
+		m_PendingJobs--;
+		count++;
+
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= fBudgetMs)
+			break;
+	}
+
+	return count;
+}
+
+size_t JobSystem::getPendingCount() const
+{
+	return m_PendingJobs;
+}
+
+unsigned int JobSystem::getThreadCount() const
+{
+	return (unsigned int)m_Threads.size();
+}
+
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+// Private utility function - jobs submitted by a worker go into its own queue, others are spread over all workers
+void JobSystem::Push(Job job)
+{
+	if (m_Workers.empty())
+	{
+		// Not initialized, run the job right away
+		job();
+		return;
+	}
+
+	const size_t workerIndex = (t_JobSystem == this && t_WorkerIndex >= 0) ? (size_t)t_WorkerIndex : m_NextWorker++ % m_Workers.size();
+
+	Worker& worker = *m_Workers[workerIndex];
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.jobs.push_back(std::move(job));
+	}
+
+	{
+		// Under the lock, so that a worker which is about to sleep can't miss the new job
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_QueuedJobs++;
+	}
+
+	m_WakeCondition.notify_one();
+}
+
+// Private utility function - newest job of the worker's own queue, otherwise the oldest job of another worker
+bool JobSystem::Pop(int workerIndex, Job& job)
+{
+	const size_t workerCount = m_Workers.size();
+
+	for (size_t i = 0; i < workerCount; i++)
+	{
+		Worker& worker = *m_Workers[(workerIndex + i) % workerCount];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.jobs.empty())
+			continue;
+
+		if (i == 0)
+		{
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+		}
+
+		else
+		{
+			job = std::move(worker.jobs.front());
+			worker.jobs.pop_front();
+		}
+
+		m_QueuedJobs--;
+		return true;
+	}
+
+	return false;
+}
+
+// Private utility function - main loop of a worker
+void JobSystem::WorkerThread(int workerIndex)
+{
+	t_WorkerIndex = workerIndex;
+	t_JobSystem = this;
+
+	while (m_bRunning)
+	{
+		Job job;
+		if (Pop(workerIndex, job))
+		{
+			job();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+		m_WakeCondition.wait(lock, [this]() { return !m_bRunning || m_QueuedJobs > 0; });
+	}
+
+	t_WorkerIndex = -1;
+	t_JobSystem = nullptr;
+}
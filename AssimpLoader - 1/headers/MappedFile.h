@@ -0,0 +1,206 @@
+#pragma once
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+  * Read-only view of a whole file.
+  *
+  * The file is memory-mapped when the platform supports it, so its contents are paged in by the OS
+  * as they are accessed instead of being copied into a buffer first. If mapping fails, the file is
+  * read into memory with a regular stream instead. Either way, data() and size() behave the same.
+  */
+class MappedFile
+{
+private:
+	const char* m_Data = nullptr;
+	size_t m_Size = 0;
+
+	// Used when the file could not be mapped
+	std::vector<char> m_Buffer;
+
+#ifdef _WIN32
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = NULL;
+#else
+	void* m_Mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Opens the file, returns false if it does not exist or can't be read
+	bool open(const std::string& filePath);
+
+	void close();
+
+	const char* data() const;
+	size_t size() const;
+
+	bool isMapped() const;
+
+	~MappedFile();
+
+private:
+	bool map(const std::string& filePath);
+	bool read(const std::string& filePath);
+};
+
+bool MappedFile::open(const std::string& filePath)
+{
+	close();
+
+	if (map(filePath))
+		return true;
+
+	return read(filePath);
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_Mapping)
+	{
+		UnmapViewOfFile(m_Data);
+		CloseHandle(m_Mapping);
+		m_Mapping = NULL;
+	}
+
+	if (m_File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_Mapping)
+	{
+		munmap(m_Mapping, m_Size);
+		m_Mapping = nullptr;
+	}
+#endif
+
+	m_Buffer.clear();
+	m_Buffer.shrink_to_fit();
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+const char* MappedFile::data() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::size() const
+{
+	return m_Size;
+}
+
+bool MappedFile::isMapped() const
+{
+#ifdef _WIN32
+	return m_Mapping != NULL;
+#else
+	return m_Mapping != nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+// Private utility function - to map the file into memory
+bool MappedFile::map(const std::string& filePath)
+{
+#ifdef _WIN32
+	m_File = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_Mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_Data = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_Data)
+	{
+		close();
+		return false;
+	}
+
+	m_Size = (size_t)size.QuadPart;
+	return true;
+#else
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping stays valid after the file descriptor is closed
+	::close(fd);
+
+	if (mapping == MAP_FAILED)
+		return false;
+
+	madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	m_Mapping = mapping;
+	m_Data = (const char*)mapping;
+	m_Size = (size_t)st.st_size;
+	return true;
+#endif
+}
+
+// Private utility function - fallback which reads the whole file into memory
+bool MappedFile::read(const std::string& filePath)
+{
+	std::ifstream stream(filePath, std::ios::binary | std::ios::ate);
+	if (!stream.is_open())
+		return false;
+
+	m_Buffer.resize((size_t)stream.tellg());
+	stream.seekg(0);
+	stream.read(m_Buffer.data(), (std::streamsize)m_Buffer.size());
+
+	m_Data = m_Buffer.data();
+	m_Size = m_Buffer.size();
+	return true;
+}
@@ -6,6 +6,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Shader.h"
+#include "TextureStreamer.h"
+#include "VertexCompression.h"
 
 #include <iostream>
 #include <vector>
@@ -26,15 +28,33 @@ struct Vertex {
     // Bitangents
     glm::vec3 vBitangent;
     // Bone indexes which will influence this vertex
-    int m_BoneIDs[MAX_BONE_INFLUENCE];
-    // Weights from each bone
-    float m_Weights[MAX_BONE_INFLUENCE];
+    int m_BoneIDs[MAX_BONE_INFLUENCE] = {};
+    // Weights from each bone, all 0 if the vertex isn't skinned
+    float m_Weights[MAX_BONE_INFLUENCE] = {};
+};
+
+template<>
+struct VertexFormat<Vertex> {
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        VertexAttribute::of<glm::vec3>(0, offsetof(Vertex, vPosition)),
+        VertexAttribute::of<glm::vec3>(1, offsetof(Vertex, vNormal)),
+        VertexAttribute::of<glm::vec2>(2, offsetof(Vertex, vTexCoords)),
+        VertexAttribute::of<glm::vec3>(3, offsetof(Vertex, vTangent)),
+        VertexAttribute::of<glm::vec3>(4, offsetof(Vertex, vBitangent)),
+        // Read as ivec4 by the shader
+        VertexAttribute::of<glm::ivec4>(5, offsetof(Vertex, m_BoneIDs), AttributeMode::INTEGER),
+        VertexAttribute::of<glm::vec4>(6, offsetof(Vertex, m_Weights))
+    };
 };
 
 struct Texture {
     unsigned int id;
     std::string type;
     std::string path;
+    // Set if the texture is streamed, 'id' is unused then
+    TextureHandle handle;
+
+    unsigned int getID() const { return handle ? handle.getID() : id; }
 };
 
 class Mesh {
@@ -45,15 +65,22 @@ public:
     std::vector<Texture>      textures;
     unsigned int VAO;
 
-    // Constructor
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+    // Maps the vertices of a compressed mesh back to model space, identity otherwise
+    VertexDecode decode;
+    VertexCompressionStats compressionStats;
+
+    // Constructor, uploads CompressedVertex instead of Vertex if 'bCompress' is set (see VertexCompression.h)
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, bool bCompress = false)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
 
         // Set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (bCompress)
+            setupCompressedMesh();
+        else
+            setupMesh();
     }
 
     // Render the mesh
@@ -71,7 +98,7 @@ public:
 
         for (unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // Active proper texture unit before binding
+            GLState::get().activeTexture(i); // Active proper texture unit before binding
             // Retrieve texture number (the N in diffuse_textureN)
 
             name = textures[i].type;
@@ -89,7 +116,7 @@ public:
             glUniform1i(glGetUniformLocation(shader.id, (name + number).c_str()), i);
 
             // And finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            GLState::get().bindTexture(GL_TEXTURE_2D, textures[i].getID());
         }
 #endif
         
@@ -100,7 +127,7 @@ public:
 
         for (unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // Active proper texture unit before binding
+            GLState::get().activeTexture(i); // Active proper texture unit before binding
             // Retrieve texture number (the N in diffuse_textureN)
 
             strcpy_s(name, static_cast<rsize_t>(MAX_SIZE)-1, textures[i].type.c_str());
@@ -124,18 +151,29 @@ public:
             glUniform1i(glGetUniformLocation(shader.id, name), i);
 
             // And finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            GLState::get().bindTexture(GL_TEXTURE_2D, textures[i].getID());
         }
 #endif
+        // Positions and texture coordinates of compressed meshes are decoded by the vertex shader
+        decode.apply(shader);
+
         // Bind vertex array
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
 
         // Draw mesh
         glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
         
         // Always good practice to set everything back to defaults once configured.
-        glBindVertexArray(0);
-        glActiveTexture(GL_TEXTURE0);
+        GLState::get().bindVertexArray(0);
+        GLState::get().activeTexture(0);
+    }
+
+    // Deletes the buffer objects/arrays
+    void free()
+    {
+        GLState::get().deleteVertexArrays(1, &VAO);
+        GLState::get().deleteBuffers(1, &VBO);
+        GLState::get().deleteBuffers(1, &EBO);
     }
 
 private:
@@ -150,37 +188,102 @@ private:
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
         // Load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        GLState::get().bindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
-        // Set the vertex attribute pointers
-        // Vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // Vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, vNormal));
-        // Vertex texture coordinates
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, vTexCoords));
-        // Vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, vTangent));
-        // Vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, vBitangent));
-        // IDs
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-        // Weights
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        // Set the vertex attribute pointers, see VertexFormat<Vertex>
+        VertexLayout::apply<Vertex>(VAO, VBO);
+
+        GLState::get().bindVertexArray(0);
+    }
+
+    // Same as above, with CompressedVertex and the bone attributes in a second stream if any vertex has bones
+    void setupCompressedMesh()
+    {
+        // Bounds of the positions and texture coordinates, which the compressed values are relative to
+        glm::vec3 vMinPosition(0.0f), vMaxPosition(0.0f);
+        glm::vec2 vMinTexCoord(0.0f), vMaxTexCoord(0.0f);
+        bool bSkinned = false;
+
+        if (!vertices.empty())
+        {
+            vMinPosition = vMaxPosition = vertices[0].vPosition;
+            vMinTexCoord = vMaxTexCoord = vertices[0].vTexCoords;
+        }
+
+        for (const Vertex& vertex : vertices)
+        {
+            vMinPosition = glm::min(vMinPosition, vertex.vPosition);
+            vMaxPosition = glm::max(vMaxPosition, vertex.vPosition);
+            vMinTexCoord = glm::min(vMinTexCoord, vertex.vTexCoords);
+            vMaxTexCoord = glm::max(vMaxTexCoord, vertex.vTexCoords);
+
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+                bSkinned = bSkinned || vertex.m_Weights[i] > 0.0f;
+        }
+
+        decode = VertexDecode::fromBounds(vMinPosition, vMaxPosition, vMinTexCoord, vMaxTexCoord);
+
+        std::vector<CompressedVertex> compressed(vertices.size());
+        std::vector<SkinVertex> skin(bSkinned ? vertices.size() : 0);
+
+        compressionStats.vertexCount = vertices.size();
+        compressionStats.rawBytes = vertices.size() * sizeof(Vertex);
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex& vertex = vertices[i];
+
+            // The sign of the bitangent against cross(normal, tangent), so that the shader can rebuild it
+            float fHandedness = glm::dot(glm::cross(vertex.vNormal, vertex.vTangent), vertex.vBitangent) < 0.0f ? -1.0f : 1.0f;
+
+            compressed[i].position = decode.encodePosition(vertex.vPosition);
+            compressed[i].normal = Packed1010102::packDirection(vertex.vNormal);
+            compressed[i].tangent = Packed1010102::packDirection(vertex.vTangent, fHandedness);
+            compressed[i].texCoords = decode.encodeTexCoords(vertex.vTexCoords);
+
+            compressionStats.fMaxPositionError = std::max(compressionStats.fMaxPositionError, glm::length(decode.decodePosition(compressed[i].position) - vertex.vPosition));
+
+            if (bSkinned)
+            {
+                for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+                {
+                    skin[i].boneIDs[j] = (int16_t)vertex.m_BoneIDs[j];
+                    skin[i].weights[j] = (uint8_t)(std::clamp(vertex.m_Weights[j], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+
+        const size_t compressedBytes = compressed.size() * sizeof(CompressedVertex);
+        const size_t skinBytes = skin.size() * sizeof(SkinVertex);
+        compressionStats.compressedBytes = compressedBytes + skinBytes;
+
+        // Create buffers/arrays
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        GLState::get().bindVertexArray(VAO);
+        // Both streams go into the same buffer, the bone attributes after the vertices
+        GLState::get().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, compressedBytes + skinBytes, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, compressedBytes, compressed.data());
+        if (bSkinned)
+            glBufferSubData(GL_ARRAY_BUFFER, compressedBytes, skinBytes, skin.data());
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+
+        // Set the vertex attribute pointers, see VertexFormat<CompressedVertex> and VertexFormat<SkinVertex>
+        VertexLayout::apply<CompressedVertex>(VAO, VBO);
+        if (bSkinned)
+            VertexLayout::apply<SkinVertex>(VAO, VBO, compressedBytes);
+
+        GLState::get().bindVertexArray(0);
     }
 };
\ No newline at end of file
@@ -4,11 +4,22 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
 #include <thread>
 #include <atomic>
 #include <chrono>
 #include <mutex>
 
+#include "Profiler.h"
+#include "GLState.h"
+#include "CameraPath.h"
+
 std::mutex mtx;
 
 class OpenGL_Graphics
@@ -17,25 +28,61 @@ private:
 	int m_width;
 	int m_height;
 	std::string m_sAppName;
+	std::string m_sTitleInfo;
 
 	short m_keyNewState[348] = { 0 };
 	short m_keyOldState[348] = { 0 };
-	short m_mouseOldState[3];
-	short m_mouseNewState[3];
+	short m_mouseOldState[3] = { 0 };
+	short m_mouseNewState[3] = { 0 };
 	struct sKeyState
 	{
 		bool bPressed;
 		bool bReleased;
 		bool bHeld;
-	} m_keys[348], m_mouse[3];
+	} m_keys[348] = {}, m_mouse[3] = {};
 
-	float m_mousePosX;
-	float m_mousePosY;
-	int m_mouseScroll;
+	float m_mousePosX = 0.0f;
+	float m_mousePosY = 0.0f;
+	int m_mouseScroll = 0;
 	bool m_bMouseButtonHeld[3] = { false };
 
 	static std::atomic<bool> m_bIsRunning;
 
+	// Frame timings, written to <m_sProfilePath>.csv and .json when the renderer thread exits. Interactive runs only
+	// write them if a path was given (see SetProfileOutput()), headless and benchmark runs always do.
+	Profiler m_Profiler;
+	std::string m_sProfilePath = "profile";
+	bool m_bWriteProfile = false;
+
+	// With a frame limit (headless and benchmark runs), every frame advances the time by a fixed step
+	int m_nFrameLimit = 0;
+	int m_nFrame = 0;
+	float m_fFixedTimeStep = 1.0f / 60.0f;
+
+	// Headless and benchmark runs give up if the scene still isn't ready (see IsReady()) after this many seconds
+	float m_fReadyTimeout = 60.0f;
+	bool m_bTimedOut = false;
+
+	// Headless mode: no visible window, the frames are rendered into m_Framebuffer
+	bool m_bHeadless = false;
+	std::string m_sCapturePrefix;
+
+	// Benchmark mode: the camera follows m_CameraPath
+	bool m_bBenchmark = false;
+	CameraPath m_CameraPath;
+
+	// The camera of interactive runs is recorded into m_RecordedPath and saved to m_sRecordPath
+	std::string m_sRecordPath;
+	CameraPath m_RecordedPath;
+	float m_fLastRecordTime = -1.0f;
+
+	// Options of the demo itself, see ParseArguments()
+	std::map<std::string, std::string> m_Options;
+
+	unsigned int m_Framebuffer = 0;
+	unsigned int m_ColorBuffer = 0;
+	unsigned int m_DepthBuffer = 0;
+
 protected:
 	GLFWwindow* window;
 
@@ -62,11 +109,14 @@ private:
 		float fAccumulatedTime = 0.0f;
 		int iFrameCount = 0;
 
+		m_Profiler.init();
+
 		if (!Setup())
 			m_bIsRunning = false;
 
 		auto dt1 = std::chrono::system_clock::now();
 		auto dt2 = std::chrono::system_clock::now();
+		const auto tLoopStart = dt1;
 
 		// Run as fast as possible
 		while (m_bIsRunning)
@@ -76,8 +126,34 @@ private:
 			dt1 = dt2;
 
 			float fElapsedTime = elapsedTime.count();
+
+			// Time stands still until the scene has loaded, so every run renders the same frames
+			bool bCountFrame = false;
+			if (m_nFrameLimit > 0)
+			{
+				bCountFrame = IsReady();
+				fElapsedTime = bCountFrame ? m_fFixedTimeStep : 0.0f;
+
+				// Timings taken while loading would skew the results
+				if (bCountFrame && m_nFrame == 0)
+					m_Profiler.reset();
+
+				// Otherwise a scene which never finishes loading (e.g. a missing file) would keep the run going forever
+				std::chrono::duration<float> waitTime = dt2 - tLoopStart;
+				if (!bCountFrame && m_nFrame == 0 && waitTime.count() > m_fReadyTimeout)
+				{
+					std::cerr << "Error: the scene wasn't ready after " << m_fReadyTimeout << " seconds" << std::endl;
+					m_bTimedOut = true;
+					m_bIsRunning = false;
+				}
+			}
+
 			fTimeSinceStart += fElapsedTime;
 
+			m_Profiler.beginFrame();
+			GLState::get().beginFrame();
+			m_Profiler.beginCpu("Input");
+
 			// Keyboard inputs
 			for (int i = 0; i < 348; i++)
 			{
@@ -127,11 +203,28 @@ private:
 				}
 			}
 
+			m_Profiler.endCpu("Input");
+
+			m_Profiler.beginCpu("Update");
+			m_Profiler.beginGpu("Frame");
+
 			if (!Update(fElapsedTime))
 			{
 				m_bIsRunning = false;
 			}
 
+			m_Profiler.endGpu("Frame");
+			m_Profiler.endCpu("Update");
+
+			if (bCountFrame)
+			{
+				if (!m_sCapturePrefix.empty())
+					CaptureFrame(m_sCapturePrefix + FrameNumber(m_nFrame) + ".tga");
+
+				if (++m_nFrame >= m_nFrameLimit)
+					m_bIsRunning = false;
+			}
+
 			// FPS calculation
 			iFrameCount++;
 			fAccumulatedTime += fElapsedTime;
@@ -143,8 +236,12 @@ private:
 				
 				if (window)
 				{
-					char s[32];
-					sprintf_s(s, 32, "%s : %d FPS", m_sAppName.c_str(), fps);
+					Profiler::Stats frame = m_Profiler.getFrameStats();
+					const GLState::Stats& calls = GLState::get().getFrameStats();
+
+					char s[512];
+					sprintf_s(s, 512, "%s : %d FPS | p50 %.2f p95 %.2f p99 %.2f ms | GL calls %zu (%zu avoided)%s", m_sAppName.c_str(), fps,
+						frame.fP50, frame.fP95, frame.fP99, calls.callsIssued, calls.callsAvoided, m_sTitleInfo.c_str());
 					glfwSetWindowTitle(window, s);
 				}
 
@@ -157,11 +254,49 @@ private:
 			m_mouse[2].bReleased = false;
 
 			// Swap buffers
+			m_Profiler.beginCpu("Swap");
 			glfwSwapBuffers(window);
+			m_Profiler.endCpu("Swap");
+
+			m_Profiler.endFrame();
+		}
+
+		// The GPU timings need the context, so they are resolved and reported here rather than in Destroy()
+		m_Profiler.resolve();
+		std::cout << "\n---------- Frame timings ----------\n\n" << m_Profiler.getSummary() << std::endl;
+
+		const GLState::Stats calls = GLState::get().getAverageStats();
+		std::cout << "State changes per frame: " << calls.callsIssued << " GL calls made, " << calls.callsAvoided << " redundant ones avoided\n" << std::endl;
+
+		if (m_bWriteProfile || m_bHeadless || m_bBenchmark)
+		{
+			if (!m_Profiler.writeCSV(m_sProfilePath + ".csv") || !m_Profiler.writeJSON(m_sProfilePath + ".json"))
+				std::cerr << "Failed to write the frame timings to " << m_sProfilePath << ".csv/.json" << std::endl;
+		}
+
+		m_Profiler.free();
+
+		if (!m_sRecordPath.empty())
+		{
+			if (m_RecordedPath.save(m_sRecordPath))
+				std::cout << "Camera path with " << m_RecordedPath.getKeyCount() << " keys saved to " << m_sRecordPath << std::endl;
+			else
+				std::cerr << "Failed to save the camera path to " << m_sRecordPath << std::endl;
+		}
+
+		if (m_Framebuffer)
+		{
+			glDeleteFramebuffers(1, &m_Framebuffer);
+			glDeleteRenderbuffers(1, &m_ColorBuffer);
+			glDeleteRenderbuffers(1, &m_DepthBuffer);
+			m_Framebuffer = m_ColorBuffer = m_DepthBuffer = 0;
 		}
 
 		// Give the window context back to the main thread
 		glfwMakeContextCurrent(nullptr);
+
+		// Wakes the main thread up if the loop ended by itself (e.g. at the frame limit)
+		glfwPostEmptyEvent();
 	}
 
 public:
@@ -173,6 +308,147 @@ public:
 	sKeyState GetMouseButton(Mouse button) const { return m_mouse[(int)button]; }
 	sKeyState GetKey(int nKeyID) const { return m_keys[nKeyID]; }
 
+	// Extra text shown after the FPS counter in the window title (e.g. statistics). Call from the renderer thread.
+	void SetTitleInfo(const std::string& info) { m_sTitleInfo = info; }
+
+	// Named CPU/GPU sections can be added with ScopedCpuTimer/ScopedGpuTimer. Call from the renderer thread.
+	Profiler& GetProfiler() { return m_Profiler; }
+
+	// Writes the timing reports to 'path' without extension ("profile" for headless and benchmark runs). Call before Start().
+	void SetProfileOutput(const std::string& path)
+	{
+		m_sProfilePath = path;
+		m_bWriteProfile = true;
+	}
+
+	/**
+	  * Renders 'nFrames' frames into an offscreen framebuffer instead of a window and then exits. Every frame
+	  * advances the time by 'fFixedTimeStep' seconds, so runs are reproducible. If 'capturePrefix' isn't empty, the
+	  * frames are written to <capturePrefix>0000.tga, <capturePrefix>0001.tga, ... Call before ConstructWindow().
+	  */
+	void SetHeadless(int nFrames, float fFixedTimeStep = 1.0f / 60.0f, const std::string& capturePrefix = "")
+	{
+		m_bHeadless = true;
+		m_nFrameLimit = nFrames > 0 ? nFrames : std::max(m_nFrameLimit, 1);
+		m_fFixedTimeStep = fFixedTimeStep;
+		m_sCapturePrefix = capturePrefix;
+	}
+
+	bool IsHeadless() const { return m_bHeadless; }
+
+	/**
+	  * Replays the camera path in 'pathFile' (see CameraPath) with a fixed time step, for 'nFrames' frames or, if that
+	  * is 0, until the end of the path. The frame timings cover only these frames. Call before ConstructWindow().
+	  */
+	bool SetBenchmark(const std::string& pathFile, int nFrames = 0, float fFixedTimeStep = 1.0f / 60.0f)
+	{
+		if (!m_CameraPath.load(pathFile))
+		{
+			std::cerr << "Failed to load the camera path " << pathFile << std::endl;
+			return false;
+		}
+
+		m_bBenchmark = true;
+		m_fFixedTimeStep = fFixedTimeStep;
+		m_nFrameLimit = nFrames > 0 ? nFrames : (int)ceilf(m_CameraPath.getDuration() / fFixedTimeStep) + 1;
+
+		m_Profiler.setLabel(pathFile);
+		return true;
+	}
+
+	bool IsBenchmark() const { return m_bBenchmark; }
+
+	// Value of a demo option given to ParseArguments(), 'defaultValue' if it wasn't given
+	std::string GetOption(const std::string& name, const std::string& defaultValue = "") const
+	{
+		auto it = m_Options.find(name);
+		return it != m_Options.end() ? it->second : defaultValue;
+	}
+
+	// Pose of the benchmark camera in the current frame. Returns false if this isn't a benchmark run.
+	bool GetBenchmarkPose(CameraPose& pose) const
+	{
+		if (!m_bBenchmark)
+			return false;
+
+		pose = m_CameraPath.sample(m_CameraPath.getStartTime() + m_nFrame * m_fFixedTimeStep);
+		return true;
+	}
+
+	// Adds the camera to the recorded path (at most 30 keys per second) if --record was given. Call once per frame.
+	void RecordCameraPose(const CameraPose& pose)
+	{
+		if (m_sRecordPath.empty())
+			return;
+
+		CameraPose key = pose;
+		key.fTime = fTimeSinceStart;
+
+		if (key.fTime >= m_fLastRecordTime + 1.0f / 30.0f)
+		{
+			m_RecordedPath.addKey(key);
+			m_fLastRecordTime = key.fTime;
+		}
+	}
+
+	/**
+	  * Reads the options shared by all demos. Call before ConstructWindow().
+	  *	--headless <frames>		render <frames> frames offscreen, see SetHeadless()
+	  *	--benchmark <path>		replay a camera path, see SetBenchmark()
+	  *	--frames <frames>		number of benchmark frames (the length of the path by default)
+	  *	--timestep <seconds>	time step of headless and benchmark frames (1/60 by default)
+	  *	--timeout <seconds>		how long headless and benchmark runs wait for the scene to load (60 by default)
+	  *	--capture <prefix>		write headless frames to <prefix>NNNN.tga
+	  *	--record <path>			save the camera's path, to be replayed with --benchmark
+	  *	--profile <path>		write the timing reports to <path>.csv and <path>.json
+	  *
+	  * Options of the demo are listed in 'demoOptions' and read back with GetOption().
+	  */
+	void ParseArguments(int argc, char* argv[], const std::vector<std::string>& demoOptions = {})
+	{
+		int nFrames = 0;
+		bool bHeadless = false;
+		float fTimeStep = 1.0f / 60.0f;
+		std::string capturePrefix;
+		std::string benchmarkPath;
+
+		for (int i = 1; i + 1 < argc; i += 2)
+		{
+			const std::string option = argv[i];
+			const char* value = argv[i + 1];
+
+			if (option == "--headless")
+			{
+				bHeadless = true;
+				nFrames = atoi(value);
+			}
+			else if (option == "--benchmark")
+				benchmarkPath = value;
+			else if (option == "--frames")
+				nFrames = atoi(value);
+			else if (option == "--record")
+				m_sRecordPath = value;
+			else if (option == "--timestep")
+				fTimeStep = (float)atof(value);
+			else if (option == "--timeout")
+				m_fReadyTimeout = (float)atof(value);
+			else if (option == "--capture")
+				capturePrefix = value;
+			else if (option == "--profile")
+				SetProfileOutput(value);
+			else if (std::find(demoOptions.begin(), demoOptions.end(), option) != demoOptions.end())
+				m_Options[option] = value;
+			else
+				std::cerr << "Unknown option: " << option << std::endl;
+		}
+
+		if (!benchmarkPath.empty() && !SetBenchmark(benchmarkPath, nFrames, fTimeStep))
+			exit(-1);
+
+		if (bHeadless)
+			SetHeadless(nFrames, fTimeStep, capturePrefix);
+	}
+
 	OpenGL_Graphics()
 	{
 		window = NULL;
@@ -189,29 +465,35 @@ public:
 		m_width = width;
 		m_height = height;
 		
-		// Initalize GLFW and initalize OpenGL to version 3.3
-		glfwInit();
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-		
-		// Make the window non-resizable
-		glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+		if (m_bHeadless)
+		{
+			CreateHeadlessWindow();
+		}
+		else
+		{
+			// Initalize GLFW and initalize OpenGL to version 3.3
+			glfwInit();
+			SetContextHints();
+
+			// Create a window
+			window = glfwCreateWindow(m_width, m_height, m_sAppName.c_str(), NULL, NULL);
+		}
 
-		// Create a window
-		window = glfwCreateWindow(m_width, m_height, m_sAppName.c_str(), NULL, NULL);
 		if (window == NULL)
 			Error("Failed to create window.");
 
-		// Set window position on screen
-		glfwSetWindowPos(window, 360, 75);
-
 		// Make the window to in the current context
 		glfwMakeContextCurrent(window);
 
-		// Disable cursor
-		glfwSetCursorPos(window, m_width / 2.0f, m_height / 2.0f);
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		if (!m_bHeadless)
+		{
+			// Set window position on screen
+			glfwSetWindowPos(window, 360, 75);
+
+			// Disable cursor
+			glfwSetCursorPos(window, m_width / 2.0f, m_height / 2.0f);
+			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		}
 
 		// Disable V-Sync (to achieve 60+ fps)
 		// Comment this out to get 60 fps (max)
@@ -221,12 +503,16 @@ public:
 		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 			Error("Failed to initalize GLAD");
 
+		// Render into a framebuffer of the window's size, which stays bound as the default target
+		if (m_bHeadless)
+			CreateFramebuffer();
+
 		// Set viewport and callback function when window gets resized 
 		glViewport(0, 0, m_width, m_height);
 
 		// Enable z-buffer and enable face-culling
-		glEnable(GL_DEPTH_TEST);        // Enable depth testing
-		glEnable(GL_CULL_FACE);         // Enable face culling
+		GLState::get().enable(GL_DEPTH_TEST);        // Enable depth testing
+		GLState::get().enable(GL_CULL_FACE);         // Enable face culling
 		glCullFace(GL_BACK);            // Cull back faces
 		glFrontFace(GL_CCW);            // Define front faces as counter-clockwise
 
@@ -238,6 +524,22 @@ public:
 	{
 		m_bIsRunning = true;
 
+		if (m_bHeadless)
+		{
+			// There are no events to handle, so the frames are rendered on this thread
+			glfwMakeContextCurrent(nullptr);
+			RendererThread();
+
+			Destroy();
+			glfwDestroyWindow(window);
+			glfwTerminate();
+
+			if (m_bTimedOut)
+				exit(-1);
+
+			return;
+		}
+
 		glfwSetWindowUserPointer(window, this);
 
 		glfwSetCursorPosCallback(window, mouse_callback);
@@ -270,6 +572,9 @@ public:
 		Destroy();
 		glfwDestroyWindow(window);
 		glfwTerminate();
+
+		if (m_bTimedOut)
+			exit(-1);
 	}
 
 protected:
@@ -280,6 +585,9 @@ protected:
 	// Optional to override
 	virtual void Destroy() { }
 
+	// Headless frames only count (and the clock only runs) once this returns true, e.g. after asynchronous loading
+	virtual bool IsReady() { return true; }
+
 // Private functions
 private:
 	void Error(const std::string& message)
@@ -289,6 +597,89 @@ private:
 		exit(-1);
 	}
 
+	void SetContextHints()
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		// Make the window non-resizable
+		glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+	}
+
+	// A surfaceless OSMesa context needs neither a display nor a GPU; without OSMesa, fall back to a hidden window
+	void CreateHeadlessWindow()
+	{
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+		if (glfwInit())
+		{
+			SetContextHints();
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+			window = glfwCreateWindow(m_width, m_height, m_sAppName.c_str(), NULL, NULL);
+		}
+
+		if (window == NULL)
+		{
+			glfwTerminate();
+			glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+			glfwInit();
+
+			SetContextHints();
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			window = glfwCreateWindow(m_width, m_height, m_sAppName.c_str(), NULL, NULL);
+		}
+	}
+
+	void CreateFramebuffer()
+	{
+		glGenRenderbuffers(1, &m_ColorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+		glGenRenderbuffers(1, &m_DepthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_DepthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+
+		glGenFramebuffers(1, &m_Framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorBuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			Error("Failed to create the offscreen framebuffer.");
+	}
+
+	// Writes the framebuffer to an uncompressed 24-bit TGA file
+	void CaptureFrame(const std::string& filePath)
+	{
+		std::vector<unsigned char> pixels((size_t)m_width * m_height * 3);
+
+		// TGA stores BGR rows from the bottom up, just like glReadPixels returns them
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, m_width, m_height, GL_BGR, GL_UNSIGNED_BYTE, pixels.data());
+
+		unsigned char header[18] = { 0 };
+		header[2] = 2;		// Uncompressed true-color
+		header[12] = m_width & 0xFF;
+		header[13] = (m_width >> 8) & 0xFF;
+		header[14] = m_height & 0xFF;
+		header[15] = (m_height >> 8) & 0xFF;
+		header[16] = 24;	// Bits per pixel
+
+		std::ofstream file(filePath, std::ios::binary);
+		file.write((const char*)header, sizeof(header));
+		file.write((const char*)pixels.data(), pixels.size());
+
+		if (!file.good())
+			std::cerr << "Failed to write frame to " << filePath << std::endl;
+	}
+
+	static std::string FrameNumber(int nFrame)
+	{
+		std::string number = std::to_string(nFrame);
+		return std::string(number.size() < 4 ? 4 - number.size() : 0, '0') + number;
+	}
+
 	void processInput(GLFWwindow* window)
 	{
 		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -0,0 +1,566 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+  * Per-frame timings of named sections.
+  *
+  * CPU sections are measured with a steady clock, GPU sections with GL_TIMESTAMP queries (which, unlike
+  * GL_TIME_ELAPSED, may be nested). GPU results are read back FRAMES_IN_FLIGHT frames later, by which time the
+  * GPU has finished them, so reading them doesn't stall the pipeline.
+  *
+  * The last MAX_FRAMES frames are kept for percentiles and for the CSV/JSON report.
+  */
+class Profiler
+{
+public:
+	static constexpr int MAX_FRAMES = 16384;
+	static constexpr int FRAMES_IN_FLIGHT = 4;
+
+	// Statistics of a section (or the whole frame) in milliseconds
+	struct Stats
+	{
+		float fAverage = 0.0f;
+		float fP50 = 0.0f;
+		float fP95 = 0.0f;
+		float fP99 = 0.0f;
+		float fMax = 0.0f;
+		int sampleCount = 0;
+	};
+
+private:
+	struct Section
+	{
+		std::string name;
+		bool bGpu = false;
+
+		// Milliseconds per frame, indexed by frame % MAX_FRAMES. Negative if the section didn't run in that frame.
+		std::vector<float> samples;
+
+		// Time accumulated in the current frame (a section may run several times per frame)
+		double fCurrent = 0.0;
+		std::chrono::steady_clock::time_point tStart;
+	};
+
+	// A pair of timestamp queries, resolved FRAMES_IN_FLIGHT frames later
+	struct GpuQuery
+	{
+		int section;
+		unsigned int begin;
+		unsigned int end;
+	};
+
+	struct GpuFrame
+	{
+		long long frame = -1;
+		std::vector<GpuQuery> queries;
+	};
+
+	std::vector<Section> m_Sections;
+	std::vector<float> m_FrameTimes;
+
+	long long m_Frame = 0;
+	std::chrono::steady_clock::time_point m_FrameStart;
+	bool m_bFrameStarted = false;
+
+	GpuFrame m_GpuFrames[FRAMES_IN_FLIGHT];
+
+	// Query objects which can be reused
+	std::vector<unsigned int> m_FreeQueries;
+
+	// Open GPU sections of the current frame: section and begin query
+	std::vector<std::pair<int, unsigned int>> m_OpenGpuSections;
+
+	bool m_bGpuTimers = false;
+
+	std::string m_Label;
+
+public:
+	Profiler() : m_FrameTimes(MAX_FRAMES, -1.0f)
+	{}
+
+	// Call on the GL thread once the context is current. Without it, GPU sections are ignored.
+	void init();
+
+	// Marks the start of a frame. The time between two calls is the frame time.
+	void beginFrame();
+
+	// Stores the section timings of the frame
+	void endFrame();
+
+	// Waits for the GPU timings of the frames still in flight. Call once after the last frame, before reading the
+	// results (summary, statistics, reports).
+	void resolve();
+
+	void beginCpu(const char* name);
+	void endCpu(const char* name);
+
+	void beginGpu(const char* name);
+	void endGpu(const char* name);
+
+	Stats getFrameStats() const;
+
+	// Statistics of a section, all zero if there is no such section
+	Stats getSectionStats(const char* name) const;
+
+	// One line per section with average and percentiles, e.g. for the console
+	std::string getSummary() const;
+
+	// One row per frame and one column per section, in milliseconds
+	bool writeCSV(const std::string& filePath) const;
+
+	// Statistics of the frame and every section
+	bool writeJSON(const std::string& filePath) const;
+
+	// Forgets all timings, e.g. those taken while loading. The sections are kept.
+	void reset();
+
+	// Written to the JSON report, e.g. the name of the scene and benchmark
+	void setLabel(const std::string& label);
+
+	// Deletes the query objects
+	void free();
+
+private:
+	int GetSection(const char* name, bool bGpu);
+	int FindSection(const char* name) const;
+
+	// Reads the queries of a frame slot and stores their results
+	void ResolveGpuFrame(GpuFrame& gpuFrame);
+
+	unsigned int GetQuery();
+
+	// Number of frames which have samples
+	int GetFrameCount() const;
+
+	static Stats ComputeStats(const std::vector<float>& samples, int count);
+};
+
+/**
+  * Measures the CPU time of the enclosing scope:
+  *
+  *	{
+  *		ScopedCpuTimer timer(profiler, "Update");
+  *		...
+  *	}
+  */
+class ScopedCpuTimer
+{
+private:
+	Profiler& m_Profiler;
+	const char* m_Name;
+
+public:
+	ScopedCpuTimer(Profiler& profiler, const char* name) : m_Profiler(profiler), m_Name(name)
+	{
+		m_Profiler.beginCpu(m_Name);
+	}
+
+	~ScopedCpuTimer()
+	{
+		m_Profiler.endCpu(m_Name);
+	}
+};
+
+// Measures the GPU time of the commands issued in the enclosing scope
+class ScopedGpuTimer
+{
+private:
+	Profiler& m_Profiler;
+	const char* m_Name;
+
+public:
+	ScopedGpuTimer(Profiler& profiler, const char* name) : m_Profiler(profiler), m_Name(name)
+	{
+		m_Profiler.beginGpu(m_Name);
+	}
+
+	~ScopedGpuTimer()
+	{
+		m_Profiler.endGpu(m_Name);
+	}
+};
+
+void Profiler::init()
+{
+	m_bGpuTimers = true;
+}
+
+void Profiler::beginFrame()
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	if (m_bFrameStarted)
+	{
+		std::chrono::duration<float, std::milli> frameTime = now - m_FrameStart;
+		m_FrameTimes[m_Frame % MAX_FRAMES] = frameTime.count();
+		m_Frame++;
+	}
+
+	m_FrameStart = now;
+	m_bFrameStarted = true;
+
+	// The slot of this frame was last used FRAMES_IN_FLIGHT frames ago
+	if (m_bGpuTimers)
+	{
+		GpuFrame& gpuFrame = m_GpuFrames[m_Frame % FRAMES_IN_FLIGHT];
+		ResolveGpuFrame(gpuFrame);
+		gpuFrame.frame = m_Frame;
+	}
+
+	for (auto& section : m_Sections)
+	{
+		section.fCurrent = -1.0;
+
+		// Overwritten once the queries of this frame are resolved
+		if (section.bGpu)
+			section.samples[m_Frame % MAX_FRAMES] = -1.0f;
+	}
+}
+
+void Profiler::endFrame()
+{
+	const int index = (int)(m_Frame % MAX_FRAMES);
+
+	for (auto& section : m_Sections)
+	{
+		// GPU samples are written when their queries are resolved
+		if (!section.bGpu)
+			section.samples[index] = (float)section.fCurrent;
+	}
+}
+
+void Profiler::resolve()
+{
+	for (auto& gpuFrame : m_GpuFrames)
+		ResolveGpuFrame(gpuFrame);
+}
+
+void Profiler::beginCpu(const char* name)
+{
+	Section& section = m_Sections[GetSection(name, false)];
+	section.tStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endCpu(const char* name)
+{
+	Section& section = m_Sections[GetSection(name, false)];
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - section.tStart;
+	section.fCurrent = std::max(section.fCurrent, 0.0) + elapsed.count();
+}
+
+void Profiler::beginGpu(const char* name)
+{
+	if (!m_bGpuTimers)
+		return;
+
+	const unsigned int query = GetQuery();
+	glQueryCounter(query, GL_TIMESTAMP);
+
+	m_OpenGpuSections.push_back({ GetSection(name, true), query });
+}
+
+void Profiler::endGpu(const char* name)
+{
+	if (!m_bGpuTimers)
+		return;
+
+	const int sectionIndex = GetSection(name, true);
+
+	for (size_t i = m_OpenGpuSections.size(); i-- > 0;)
+	{
+		if (m_OpenGpuSections[i].first != sectionIndex)
+			continue;
+
+		const unsigned int query = GetQuery();
+		glQueryCounter(query, GL_TIMESTAMP);
+
+		m_GpuFrames[m_Frame % FRAMES_IN_FLIGHT].queries.push_back({ sectionIndex, m_OpenGpuSections[i].second, query });
+		m_OpenGpuSections.erase(m_OpenGpuSections.begin() + i);
+		return;
+	}
+}
+
+Profiler::Stats Profiler::getFrameStats() const
+{
+	return ComputeStats(m_FrameTimes, GetFrameCount());
+}
+
+Profiler::Stats Profiler::getSectionStats(const char* name) const
+{
+	const int index = FindSection(name);
+	if (index < 0)
+		return Stats();
+
+	return ComputeStats(m_Sections[index].samples, GetFrameCount());
+}
+
+std::string Profiler::getSummary() const
+{
+	std::string summary;
+	char line[256];
+
+	auto addLine = [&](const std::string& name, const Stats& stats)
+	{
+		snprintf(line, sizeof(line), "%-24s avg %7.3f ms  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f\n",
+			name.c_str(), stats.fAverage, stats.fP50, stats.fP95, stats.fP99, stats.fMax);
+		summary += line;
+	};
+
+	addLine("Frame", getFrameStats());
+
+	for (const auto& section : m_Sections)
+		addLine(section.name + (section.bGpu ? " (GPU)" : " (CPU)"), ComputeStats(section.samples, GetFrameCount()));
+
+	return summary;
+}
+
+bool Profiler::writeCSV(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	file << "frame,frame_ms";
+	for (const auto& section : m_Sections)
+		file << ',' << section.name << (section.bGpu ? "_gpu_ms" : "_cpu_ms");
+	file << '\n';
+
+	const int count = GetFrameCount();
+	for (long long frame = m_Frame - count; frame < m_Frame; frame++)
+	{
+		const int index = (int)(frame % MAX_FRAMES);
+
+		file << frame << ',' << m_FrameTimes[index];
+
+		// Empty cells for sections which didn't run in that frame
+		for (const auto& section : m_Sections)
+		{
+			file << ',';
+			if (section.samples[index] >= 0.0f)
+				file << section.samples[index];
+		}
+
+		file << '\n';
+	}
+
+	return file.good();
+}
+
+bool Profiler::writeJSON(const std::string& filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	auto writeStats = [&](const Stats& stats)
+	{
+		file << "{ \"samples\": " << stats.sampleCount << ", \"avg_ms\": " << stats.fAverage << ", \"p50_ms\": " << stats.fP50
+			<< ", \"p95_ms\": " << stats.fP95 << ", \"p99_ms\": " << stats.fP99 << ", \"max_ms\": " << stats.fMax << " }";
+	};
+
+	file << "{\n\t\"label\": \"" << m_Label << "\",\n\t\"frames\": " << GetFrameCount() << ",\n\t\"frame\": ";
+	writeStats(getFrameStats());
+	file << ",\n\t\"sections\": [";
+
+	for (size_t i = 0; i < m_Sections.size(); i++)
+	{
+		const Section& section = m_Sections[i];
+
+		file << (i ? ",\n\t\t" : "\n\t\t") << "{ \"name\": \"" << section.name << "\", \"type\": \"" << (section.bGpu ? "gpu" : "cpu") << "\", \"stats\": ";
+		writeStats(ComputeStats(section.samples, GetFrameCount()));
+		file << " }";
+	}
+
+	file << "\n\t]\n}\n";
+
+	return file.good();
+}
+
+void Profiler::reset()
+{
+	// Queries still in flight are reused without reading them
+	for (auto& gpuFrame : m_GpuFrames)
+	{
+		for (const auto& query : gpuFrame.queries)
+		{
+			m_FreeQueries.push_back(query.begin);
+			m_FreeQueries.push_back(query.end);
+		}
+
+		gpuFrame.queries.clear();
+		gpuFrame.frame = -1;
+	}
+
+	for (auto& section : m_Sections)
+	{
+		std::fill(section.samples.begin(), section.samples.end(), -1.0f);
+		section.fCurrent = -1.0;
+	}
+
+	std::fill(m_FrameTimes.begin(), m_FrameTimes.end(), -1.0f);
+
+	m_Frame = 0;
+	m_bFrameStarted = false;
+}
+
+void Profiler::setLabel(const std::string& label)
+{
+	// Escaped for JSON, paths on Windows contain backslashes
+	m_Label.clear();
+	for (char c : label)
+	{
+		if (c == '\\' || c == '"')
+			m_Label += '\\';
+
+		m_Label += c;
+	}
+}
+
+void Profiler::free()
+{
+	for (auto& gpuFrame : m_GpuFrames)
+	{
+		for (const auto& query : gpuFrame.queries)
+		{
+			m_FreeQueries.push_back(query.begin);
+			m_FreeQueries.push_back(query.end);
+		}
+
+		gpuFrame.queries.clear();
+	}
+
+	for (const auto& open : m_OpenGpuSections)
+		m_FreeQueries.push_back(open.second);
+
+	m_OpenGpuSections.clear();
+
+	if (!m_FreeQueries.empty())
+		glDeleteQueries((GLsizei)m_FreeQueries.size(), m_FreeQueries.data());
+
+	m_FreeQueries.clear();
+	m_bGpuTimers = false;
+}
+
+// Private utility function - index of a section, which is created on first use
+int Profiler::GetSection(const char* name, bool bGpu)
+{
+	for (size_t i = 0; i < m_Sections.size(); i++)
+	{
+		if (m_Sections[i].bGpu == bGpu && m_Sections[i].name == name)
+			return (int)i;
+	}
+
+	Section section;
+	section.name = name;
+	section.bGpu = bGpu;
+	section.samples.assign(MAX_FRAMES, -1.0f);
+	section.fCurrent = -1.0;
+
+	m_Sections.push_back(std::move(section));
+	return (int)m_Sections.size() - 1;
+}
+
+// Private utility function - index of a section, -1 if there is none
+int Profiler::FindSection(const char* name) const
+{
+	for (size_t i = 0; i < m_Sections.size(); i++)
+	{
+		if (m_Sections[i].name == name)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+// Private utility function - the results are 4 frames old, so waiting for them is practically free
+void Profiler::ResolveGpuFrame(GpuFrame& gpuFrame)
+{
+	if (gpuFrame.queries.empty())
+		return;
+
+	const int index = (int)(gpuFrame.frame % MAX_FRAMES);
+
+	for (const auto& query : gpuFrame.queries)
+	{
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+
+		float& sample = m_Sections[query.section].samples[index];
+		sample = std::max(sample, 0.0f) + (float)((double)(end - begin) / 1.0e6);
+
+		m_FreeQueries.push_back(query.begin);
+		m_FreeQueries.push_back(query.end);
+	}
+
+	gpuFrame.queries.clear();
+}
+
+// Private utility function - reuses query objects from earlier frames
+unsigned int Profiler::GetQuery()
+{
+	if (m_FreeQueries.empty())
+	{
+		unsigned int queries[16];
+		glGenQueries(16, queries);
+		m_FreeQueries.insert(m_FreeQueries.end(), queries, queries + 16);
+	}
+
+	const unsigned int query = m_FreeQueries.back();
+	m_FreeQueries.pop_back();
+	return query;
+}
+
+// Private utility function - number of finished frames still in the history
+int Profiler::GetFrameCount() const
+{
+	return (int)std::min<long long>(m_Frame, MAX_FRAMES);
+}
+
+// Private utility function - ignores negative samples (frames in which the section didn't run)
+Profiler::Stats Profiler::ComputeStats(const std::vector<float>& samples, int count)
+{
+	Stats stats;
+
+	std::vector<float> values;
+	values.reserve(count);
+
+	for (int i = 0; i < count && i < (int)samples.size(); i++)
+	{
+		if (samples[i] >= 0.0f)
+			values.push_back(samples[i]);
+	}
+
+	if (values.empty())
+		return stats;
+
+	double fSum = 0.0;
+	for (float value : values)
+		fSum += value;
+
+	auto percentile = [&](float fPercent)
+	{
+		const size_t n = std::min(values.size() - 1, (size_t)(fPercent / 100.0f * (float)values.size()));
+		std::nth_element(values.begin(), values.begin() + n, values.end());
+		return values[n];
+	};
+
+	stats.sampleCount = (int)values.size();
+	stats.fAverage = (float)(fSum / values.size());
+	stats.fP50 = percentile(50.0f);
+	stats.fP95 = percentile(95.0f);
+	stats.fP99 = percentile(99.0f);
+	stats.fMax = *std::max_element(values.begin(), values.end());
+
+	return stats;
+}
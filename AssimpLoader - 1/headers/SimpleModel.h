@@ -3,8 +3,12 @@
 #include "VertexArray.h"
 #include "VertexBuffer.h"
 #include "Shader.h"
-#include "BufferLayout.h"
+#include "VertexCompression.h"
 #include "Texture2D.h"
+#include "IndexBuffer.h"
+#include "ObjParser.h"
+#include "MeshData.h"
+#include "MeshCache.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -15,14 +19,55 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
+
+// Vertices of the mesh files (see MeshCache.h), object files with an MTL file come with texture coordinates
+struct MeshVertex
+{
+	glm::vec3 vPosition;
+	glm::vec3 vNormal;
+};
+
+struct TexturedMeshVertex
+{
+	glm::vec3 vPosition;
+	glm::vec3 vNormal;
+	glm::vec2 vTexCoords;
+};
+
+template<>
+struct VertexFormat<MeshVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::vec3>(0, offsetof(MeshVertex, vPosition)),
+		VertexAttribute::of<glm::vec3>(1, offsetof(MeshVertex, vNormal))
+	};
+};
+
+template<>
+struct VertexFormat<TexturedMeshVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::vec3>(0, offsetof(TexturedMeshVertex, vPosition)),
+		VertexAttribute::of<glm::vec3>(1, offsetof(TexturedMeshVertex, vNormal)),
+		VertexAttribute::of<glm::vec2>(2, offsetof(TexturedMeshVertex, vTexCoords))
+	};
+};
 
 class SimpleModel
 {
 private:
 	VertexArray vao;
 	VertexBuffer<float> vbo;
+	IndexBuffer ibo;
 	std::vector<Texture2D> textures;
 	int nr_indices = 0;
+	GLenum indexType = GL_UNSIGNED_SHORT;
+
+	// Set by load() to upload compressed vertices, see VertexCompression.h
+	bool bCompressVertices = false;
+	VertexDecode decode;
+	VertexCompressionStats compressionStats;
 
 public:
 	//glm::mat4 matModel = glm::mat4(1.0f);
@@ -30,8 +75,8 @@ public:
 	SimpleModel() = default;
 	SimpleModel(const std::string& objfilepath, const std::vector<std::string>&& texturePaths);
 
-	// Load the object file
-	bool load(const std::string& objfilePath);
+	// Load the object file, with compressed vertices if 'bCompress' is set
+	bool load(const std::string& objfilePath, bool bCompress = false);
 
 	// Set textures to the model, if any
 	// For now, this function is just a placeholder and does nothing
@@ -41,26 +86,39 @@ public:
 	// Bind textures by using a function, as doing them for every draw call is inefficient.
 	void bindTextures();
 
-	// Function which draws the model onto the screen. Make sure to bind shaders before calling this function.
-	void draw();
+	// Function which draws the model onto the screen. Make sure to bind 'shader' before calling this function,
+	// it gets the uniforms decoding the vertices.
+	void draw(Shader& shader);
 
 	// Destructor
 	~SimpleModel();
 
 private:
 	// Utility function to load model
-	bool LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile);
+	bool LoadModel(const std::string& modelFile);
+	void UploadMesh(const MeshFileHeader& header, const void* vertices, const void* indices);
+
+	template<typename Vertex, typename Stored>
+	void UploadVertices(const MeshFileHeader& header, const void* vertices);
 };
 
 SimpleModel::SimpleModel(const std::string& objfilepath, const std::vector<std::string>&& texturePaths)
 {
-	LoadModel(vao, vbo, nr_indices, objfilepath);
+	LoadModel(objfilepath);
 	setTextures(texturePaths);
 }
 
-bool SimpleModel::load(const std::string& objfilePath)
+bool SimpleModel::load(const std::string& objfilePath, bool bCompress)
 {
-	return LoadModel(vao, vbo, nr_indices, objfilePath);
+	bCompressVertices = bCompress;
+
+	if (!LoadModel(objfilePath))
+		return false;
+
+	if (bCompressVertices)
+		compressionStats.print(objfilePath);
+
+	return true;
 }
 
 void SimpleModel::setTextures(const std::vector<std::string>& texturePaths)
@@ -75,7 +133,7 @@ void SimpleModel::setTextures(const std::vector<std::string>& texturePaths)
 	// Bind textures
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 }
@@ -92,7 +150,7 @@ void SimpleModel::setTextures(const std::vector<std::string>&& texturePaths)
 	// Bind textures
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 }
@@ -105,7 +163,7 @@ void SimpleModel::bindTextures()
 	// Bind textures
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 
@@ -113,198 +171,138 @@ void SimpleModel::bindTextures()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
-void SimpleModel::draw()
+void SimpleModel::draw(Shader& shader)
 {
+	decode.apply(shader);
+
 	vao.bind();
-	glDrawArrays(GL_TRIANGLES, 0, nr_indices);
+	glDrawElements(GL_TRIANGLES, nr_indices, indexType, 0);
 }
 
 SimpleModel::~SimpleModel()
 {
+	ibo.free();
 	vbo.free();
 	vao.free();
 }
 
-// Utility function to load models (written earlier so I'm lazy to properly integrate it in load() function :/
-// TODO: Add texture functonality
-bool SimpleModel::LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile)
+// Utility function to load models. The model is read from its binary cache file if there is an
+// up-to-date one, otherwise the object file is parsed and the cache file gets written for the next run.
+bool SimpleModel::LoadModel(const std::string& modelFile)
 {
-	std::vector<glm::vec3> temp_positions;
-	std::vector<glm::vec3> temp_normals;
-	std::vector<glm::vec2> temp_textures;
+	MeshFileView cached;
 
-	std::ifstream inputFileStream(modelFile);
-	std::string line;
-	std::stringstream ss;
-
-	if (!inputFileStream.is_open())
+	if (MeshCache::load(modelFile, cached))
 	{
-		std::cerr << "Failed to open object file: " << modelFile << std::endl;
-		return false;
+		// The vertex and index blobs go straight from the mapped file into the buffers
+		UploadMesh(cached.header(), cached.vertices(), cached.indices());
+		nr_indices = (int)cached.header().indexCount;
+		return true;
 	}
 
-	/** If the object file has "mtllib" on the third line, then the object file is
-	  * associated with some MTL file which we need to parse along with OBJ file */
-
-	// Go to the third line
-	std::string lineParser;
-	
-	// Read 3 lines
-	for (int i = 0; i < 3; i++)
-		std::getline(inputFileStream, lineParser);
+	ObjData obj;
 
-	// Read the third line and see if it has mtllib
-	//std::getline(inputFileStream, lineParser);
-	
-	if (lineParser.find("mtllib") != std::string::npos)
+	if (!ObjParser::parse(modelFile, obj))
 	{
-		struct VertexTexture
-		{
-			glm::vec3 position;
-			glm::vec3 normal;
-			glm::vec2 textures;
-		};
-		std::vector<VertexTexture> verticesTexture;
-
-		while (std::getline(inputFileStream, line))
-		{
-			// Vertex normals
-			if (line.starts_with("vn"))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_normals.push_back({f1, f2, f3});
-			}
-
-			// Texture coordinates
-			else if (line.starts_with("vt"))
-			{
-				float f1, f2;
-				sscanf_s(line.c_str(), "%*s %f %f", &f1, &f2);
-				temp_textures.push_back({ f1, f2 });
-			}
-
-			// Vertex coordinates
-			else if (line.starts_with('v'))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_positions.push_back({ f1, f2, f3 });
-			}
-
-			// Indices
-			else if (line.starts_with('f'))
-			{
-				int v[3];
-				int n[3];
-				int t[3];
-
-				sscanf_s(line.c_str(), "%*s %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &t[0], &n[0], &v[1], &t[1], &n[1], &v[2], &t[2], &n[2]);
+		std::cerr << "Failed to open object file: " << modelFile << std::endl;
+		return false;
+	}
 
-				int posIndex;
-				int normIndex;
-				int textIndex;
+	if (obj.invalidFaces > 0)
+		std::cerr << "Skipped " << obj.invalidFaces << " invalid faces in " << modelFile << std::endl;
 
-				for (int i = 0; i < 3; i++)
-				{
-					posIndex = v[i] - 1;
-					normIndex = n[i] - 1;
-					textIndex = t[i] - 1;
+	// Weld identical vertices together and build an index buffer referencing them
+	MeshData mesh;
+	MeshBuilder::build(obj, mesh);
 
-					VertexTexture vertex;
-					vertex.position = temp_positions[posIndex];
-					vertex.normal = temp_normals[normIndex];
-					vertex.textures = temp_textures[textIndex];
+	if (!MeshCache::save(modelFile, mesh))
+		std::cerr << "Failed to write mesh cache: " << MeshCache::getCachePath(modelFile) << std::endl;
 
-					verticesTexture.push_back(vertex);
-				}
-			}
-		}
+	UploadMesh(MeshCache::describe(mesh), mesh.vertices.data(), mesh.indices.data());
+	nr_indices = (int)mesh.getIndexCount();
 
-		BufferLayout layout;
+	return true;
+}
 
-		vao.generate();
-		vbo.generate(8);		// 8 floats per vertex: 3 for vertex positions, 3 for vertex normals and 2 for texture coordinates
+// Utility function to create the buffers of the model, the layout is taken from the mesh header
+void SimpleModel::UploadMesh(const MeshFileHeader& header, const void* vertices, const void* indices)
+{
+	const bool bTextured = (header.flags & MeshFileHeader::TEXTURED) != 0;
+
+	const size_t stride = bTextured ? sizeof(TexturedMeshVertex) : sizeof(MeshVertex);
+	if (header.vertexStride != stride)
+		std::cerr << "Unexpected mesh vertex stride: " << header.vertexStride << " bytes instead of " << stride << std::endl;
+
+	vao.generate();
+	vbo.generate(header.vertexCount);
+
+	// Positions, normals and texture coordinates (object files which come with an MTL file)
+	if (bTextured && bCompressVertices)
+		UploadVertices<TexturedMeshVertex, CompressedTexturedMeshVertex>(header, vertices);
+	else if (bTextured)
+		UploadVertices<TexturedMeshVertex, TexturedMeshVertex>(header, vertices);
+	else if (bCompressVertices)
+		UploadVertices<MeshVertex, CompressedMeshVertex>(header, vertices);
+	else
+		UploadVertices<MeshVertex, MeshVertex>(header, vertices);
 
-		const void* vertexBuffer = verticesTexture.data();
-		vbo.setBuffer(verticesTexture.size() * 8 * sizeof(float), vertexBuffer);
+	// The element buffer binding is stored in the VAO
+	ibo.generate();
+	ibo.setBuffer(header.indexBytes, indices);
 
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);		// Vertices
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);		// Normals
-		layout.setBufferLayout(vao, vbo, 2, BufferType::FLOAT);		// Texture coordinates
+	indexType = header.indexType == (uint32_t)IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
 
-		vertexCount = verticesTexture.size();
-	}
+// Utility function to fill the vertex buffer with the 'Vertex' vertices of the mesh file stored as 'Stored', which
+// is either the same type or its compressed version
+template<typename Vertex, typename Stored>
+void SimpleModel::UploadVertices(const MeshFileHeader& header, const void* vertices)
+{
+	if constexpr (std::is_same_v<Vertex, Stored>)
+		vbo.setBuffer(header.vertexBytes, vertices);
 
-	// Else, it is just a regular object file without any textures
 	else
 	{
-		struct Vertex
-		{
-			glm::vec3 position;
-			glm::vec3 normal;
-		};
+		const Vertex* source = static_cast<const Vertex*>(vertices);
+		const size_t vertexCount = header.vertexCount;
 
-		std::vector<Vertex> vertices;
+		glm::vec3 vMinPosition(0.0f), vMaxPosition(0.0f);
+		glm::vec2 vMinTexCoord(0.0f), vMaxTexCoord(0.0f);
 
-		while (std::getline(inputFileStream, line))
+		for (size_t i = 0; i < vertexCount; i++)
 		{
-			if (line.starts_with("vn"))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_normals.push_back({ f1, f2, f3 });
-			}
+			vMinPosition = i ? glm::min(vMinPosition, source[i].vPosition) : source[i].vPosition;
+			vMaxPosition = i ? glm::max(vMaxPosition, source[i].vPosition) : source[i].vPosition;
 
-			if (line.starts_with('v'))
+			if constexpr (std::is_same_v<Vertex, TexturedMeshVertex>)
 			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_positions.push_back({ f1, f2, f3 });
+				vMinTexCoord = i ? glm::min(vMinTexCoord, source[i].vTexCoords) : source[i].vTexCoords;
+				vMaxTexCoord = i ? glm::max(vMaxTexCoord, source[i].vTexCoords) : source[i].vTexCoords;
 			}
+		}
 
-			else if (line.starts_with('f'))
-			{
-				int v[3];
-				int n[3];
+		decode = VertexDecode::fromBounds(vMinPosition, vMaxPosition, vMinTexCoord, vMaxTexCoord);
 
-				sscanf_s(line.c_str(), "%*s %d//%d %d//%d %d//%d", &v[0], &n[0], &v[1], &n[1], &v[2], &n[2]);
+		std::vector<Stored> compressed(vertexCount);
 
-				int posIndex;
-				int normIndex;
+		compressionStats = VertexCompressionStats();
+		compressionStats.vertexCount = vertexCount;
+		compressionStats.rawBytes = header.vertexBytes;
+		compressionStats.compressedBytes = vertexCount * sizeof(Stored);
 
-				for (int i = 0; i < 3; i++)
-				{
-					posIndex = v[i] - 1;
-					normIndex = n[i] - 1;
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			compressed[i].position = decode.encodePosition(source[i].vPosition);
+			compressed[i].normal = Packed1010102::packDirection(source[i].vNormal);
 
-					Vertex vertex;
-					vertex.position = temp_positions[posIndex];
-					vertex.normal = temp_normals[normIndex];
+			if constexpr (std::is_same_v<Vertex, TexturedMeshVertex>)
+				compressed[i].texCoords = decode.encodeTexCoords(source[i].vTexCoords);
 
-					vertices.push_back(vertex);
-				}
-			}
+			compressionStats.fMaxPositionError = std::max(compressionStats.fMaxPositionError, glm::length(decode.decodePosition(compressed[i].position) - source[i].vPosition));
 		}
 
-		BufferLayout layout;
-
-		vao.generate();
-		vbo.generate(6);		// 6 floats per vertex: 3 for vertex positions and another 3 for normal vector
-
-		const void* vertexBuffer = vertices.data();
-		vbo.setBuffer(vertices.size() * 6 * sizeof(float), vertexBuffer);
-
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);	// positions
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);	// normals
-		vertexCount = vertices.size();
+		vbo.setBuffer(compressed.size() * sizeof(Stored), compressed.data());
 	}
 
-	inputFileStream.close();
-
-	//std::cout << "Finished loading!\n";
-	//std::cout << "Number of vertices: " << vertexCount << "\n";
-	//std::cout << "Size (bytes): " << vertexCount * sizeof(Vertex) << " bytes (" << std::fixed << std::setprecision(2) << (float)(vertexCount * sizeof(Vertex) / (1024.0f * 1024.0f)) << " MB)\n\n";
-
-	return true;
-}
\ No newline at end of file
+	VertexLayout::apply<Stored>(vao, vbo);
+}
@@ -2,7 +2,11 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 #include "stb_image_impl.h"
+#include "CompressedTexture.h"
+#include "TextureStreamer.h"
 
 #include <iostream>
 
@@ -14,6 +18,9 @@ private:
 	unsigned char* data;
 	int m_nrChannels;
 
+	// Set if the texture is loaded through a TextureStreamer
+	TextureHandle m_Handle;
+
 public:
 	Texture2D() = default;
 
@@ -23,13 +30,20 @@ public:
 
 	void bindTexture() const;
 
-	void loadTexture(char const* path);
+	// Uses the compressed texture built by the TextureCompressor tool if there is an up-to-date one
+	void loadTexture(char const* path, bool bFlipVertically = true);
+
+	// Decodes and uploads the texture in the background. Until it is resident, the texture binds a placeholder.
+	void loadTextureAsync(const std::string& path, TextureStreamer& streamer, bool bFlipVertically = true);
+
+private:
+	bool LoadCompressed(const std::string& path, bool bFlipVertically);
 };
 
 void Texture2D::load(GLenum wrapType, GLint minFilter, GLint magFilter, const std::string textureFile, GLint internalFormat, GLenum format)
 {
 	glGenTextures(1, &m_TextureID);
-	glBindTexture(GL_TEXTURE_2D, m_TextureID);
+	GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapType);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapType);
@@ -56,18 +70,23 @@ void Texture2D::load(GLenum wrapType, GLint minFilter, GLint magFilter, const st
 
 unsigned int Texture2D::getTextureID() const
 {
-	return m_TextureID;
+	return m_Handle ? m_Handle.getID() : m_TextureID;
 }
 
 void Texture2D::bindTexture() const
 {
-	glBindTexture(GL_TEXTURE_2D, m_TextureID);
+	GLState::get().bindTexture(GL_TEXTURE_2D, getTextureID());
 }
 
-void Texture2D::loadTexture(char const* path)
+void Texture2D::loadTexture(char const* path, bool bFlipVertically)
 {
 	glGenTextures(1, &m_TextureID);
 
+	if (LoadCompressed(path, bFlipVertically))
+		return;
+
+	stbi_set_flip_vertically_on_load(bFlipVertically);
+
 	int width, height, nrComponents;
 	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
 	if (data)
@@ -82,7 +101,7 @@ void Texture2D::loadTexture(char const* path)
 		else
 			exit(-1);
 
-		glBindTexture(GL_TEXTURE_2D, m_TextureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -98,4 +117,31 @@ void Texture2D::loadTexture(char const* path)
 		std::cout << "Texture failed to load at path: " << path << std::endl;
 		stbi_image_free(data);
 	}
-}
\ No newline at end of file
+}
+
+void Texture2D::loadTextureAsync(const std::string& path, TextureStreamer& streamer, bool bFlipVertically)
+{
+	// Images are decoded on worker threads, so the flip has to be passed along instead of being set globally
+	m_Handle = streamer.load(path, bFlipVertically);
+}
+
+// Private utility function - uploads the cached compressed texture of 'path', returns false if there is none
+bool Texture2D::LoadCompressed(const std::string& path, bool bFlipVertically)
+{
+	TextureFileView view;
+	if (!TextureCache::load(path, bFlipVertically, view) || !CompressedTexture::isSupported(view.format()))
+		return false;
+
+	GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
+	CompressedTexture::upload(view);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	m_width = (int)view.width();
+	m_height = (int)view.height();
+
+	return true;
+}
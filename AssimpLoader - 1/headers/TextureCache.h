@@ -0,0 +1,369 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+  * Block compressed textures (.dds), written next to the source image (e.g. container2.png -> container2.png.dds)
+  * by the TextureCompressor tool (tools/TextureCompressor.cpp).
+  *
+  *	"DDS "				magic
+  *	DDSHeader			standard DDS header, the format is given by its FourCC
+  *	mip levels			largest first, each one exactly as it is handed to glCompressedTexImage2D
+  *
+  * The files are regular DDS files which other tools can open, except that the rows are stored in the order the
+  * program uploads them: flipped vertically if the source image is loaded flipped. The unused reserved words of
+  * the header hold a TextureSourceInfo, so, like a .mesh file, a cache file is only used while it still matches
+  * the image (and the flip) it was built from. Loading maps the file, there is nothing to decode.
+  *
+  * BC1 (DXT1) holds RGB at 4 bits per pixel, BC3 (DXT5) RGBA and BC5 (ATI2) two channels at 8 bits per pixel,
+  * BC4 (ATI1) a single channel at 4 bits per pixel.
+  */
+
+enum class TextureCompression : uint32_t
+{
+	BC1 = 0,	// RGB
+	BC3,		// RGBA
+	BC4,		// R
+	BC5,		// RG
+	COUNT
+};
+
+struct DDSPixelFormat
+{
+	uint32_t size = 32;
+	uint32_t flags = 0;
+	uint32_t fourCC = 0;
+	uint32_t rgbBitCount = 0;
+	uint32_t rBitMask = 0;
+	uint32_t gBitMask = 0;
+	uint32_t bBitMask = 0;
+	uint32_t aBitMask = 0;
+
+	static constexpr uint32_t FOURCC = 0x4;
+};
+
+struct DDSHeader
+{
+	uint32_t size = 124;
+	uint32_t flags = 0;
+	uint32_t height = 0;
+	uint32_t width = 0;
+	uint32_t linearSize = 0;
+	uint32_t depth = 0;
+	uint32_t mipMapCount = 0;
+	uint32_t reserved1[11] = {};
+	DDSPixelFormat pixelFormat;
+	uint32_t caps = 0;
+	uint32_t caps2 = 0;
+	uint32_t caps3 = 0;
+	uint32_t caps4 = 0;
+	uint32_t reserved2 = 0;
+
+	static constexpr char MAGIC[4] = { 'D', 'D', 'S', ' ' };
+
+	// flags
+	static constexpr uint32_t CAPS = 0x1;
+	static constexpr uint32_t HEIGHT = 0x2;
+	static constexpr uint32_t WIDTH = 0x4;
+	static constexpr uint32_t PIXELFORMAT = 0x1000;
+	static constexpr uint32_t MIPMAPCOUNT = 0x20000;
+	static constexpr uint32_t LINEARSIZE = 0x80000;
+
+	// caps
+	static constexpr uint32_t CAPS_COMPLEX = 0x8;
+	static constexpr uint32_t CAPS_TEXTURE = 0x1000;
+	static constexpr uint32_t CAPS_MIPMAP = 0x400000;
+};
+
+static_assert(sizeof(DDSPixelFormat) == 32, "DDSPixelFormat doesn't match the DDS file format");
+static_assert(sizeof(DDSHeader) == 124, "DDSHeader doesn't match the DDS file format");
+
+// Stored in DDSHeader::reserved1, identifies the source image the texture was built from
+struct TextureSourceInfo
+{
+	static constexpr char MAGIC[4] = { 'C', 'T', 'E', 'X' };
+	static constexpr uint32_t VERSION = 2;
+
+	char magic[4] = { 'C', 'T', 'E', 'X' };
+	uint32_t version = VERSION;
+
+	// Size and modification time of the image. Its path isn't part of the key, the cache file sits next to the
+	// image and the compressor tool and the program may well reach it through different paths.
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+
+	uint32_t flags = 0;				// TextureSourceInfo::FLIPPED
+	uint32_t padding = 0;
+
+	static constexpr uint32_t FLIPPED = 1;
+};
+
+static_assert(sizeof(TextureSourceInfo) <= sizeof(DDSHeader::reserved1), "TextureSourceInfo doesn't fit into the DDS header");
+
+// Texture in memory, as produced by the compressor
+struct CompressedImage
+{
+	TextureCompression format = TextureCompression::BC1;
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	// All mip levels, largest first
+	std::vector<uint8_t> data;
+	uint32_t levelCount = 0;
+};
+
+// A cached texture which is still memory-mapped. The pointers stay valid as long as the view lives.
+class TextureFileView
+{
+private:
+	// Larger sizes are taken as a corrupt header
+	static constexpr uint32_t MAX_SIZE = 32768;
+
+	MappedFile m_File;
+	const DDSHeader* m_Header = nullptr;
+	TextureCompression m_Format = TextureCompression::BC1;
+	TextureSourceInfo m_Source;
+
+public:
+	bool open(const std::string& cachePath);
+
+	TextureCompression format() const { return m_Format; }
+	uint32_t width() const { return m_Header->width; }
+	uint32_t height() const { return m_Header->height; }
+	uint32_t levelCount() const { return m_Header->mipMapCount; }
+	const TextureSourceInfo& source() const { return m_Source; }
+
+	// Data of a mip level, 'bytes' is set to its size
+	const void* level(uint32_t level, uint32_t& width, uint32_t& height, size_t& bytes) const;
+
+	// Total size of the mip levels
+	size_t getDataBytes() const;
+};
+
+class TextureCache
+{
+public:
+	// Path of the cache file belonging to an image
+	static std::string getCachePath(const std::string& sourcePath);
+
+	// Opens the cache file of 'sourcePath'. Returns false if there is none, or if it is outdated or corrupt.
+	static bool load(const std::string& sourcePath, bool bFlipVertically, TextureFileView& view);
+
+	// Writes 'image' into the cache file of 'sourcePath'
+	static bool save(const std::string& sourcePath, bool bFlipVertically, const CompressedImage& image);
+
+	// Bytes per 4x4 block
+	static uint32_t getBlockBytes(TextureCompression format);
+
+	static size_t getLevelBytes(TextureCompression format, uint32_t width, uint32_t height);
+
+	// Number of mip levels down to 1x1
+	static uint32_t getLevelCount(uint32_t width, uint32_t height);
+
+private:
+	static uint32_t GetFourCC(TextureCompression format);
+	static bool GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& time);
+
+	friend class TextureFileView;
+};
+
+bool TextureFileView::open(const std::string& cachePath)
+{
+	m_Header = nullptr;
+
+	if (!m_File.open(cachePath) || m_File.size() < sizeof(DDSHeader::MAGIC) + sizeof(DDSHeader))
+		return false;
+
+	if (memcmp(m_File.data(), DDSHeader::MAGIC, sizeof(DDSHeader::MAGIC)) != 0)
+		return false;
+
+	const DDSHeader* header = reinterpret_cast<const DDSHeader*>(m_File.data() + sizeof(DDSHeader::MAGIC));
+
+	if (header->size != sizeof(DDSHeader) || !(header->pixelFormat.flags & DDSPixelFormat::FOURCC) || header->width == 0 || header->height == 0 ||
+		header->width > MAX_SIZE || header->height > MAX_SIZE)
+		return false;
+
+	memcpy(&m_Source, header->reserved1, sizeof(m_Source));
+	if (memcmp(m_Source.magic, TextureSourceInfo::MAGIC, sizeof(m_Source.magic)) != 0 || m_Source.version != TextureSourceInfo::VERSION)
+		return false;
+
+	bool bKnownFormat = false;
+	for (uint32_t i = 0; i < (uint32_t)TextureCompression::COUNT; i++)
+	{
+		if (header->pixelFormat.fourCC == TextureCache::GetFourCC((TextureCompression)i))
+		{
+			m_Format = (TextureCompression)i;
+			bKnownFormat = true;
+		}
+	}
+
+	if (!bKnownFormat || header->mipMapCount == 0 || header->mipMapCount > TextureCache::getLevelCount(header->width, header->height))
+		return false;
+
+	m_Header = header;
+
+	// Make sure the levels are inside the file
+	if (sizeof(DDSHeader::MAGIC) + sizeof(DDSHeader) + getDataBytes() > m_File.size())
+	{
+		m_Header = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+const void* TextureFileView::level(uint32_t level, uint32_t& width, uint32_t& height, size_t& bytes) const
+{
+	size_t offset = sizeof(DDSHeader::MAGIC) + sizeof(DDSHeader);
+
+	width = m_Header->width;
+	height = m_Header->height;
+
+	for (uint32_t i = 0; i < level; i++)
+	{
+		offset += TextureCache::getLevelBytes(m_Format, width, height);
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+
+	bytes = TextureCache::getLevelBytes(m_Format, width, height);
+	return m_File.data() + offset;
+}
+
+size_t TextureFileView::getDataBytes() const
+{
+	size_t bytes = 0;
+	uint32_t width = m_Header->width;
+	uint32_t height = m_Header->height;
+
+	for (uint32_t i = 0; i < m_Header->mipMapCount; i++)
+	{
+		bytes += TextureCache::getLevelBytes(m_Format, width, height);
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+
+	return bytes;
+}
+
+std::string TextureCache::getCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".dds";
+}
+
+bool TextureCache::load(const std::string& sourcePath, bool bFlipVertically, TextureFileView& view)
+{
+	uint64_t size;
+	int64_t time;
+
+	if (!GetSourceInfo(sourcePath, size, time))
+		return false;
+
+	if (!view.open(getCachePath(sourcePath)))
+		return false;
+
+	const TextureSourceInfo& source = view.source();
+	const bool bFlipped = (source.flags & TextureSourceInfo::FLIPPED) != 0;
+
+	return source.sourceSize == size && source.sourceTime == time && bFlipped == bFlipVertically;
+}
+
+bool TextureCache::save(const std::string& sourcePath, bool bFlipVertically, const CompressedImage& image)
+{
+	TextureSourceInfo source;
+
+	if (!GetSourceInfo(sourcePath, source.sourceSize, source.sourceTime))
+		return false;
+
+	source.flags = bFlipVertically ? TextureSourceInfo::FLIPPED : 0;
+
+	DDSHeader header;
+	header.flags = DDSHeader::CAPS | DDSHeader::HEIGHT | DDSHeader::WIDTH | DDSHeader::PIXELFORMAT | DDSHeader::MIPMAPCOUNT | DDSHeader::LINEARSIZE;
+	header.width = image.width;
+	header.height = image.height;
+	header.linearSize = (uint32_t)getLevelBytes(image.format, image.width, image.height);
+	header.mipMapCount = image.levelCount;
+	header.pixelFormat.flags = DDSPixelFormat::FOURCC;
+	header.pixelFormat.fourCC = GetFourCC(image.format);
+	header.caps = DDSHeader::CAPS_TEXTURE | DDSHeader::CAPS_COMPLEX | DDSHeader::CAPS_MIPMAP;
+	memcpy(header.reserved1, &source, sizeof(source));
+
+	// Write into a temporary file first, so that a crash never leaves a half-written cache file behind
+	const std::string cachePath = getCachePath(sourcePath);
+	const std::string tempPath = cachePath + ".tmp";
+
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+			return false;
+
+		stream.write(DDSHeader::MAGIC, sizeof(DDSHeader::MAGIC));
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(image.data.data()), (std::streamsize)image.data.size());
+
+		if (!stream.good())
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	return !error;
+}
+
+uint32_t TextureCache::getBlockBytes(TextureCompression format)
+{
+	return (format == TextureCompression::BC1 || format == TextureCompression::BC4) ? 8 : 16;
+}
+
+size_t TextureCache::getLevelBytes(TextureCompression format, uint32_t width, uint32_t height)
+{
+	const size_t blocksX = (width + 3) / 4;
+	const size_t blocksY = (height + 3) / 4;
+
+	return blocksX * blocksY * getBlockBytes(format);
+}
+
+uint32_t TextureCache::getLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t count = 1;
+
+	while (width > 1 || height > 1)
+	{
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		count++;
+	}
+
+	return count;
+}
+
+// Private utility function - FourCC code of a format in the DDS header
+uint32_t TextureCache::GetFourCC(TextureCompression format)
+{
+	const char* codes[] = { "DXT1", "DXT5", "ATI1", "ATI2" };
+	const char* code = codes[(uint32_t)format];
+
+	return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+// Private utility function - to get the values the cache file is keyed on
+bool TextureCache::GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& time)
+{
+	std::error_code error;
+
+	size = (uint64_t)std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return false;
+
+	time = (int64_t)std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+	return !error;
+}
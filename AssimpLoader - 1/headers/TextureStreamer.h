@@ -0,0 +1,426 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "stb_image_impl.h"
+#include "JobSystem.h"
+#include "GLState.h"
+#include "CompressedTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// State of a texture loaded through TextureStreamer
+struct StreamedTexture
+{
+	std::string path;
+
+	// Texture holding the image, 0 until its upload starts
+	unsigned int id = 0;
+
+	// Shown while the image isn't resident
+	unsigned int placeholderID = 0;
+
+	bool bResident = false;
+};
+
+/**
+  * Handle of a texture loaded through TextureStreamer. It can be used right away: getID() returns a placeholder
+  * texture until the image has been decoded and uploaded, then the real texture. Handles stay valid until
+  * TextureStreamer::free() is called.
+  */
+class TextureHandle
+{
+private:
+	friend class TextureStreamer;
+
+	const StreamedTexture* m_Texture = nullptr;
+
+public:
+	TextureHandle() = default;
+
+	unsigned int getID() const { return m_Texture->bResident ? m_Texture->id : m_Texture->placeholderID; }
+	bool isResident() const { return m_Texture && m_Texture->bResident; }
+
+	explicit operator bool() const { return m_Texture != nullptr; }
+};
+
+/**
+  * Loads textures without blocking the GL thread.
+  *
+  * Images are decoded with stb_image on the workers of a JobSystem. Decoded images are uploaded in update(), which
+  * copies rows into a pixel buffer object and lets glTexSubImage2D read them from there. Every call uploads at most
+  * 'bytesPerFrame' bytes, so a large image is spread over several frames instead of stalling one.
+  *
+  * Images with an up-to-date compressed texture (see TextureCache.h) skip decoding: the worker only maps the file,
+  * and update() hands it to glCompressedTexImage2D a mip level at a time.
+  */
+class TextureStreamer
+{
+private:
+	// Decoded image, travels from the decoding job to its completion
+	struct DecodedImage
+	{
+		unsigned char* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+
+		// Set instead of the pixels if the image has a compressed texture
+		std::shared_ptr<TextureFileView> compressed;
+
+		DecodedImage() = default;
+		DecodedImage(const DecodedImage&) = delete;
+		DecodedImage& operator=(const DecodedImage&) = delete;
+
+		~DecodedImage()
+		{
+			if (pixels)
+				stbi_image_free(pixels);
+		}
+	};
+
+	struct PendingUpload
+	{
+		StreamedTexture* texture = nullptr;
+		unsigned char* pixels = nullptr;
+		int width = 0, height = 0, channels = 0;
+
+		// First row which hasn't been uploaded yet
+		int nextRow = 0;
+
+		// Compressed textures are uploaded a mip level at a time instead of by rows
+		std::shared_ptr<TextureFileView> compressed;
+		uint32_t nextLevel = 0;
+	};
+
+	JobSystem* m_Jobs = nullptr;
+
+	// Deque, so that the handles' pointers stay valid as textures are added
+	std::deque<StreamedTexture> m_Textures;
+	std::unordered_map<std::string, StreamedTexture*> m_TexturesByPath;
+
+	std::deque<PendingUpload> m_Uploads;
+
+	unsigned int m_PlaceholderID = 0;
+
+	// Two pixel buffers used in turns, so that filling one doesn't wait for the upload from the other
+	unsigned int m_PixelBuffers[2] = { 0, 0 };
+	size_t m_PixelBufferBytes = 0;
+	int m_CurrentPixelBuffer = 0;
+
+	size_t m_BytesPerFrame = 0;
+	size_t m_PendingCount = 0;
+
+public:
+	TextureStreamer() = default;
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	void init(JobSystem& jobs, size_t bytesPerFrame = 4 * 1024 * 1024);
+
+	// Starts loading a texture. Loading the same path again returns the same handle.
+	TextureHandle load(const std::string& texturePath, bool bFlipVertically = true);
+
+	// Uploads the next slice of the decoded images. Call once per frame on the GL thread, after JobSystem::processCompleted().
+	void update();
+
+	// Number of textures which aren't resident yet
+	size_t getPendingCount() const;
+
+	// Deletes all textures. Shut the job system down first, its completions refer to the streamer.
+	void free();
+
+private:
+	void Submit(StreamedTexture* target, bool bFlipVertically, bool bUseCache);
+	void StartUpload(PendingUpload& upload);
+	size_t UploadRows(PendingUpload& upload, size_t budget);
+	size_t UploadLevel(PendingUpload& upload);
+	void FinishUpload(PendingUpload& upload);
+
+	static GLenum GetFormat(int channels);
+};
+
+void TextureStreamer::init(JobSystem& jobs, size_t bytesPerFrame)
+{
+	m_Jobs = &jobs;
+	m_BytesPerFrame = bytesPerFrame;
+
+	// Grey 1x1 texture
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+
+	glGenTextures(1, &m_PlaceholderID);
+	GLState::get().bindTexture(GL_TEXTURE_2D, m_PlaceholderID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenBuffers(2, m_PixelBuffers);
+	m_PixelBufferBytes = bytesPerFrame;
+
+	for (unsigned int pixelBuffer : m_PixelBuffers)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, m_PixelBufferBytes, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureHandle TextureStreamer::load(const std::string& texturePath, bool bFlipVertically)
+{
+	TextureHandle handle;
+
+	auto found = m_TexturesByPath.find(texturePath);
+	if (found != m_TexturesByPath.end())
+	{
+		handle.m_Texture = found->second;
+		return handle;
+	}
+
+	StreamedTexture& texture = m_Textures.emplace_back();
+	texture.path = texturePath;
+	texture.placeholderID = m_PlaceholderID;
+
+	m_TexturesByPath[texturePath] = &texture;
+	m_PendingCount++;
+
+	Submit(&texture, bFlipVertically, true);
+
+	handle.m_Texture = &texture;
+	return handle;
+}
+
+void TextureStreamer::update()
+{
+	if (m_Uploads.empty())
+		return;
+
+	size_t budget = m_BytesPerFrame;
+
+	// Rows of RGB images aren't necessarily a multiple of 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	while (budget > 0 && !m_Uploads.empty())
+	{
+		PendingUpload& upload = m_Uploads.front();
+
+		if (upload.nextRow == 0 && upload.nextLevel == 0)
+			StartUpload(upload);
+
+		const size_t bytes = upload.compressed ? UploadLevel(upload) : UploadRows(upload, budget);
+		budget -= std::min(budget, bytes);
+
+		const bool bDone = upload.compressed ? upload.nextLevel >= upload.compressed->levelCount() : upload.nextRow >= upload.height;
+		if (bDone)
+		{
+			FinishUpload(upload);
+			m_Uploads.pop_front();
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+size_t TextureStreamer::getPendingCount() const
+{
+	return m_PendingCount;
+}
+
+void TextureStreamer::free()
+{
+	for (auto& upload : m_Uploads)
+		stbi_image_free(upload.pixels);
+
+	m_Uploads.clear();
+
+	for (auto& texture : m_Textures)
+	{
+		if (texture.id)
+			GLState::get().deleteTextures(1, &texture.id);
+	}
+
+	m_Textures.clear();
+	m_TexturesByPath.clear();
+	m_PendingCount = 0;
+
+	if (m_PlaceholderID)
+	{
+		GLState::get().deleteTextures(1, &m_PlaceholderID);
+		glDeleteBuffers(2, m_PixelBuffers);
+
+		m_PlaceholderID = 0;
+		m_PixelBuffers[0] = m_PixelBuffers[1] = 0;
+	}
+}
+
+// Private utility function - queues the decoding of 'target'. Tries the compressed texture first if 'bUseCache' is set.
+void TextureStreamer::Submit(StreamedTexture* target, bool bFlipVertically, bool bUseCache)
+{
+	const std::string texturePath = target->path;
+
+	m_Jobs->submit<DecodedImage>(
+		[texturePath, bFlipVertically, bUseCache](DecodedImage& image)
+		{
+			if (bUseCache)
+			{
+				auto view = std::make_shared<TextureFileView>();
+				if (TextureCache::load(texturePath, bFlipVertically, *view))
+				{
+					image.compressed = std::move(view);
+					image.width = (int)image.compressed->width();
+					image.height = (int)image.compressed->height();
+					return;
+				}
+			}
+
+			// The flip flag of stb_image is global unless it is set per thread
+			stbi_set_flip_vertically_on_load_thread(bFlipVertically);
+			image.pixels = stbi_load(texturePath.c_str(), &image.width, &image.height, &image.channels, 0);
+		},
+		[this, target, bFlipVertically](DecodedImage& image)
+		{
+			if (image.compressed)
+			{
+				// Extensions can only be queried here, on the GL thread
+				if (CompressedTexture::isSupported(image.compressed->format()))
+					m_Uploads.push_back({ target, nullptr, image.width, image.height, 0, 0, std::move(image.compressed), 0 });
+				else
+					Submit(target, bFlipVertically, false);
+
+				return;
+			}
+
+			if (!image.pixels || GetFormat(image.channels) == 0)
+			{
+				// Keeps showing the placeholder
+				std::cout << "Texture failed to load at path: " << target->path << std::endl;
+				m_PendingCount--;
+				return;
+			}
+
+			m_Uploads.push_back({ target, image.pixels, image.width, image.height, image.channels, 0, nullptr, 0 });
+
+			// The pixels belong to the upload now
+			image.pixels = nullptr;
+		});
+}
+
+// Private utility function - to allocate the texture storage before the first slice
+void TextureStreamer::StartUpload(PendingUpload& upload)
+{
+	glGenTextures(1, &upload.texture->id);
+	GLState::get().bindTexture(GL_TEXTURE_2D, upload.texture->id);
+
+	// Compressed levels are allocated as they are uploaded
+	if (upload.compressed)
+		return;
+
+	const GLenum format = GetFormat(upload.channels);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, upload.width, upload.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+}
+
+// Private utility function - uploads the next rows of a decoded image through a pixel buffer, returns the bytes uploaded
+size_t TextureStreamer::UploadRows(PendingUpload& upload, size_t budget)
+{
+	const size_t rowBytes = (size_t)upload.width * upload.channels;
+
+	// At least one row, so that every call makes progress
+	int rows = (int)std::min(budget, m_PixelBufferBytes) / (int)rowBytes;
+	rows = std::clamp(rows, 1, upload.height - upload.nextRow);
+
+	const size_t bytes = rows * rowBytes;
+
+	const unsigned int pixelBuffer = m_PixelBuffers[m_CurrentPixelBuffer];
+	m_CurrentPixelBuffer ^= 1;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+
+	// Orphan the old storage (which may still be read by a previous upload), grow it for very wide images
+	m_PixelBufferBytes = std::max(m_PixelBufferBytes, bytes);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, m_PixelBufferBytes, nullptr, GL_STREAM_DRAW);
+
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped)
+	{
+		memcpy(mapped, upload.pixels + upload.nextRow * rowBytes, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// With a pixel unpack buffer bound, the last argument is an offset into it
+		GLState::get().bindTexture(GL_TEXTURE_2D, upload.texture->id);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.nextRow, upload.width, rows, GetFormat(upload.channels), GL_UNSIGNED_BYTE, (const void*)0);
+	}
+
+	upload.nextRow += rows;
+	return bytes;
+}
+
+// Private utility function - uploads the next mip level of a compressed texture, returns the bytes uploaded
+size_t TextureStreamer::UploadLevel(PendingUpload& upload)
+{
+	uint32_t width, height;
+	size_t bytes;
+	upload.compressed->level(upload.nextLevel, width, height, bytes);
+
+	// The levels are read straight from the mapped file, not from a pixel buffer
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	GLState::get().bindTexture(GL_TEXTURE_2D, upload.texture->id);
+	CompressedTexture::uploadLevels(*upload.compressed, upload.nextLevel, 1);
+
+	upload.nextLevel++;
+	return bytes;
+}
+
+// Private utility function - called after the last slice, from then on handles return the real texture
+void TextureStreamer::FinishUpload(PendingUpload& upload)
+{
+	GLState::get().bindTexture(GL_TEXTURE_2D, upload.texture->id);
+
+	// Compressed textures bring their own mip levels
+	if (upload.compressed)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)upload.compressed->levelCount() - 1);
+	else
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	stbi_image_free(upload.pixels);
+	upload.pixels = nullptr;
+	upload.compressed.reset();
+
+	upload.texture->bResident = true;
+	m_PendingCount--;
+}
+
+// Private utility function - OpenGL format for a number of channels, 0 if there is none
+GLenum TextureStreamer::GetFormat(int channels)
+{
+	switch (channels)
+	{
+	case 1:
+		return GL_RED;
+
+	case 2:
+		return GL_RG;
+
+	case 3:
+		return GL_RGB;
+
+	case 4:
+		return GL_RGBA;
+
+	default:
+		return 0;
+	}
+}
@@ -8,7 +8,7 @@
 #include "VertexArray.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
-#include "BufferLayout.h"
+#include "VertexFormat.h"
 #include "Texture2D.h"
 #include "Shader.h"
 #include "Camera.h"
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "Shader.h"
+#include "VertexFormat.h"
+
+/**
+  * Smaller vertices for meshes, which are decoded by the vertex shader.
+  *
+  * Positions are stored as 16-bit unsigned normalized values relative to the bounding box of the mesh, and texture
+  * coordinates relative to their own range in the mesh. The hardware turns them into [0, 1] and the shader maps
+  * them back with the uniforms set by VertexDecode::apply():
+  *
+  *		vec3 vPosition = vPositionOffset + vPos * vPositionScale;
+  *
+  * Normals and tangents are unit vectors, stored in 10 bits per component (GL_INT_2_10_10_10_REV) which the
+  * hardware turns into [-1, 1] without help from the shader. The 2-bit w of the tangent keeps the handedness of
+  * the bitangent, which is cross(normal, tangent) * w.
+  *
+  * Uncompressed meshes use the identity decode, so the same shader draws both.
+  */
+
+// Maps the stored [0, 1] values of a compressed mesh back to model space, the identity for uncompressed meshes
+struct VertexDecode
+{
+	glm::vec3 vPositionOffset = glm::vec3(0.0f);
+	glm::vec3 vPositionScale = glm::vec3(1.0f);
+
+	glm::vec2 vTexCoordOffset = glm::vec2(0.0f);
+	glm::vec2 vTexCoordScale = glm::vec2(1.0f);
+
+	// Decode covering the bounds of the positions and texture coordinates of a mesh
+	static VertexDecode fromBounds(const glm::vec3& vMinPosition, const glm::vec3& vMaxPosition, const glm::vec2& vMinTexCoord, const glm::vec2& vMaxTexCoord);
+
+	glm::u16vec4 encodePosition(const glm::vec3& vPosition) const;
+	glm::u16vec2 encodeTexCoords(const glm::vec2& vTexCoords) const;
+
+	// What the shader gets back from encodePosition()
+	glm::vec3 decodePosition(const glm::u16vec4& position) const;
+
+	// Sets the uniforms of the same names, the shader has to be in use
+	void apply(Shader& shader) const;
+
+private:
+	static uint16_t Quantize(float fValue, float fOffset, float fScale);
+};
+
+// Vertex of a compressed Mesh (see Mesh.h), 20 bytes instead of 88
+struct CompressedVertex
+{
+	glm::u16vec4 position;		// w is unused, it keeps the following attributes 4-byte aligned
+	Packed1010102 normal;
+	Packed1010102 tangent;		// w is the handedness of the bitangent
+	glm::u16vec2 texCoords;
+};
+
+// Bone attributes of a compressed Mesh, in a second stream which is only there if the mesh has bones
+struct SkinVertex
+{
+	glm::i16vec4 boneIDs;
+	glm::u8vec4 weights;
+};
+
+// Vertices of a compressed SimpleModel (see SimpleModel.h), 12 or 16 bytes instead of 24 or 32
+struct CompressedMeshVertex
+{
+	glm::u16vec4 position;
+	Packed1010102 normal;
+};
+
+struct CompressedTexturedMeshVertex
+{
+	glm::u16vec4 position;
+	Packed1010102 normal;
+	glm::u16vec2 texCoords;
+};
+
+// Locations match the uncompressed vertices, so that shaders don't have to know which one they are drawing
+template<>
+struct VertexFormat<CompressedVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::u16vec4>(0, offsetof(CompressedVertex, position), AttributeMode::NORMALIZED),
+		VertexAttribute::of<Packed1010102>(1, offsetof(CompressedVertex, normal), AttributeMode::NORMALIZED),
+		VertexAttribute::of<glm::u16vec2>(2, offsetof(CompressedVertex, texCoords), AttributeMode::NORMALIZED),
+		VertexAttribute::of<Packed1010102>(3, offsetof(CompressedVertex, tangent), AttributeMode::NORMALIZED)
+	};
+};
+
+template<>
+struct VertexFormat<SkinVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::i16vec4>(5, offsetof(SkinVertex, boneIDs), AttributeMode::INTEGER),
+		VertexAttribute::of<glm::u8vec4>(6, offsetof(SkinVertex, weights), AttributeMode::NORMALIZED)
+	};
+};
+
+template<>
+struct VertexFormat<CompressedMeshVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::u16vec4>(0, offsetof(CompressedMeshVertex, position), AttributeMode::NORMALIZED),
+		VertexAttribute::of<Packed1010102>(1, offsetof(CompressedMeshVertex, normal), AttributeMode::NORMALIZED)
+	};
+};
+
+template<>
+struct VertexFormat<CompressedTexturedMeshVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::u16vec4>(0, offsetof(CompressedTexturedMeshVertex, position), AttributeMode::NORMALIZED),
+		VertexAttribute::of<Packed1010102>(1, offsetof(CompressedTexturedMeshVertex, normal), AttributeMode::NORMALIZED),
+		VertexAttribute::of<glm::u16vec2>(2, offsetof(CompressedTexturedMeshVertex, texCoords), AttributeMode::NORMALIZED)
+	};
+};
+
+// Vertex data of a model before and after compression, summed over its meshes
+struct VertexCompressionStats
+{
+	size_t vertexCount = 0;
+	size_t rawBytes = 0;
+	size_t compressedBytes = 0;
+
+	// Largest distance between a position and its decoded value, in model units
+	float fMaxPositionError = 0.0f;
+
+	void add(const VertexCompressionStats& stats);
+
+	void print(const std::string& modelName) const;
+};
+
+VertexDecode VertexDecode::fromBounds(const glm::vec3& vMinPosition, const glm::vec3& vMaxPosition, const glm::vec2& vMinTexCoord, const glm::vec2& vMaxTexCoord)
+{
+	VertexDecode decode;
+
+	// A flat side of the box still needs a scale which isn't 0
+	decode.vPositionOffset = vMinPosition;
+	decode.vPositionScale = glm::max(vMaxPosition - vMinPosition, glm::vec3(1e-6f));
+
+	decode.vTexCoordOffset = vMinTexCoord;
+	decode.vTexCoordScale = glm::max(vMaxTexCoord - vMinTexCoord, glm::vec2(1e-6f));
+
+	return decode;
+}
+
+glm::u16vec4 VertexDecode::encodePosition(const glm::vec3& vPosition) const
+{
+	return glm::u16vec4(
+		Quantize(vPosition.x, vPositionOffset.x, vPositionScale.x),
+		Quantize(vPosition.y, vPositionOffset.y, vPositionScale.y),
+		Quantize(vPosition.z, vPositionOffset.z, vPositionScale.z),
+		0);
+}
+
+glm::u16vec2 VertexDecode::encodeTexCoords(const glm::vec2& vTexCoords) const
+{
+	return glm::u16vec2(
+		Quantize(vTexCoords.x, vTexCoordOffset.x, vTexCoordScale.x),
+		Quantize(vTexCoords.y, vTexCoordOffset.y, vTexCoordScale.y));
+}
+
+glm::vec3 VertexDecode::decodePosition(const glm::u16vec4& position) const
+{
+	return vPositionOffset + glm::vec3(position) / 65535.0f * vPositionScale;
+}
+
+void VertexDecode::apply(Shader& shader) const
+{
+	shader.setVec3("vPositionOffset", vPositionOffset);
+	shader.setVec3("vPositionScale", vPositionScale);
+	shader.setVec2("vTexCoordOffset", vTexCoordOffset);
+	shader.setVec2("vTexCoordScale", vTexCoordScale);
+}
+
+// Private utility function - 'fValue' in [fOffset, fOffset + fScale] to 16-bit unsigned normalized, rounded to the nearest
+uint16_t VertexDecode::Quantize(float fValue, float fOffset, float fScale)
+{
+	const float fNormalized = std::clamp((fValue - fOffset) / fScale, 0.0f, 1.0f);
+	return (uint16_t)(fNormalized * 65535.0f + 0.5f);
+}
+
+void VertexCompressionStats::add(const VertexCompressionStats& stats)
+{
+	vertexCount += stats.vertexCount;
+	rawBytes += stats.rawBytes;
+	compressedBytes += stats.compressedBytes;
+	fMaxPositionError = std::max(fMaxPositionError, stats.fMaxPositionError);
+}
+
+void VertexCompressionStats::print(const std::string& modelName) const
+{
+	const float fRawKB = (float)rawBytes / 1024.0f;
+	const float fCompressedKB = (float)compressedBytes / 1024.0f;
+
+	std::cout << "Vertices of " << modelName << ": " << vertexCount << ", " << std::fixed << std::setprecision(1) << fRawKB << " KB -> " << fCompressedKB << " KB";
+
+	if (rawBytes > 0)
+		std::cout << " (" << std::setprecision(1) << 100.0f * (float)compressedBytes / (float)rawBytes << "%)";
+
+	std::cout << ", max position error " << std::scientific << std::setprecision(2) << fMaxPositionError << std::defaultfloat << std::endl;
+}
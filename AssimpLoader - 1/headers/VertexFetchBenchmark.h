@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "AssimpModelLoader.h"
+#include "Shader.h"
+#include "TextureStreamer.h"
+
+// Timing of one vertex format
+struct VertexFetchResult
+{
+	size_t vertexCount = 0;
+	size_t vertexBytes = 0;
+
+	// GPU time of one draw of the whole model
+	float fDrawMs = 0.0f;
+};
+
+/**
+  * Measures how long the GPU takes to fetch and transform the vertices of a model, once with the full vertices and
+  * once with the compressed ones (see VertexCompression.h).
+  *
+  * The model is drawn into a 1x1 viewport so that hardly any fragments are shaded, and the time is spent on the
+  * vertices. The GPU time comes from a GL_TIME_ELAPSED query around all the draws. Software renderers which
+  * don't time their work report 0 there, then the time until glFinish() returns is taken instead.
+  */
+class VertexFetchBenchmark
+{
+public:
+	// Loads 'modelPath' in both formats and draws each of them 'nDraws' times with 'shader', which has to decode
+	// compressed vertices. The textures go through 'streamer', they don't matter for the timings.
+	static void run(const std::string& modelPath, Shader& shader, TextureStreamer& streamer, int nDraws);
+
+private:
+	static VertexFetchResult Measure(Model& model, Shader& shader, int nDraws);
+	static void PrintResult(const char* name, const VertexFetchResult& result);
+};
+
+void VertexFetchBenchmark::run(const std::string& modelPath, Shader& shader, TextureStreamer& streamer, int nDraws)
+{
+	Model fullModel;
+	fullModel.load(modelPath, streamer);
+
+	Model compressedModel;
+	compressedModel.compressVertices = true;
+	compressedModel.load(modelPath, streamer);
+
+	const VertexFetchResult full = Measure(fullModel, shader, nDraws);
+	const VertexFetchResult compressed = Measure(compressedModel, shader, nDraws);
+
+	fullModel.free();
+	compressedModel.free();
+
+	std::cout << "\n---------- Vertex fetch ----------\n";
+	std::cout << modelPath << ", " << nDraws << " draws of " << full.vertexCount << " vertices\n";
+	PrintResult("Full:       ", full);
+	PrintResult("Compressed: ", compressed);
+
+	if (compressed.fDrawMs > 0.0f)
+		std::cout << "Speedup:    " << std::fixed << std::setprecision(2) << full.fDrawMs / compressed.fDrawMs << "x\n";
+
+	std::cout << "----------------------------------\n" << std::endl;
+}
+
+// Private utility function - draws 'model' 'nDraws' times into a 1x1 viewport and times it on the GPU
+VertexFetchResult VertexFetchBenchmark::Measure(Model& model, Shader& shader, int nDraws)
+{
+	VertexFetchResult result;
+
+	for (const Mesh& mesh : model.meshes)
+		result.vertexCount += mesh.vertices.size();
+
+	result.vertexBytes = model.compressVertices ? model.compressionStats.compressedBytes : result.vertexCount * sizeof(Vertex);
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glViewport(0, 0, 1, 1);
+
+	shader.use();
+	shader.setMat4("matModel", glm::mat4(1.0f));
+
+	// The first draw may still be waiting for the buffers to be uploaded
+	model.Draw(shader);
+	glFinish();
+
+	unsigned int query = 0;
+	glGenQueries(1, &query);
+
+	auto tStart = std::chrono::steady_clock::now();
+
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	for (int i = 0; i < nDraws; i++)
+		model.Draw(shader);
+	glEndQuery(GL_TIME_ELAPSED);
+
+	glFinish();
+	std::chrono::duration<float, std::milli> wallTime = std::chrono::steady_clock::now() - tStart;
+
+	GLuint64 elapsedNs = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+	glDeleteQueries(1, &query);
+
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	// Less than a microsecond per draw means the query didn't time anything
+	float fTotalMs = (float)elapsedNs / 1e6f;
+	if (fTotalMs < 0.001f * (float)nDraws)
+		fTotalMs = wallTime.count();
+
+	result.fDrawMs = nDraws > 0 ? fTotalMs / (float)nDraws : 0.0f;
+	return result;
+}
+
+// Private utility function - one line of the report
+void VertexFetchBenchmark::PrintResult(const char* name, const VertexFetchResult& result)
+{
+	const float fBytesPerVertex = result.vertexCount ? (float)result.vertexBytes / (float)result.vertexCount : 0.0f;
+	const float fVerticesPerSecond = result.fDrawMs > 0.0f ? (float)result.vertexCount / (result.fDrawMs / 1000.0f) : 0.0f;
+
+	std::cout << name << std::fixed << std::setprecision(1) << fBytesPerVertex << " bytes per vertex, " << (float)result.vertexBytes / (1024.0f * 1024.0f) << " MB, "
+		<< std::setprecision(3) << result.fDrawMs << " ms per draw, " << std::setprecision(1) << fVerticesPerSecond / 1e6f << " M vertices/s\n";
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GLState.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+/**
+  * Vertex layouts described by the vertex struct itself.
+  *
+  * A vertex type lists its attributes once, in a specialization of VertexFormat:
+  *
+  *		struct LitVertex { glm::vec3 vPosition; Packed1010102 normal; glm::u16vec2 texCoords; };
+  *
+  *		template<>
+  *		struct VertexFormat<LitVertex>
+  *		{
+  *			static constexpr VertexAttribute ATTRIBUTES[] = {
+  *				VertexAttribute::of<glm::vec3>(0, offsetof(LitVertex, vPosition)),
+  *				VertexAttribute::of<Packed1010102>(1, offsetof(LitVertex, normal), AttributeMode::NORMALIZED),
+  *				VertexAttribute::of<glm::u16vec2>(2, offsetof(LitVertex, texCoords), AttributeMode::NORMALIZED)
+  *			};
+  *		};
+  *
+  * The GL type, component count and size come from the member type, the stride is sizeof(LitVertex). The table is
+  * checked at compile time (see VertexLayout::isValid()), and VertexLayout::apply<LitVertex>() sets it up on a VAO.
+  * Per-instance data is a vertex type of its own in a second buffer, with a divisor of 1.
+  */
+
+// How the shader sees the components of an attribute
+enum class AttributeMode
+{
+	FLOAT,			// Converted to float as they are
+	NORMALIZED,		// Fixed point to [0, 1] (unsigned) or [-1, 1] (signed), integer and packed types only
+	INTEGER			// Read as int/uint by the shader (glVertexAttribIPointer), integer types only
+};
+
+// Four half floats, filled with Half4::pack()
+struct Half4
+{
+	uint16_t x = 0, y = 0, z = 0, w = 0;
+
+	static Half4 pack(const glm::vec4& v);
+};
+
+// Two half floats, filled with Half2::pack()
+struct Half2
+{
+	uint16_t x = 0, y = 0;
+
+	static Half2 pack(const glm::vec2& v);
+};
+
+// x, y and z in 10 signed bits and w in 2, as GL_INT_2_10_10_10_REV. Used normalized, for unit vectors.
+struct Packed1010102
+{
+	uint32_t bits = 0;
+
+	static Packed1010102 pack(const glm::vec4& v);
+
+	// 'v' normalized, 0 if it has no length. 'fW' is -1, 0 or 1.
+	static Packed1010102 packDirection(const glm::vec3& v, float fW = 0.0f);
+};
+
+// GL description of the member types an attribute can have, only the specialized types can be used
+template<typename T>
+struct AttributeTraits;
+
+template<GLenum Type, GLint Count, bool bIntegral, bool bPacked = false, GLint Columns = 1>
+struct AttributeTraitsBase
+{
+	static constexpr GLenum TYPE = Type;
+	static constexpr GLint COUNT = Count;
+	static constexpr GLint COLUMNS = Columns;
+
+	// Integer types can be normalized or read as integers, packed types only normalized or converted
+	static constexpr bool INTEGRAL = bIntegral;
+	static constexpr bool PACKED = bPacked;
+};
+
+template<> struct AttributeTraits<float> : AttributeTraitsBase<GL_FLOAT, 1, false> {};
+template<> struct AttributeTraits<glm::vec2> : AttributeTraitsBase<GL_FLOAT, 2, false> {};
+template<> struct AttributeTraits<glm::vec3> : AttributeTraitsBase<GL_FLOAT, 3, false> {};
+template<> struct AttributeTraits<glm::vec4> : AttributeTraitsBase<GL_FLOAT, 4, false> {};
+
+// Matrices take one location per column
+template<> struct AttributeTraits<glm::mat3> : AttributeTraitsBase<GL_FLOAT, 3, false, false, 3> {};
+template<> struct AttributeTraits<glm::mat4> : AttributeTraitsBase<GL_FLOAT, 4, false, false, 4> {};
+
+template<> struct AttributeTraits<Half2> : AttributeTraitsBase<GL_HALF_FLOAT, 2, false> {};
+template<> struct AttributeTraits<Half4> : AttributeTraitsBase<GL_HALF_FLOAT, 4, false> {};
+template<> struct AttributeTraits<Packed1010102> : AttributeTraitsBase<GL_INT_2_10_10_10_REV, 4, false, true> {};
+
+template<> struct AttributeTraits<int> : AttributeTraitsBase<GL_INT, 1, true> {};
+template<> struct AttributeTraits<glm::ivec4> : AttributeTraitsBase<GL_INT, 4, true> {};
+template<> struct AttributeTraits<glm::uvec4> : AttributeTraitsBase<GL_UNSIGNED_INT, 4, true> {};
+
+template<> struct AttributeTraits<glm::u8vec4> : AttributeTraitsBase<GL_UNSIGNED_BYTE, 4, true> {};
+template<> struct AttributeTraits<glm::i8vec4> : AttributeTraitsBase<GL_BYTE, 4, true> {};
+
+template<> struct AttributeTraits<glm::u16vec2> : AttributeTraitsBase<GL_UNSIGNED_SHORT, 2, true> {};
+template<> struct AttributeTraits<glm::i16vec2> : AttributeTraitsBase<GL_SHORT, 2, true> {};
+template<> struct AttributeTraits<glm::u16vec4> : AttributeTraitsBase<GL_UNSIGNED_SHORT, 4, true> {};
+template<> struct AttributeTraits<glm::i16vec4> : AttributeTraitsBase<GL_SHORT, 4, true> {};
+
+struct VertexAttribute
+{
+	GLuint location = 0;
+	GLint count = 0;
+	GLenum type = GL_FLOAT;
+	AttributeMode mode = AttributeMode::FLOAT;
+
+	// 0 advances every vertex, N every N instances
+	GLuint divisor = 0;
+
+	// Byte offset in the vertex and size of the member
+	size_t offset = 0;
+	size_t bytes = 0;
+
+	GLint columns = 1;
+
+	bool bIntegral = false;
+	bool bPacked = false;
+
+	// Attribute at 'location' of the member type 'T', at 'offset' in the vertex
+	template<typename T>
+	static constexpr VertexAttribute of(GLuint location, size_t offset, AttributeMode mode = AttributeMode::FLOAT, GLuint divisor = 0);
+};
+
+// Attribute table of 'Vertex', specialized next to each vertex type
+template<typename Vertex>
+struct VertexFormat;
+
+class VertexLayout
+{
+public:
+	// Compile time check of the attribute table of 'Vertex': members inside the struct, modes which fit the types,
+	// and no two attributes on the same location
+	template<typename Vertex>
+	static constexpr bool isValid();
+
+	// Number of locations used, matrices count one per column
+	template<typename Vertex>
+	static constexpr GLuint getLocationCount();
+
+	// Sets up the attributes of 'Vertex' on the vertex array, reading from 'buffer'. 'baseOffset' is the byte
+	// offset of the first vertex in the buffer. Leaves the vertex array bound.
+	template<typename Vertex>
+	static void apply(unsigned int vertexArray, unsigned int buffer, size_t baseOffset = 0);
+
+	template<typename Vertex, typename T>
+	static void apply(const VertexArray& va, const VertexBuffer<T>& buffer, size_t baseOffset = 0);
+};
+
+inline Half4 Half4::pack(const glm::vec4& v)
+{
+	return { glm::packHalf1x16(v.x), glm::packHalf1x16(v.y), glm::packHalf1x16(v.z), glm::packHalf1x16(v.w) };
+}
+
+inline Half2 Half2::pack(const glm::vec2& v)
+{
+	return { glm::packHalf1x16(v.x), glm::packHalf1x16(v.y) };
+}
+
+inline Packed1010102 Packed1010102::pack(const glm::vec4& v)
+{
+	return { glm::packSnorm3x10_1x2(v) };
+}
+
+inline Packed1010102 Packed1010102::packDirection(const glm::vec3& v, float fW)
+{
+	const float fLength = glm::length(v);
+	return pack(glm::vec4(fLength > 0.0f ? v / fLength : glm::vec3(0.0f), fW));
+}
+
+template<typename T>
+constexpr VertexAttribute VertexAttribute::of(GLuint location, size_t offset, AttributeMode mode, GLuint divisor)
+{
+	using Traits = AttributeTraits<T>;
+
+	VertexAttribute attribute;
+	attribute.location = location;
+	attribute.count = Traits::COUNT;
+	attribute.type = Traits::TYPE;
+	attribute.mode = mode;
+	attribute.divisor = divisor;
+	attribute.offset = offset;
+	attribute.bytes = sizeof(T);
+	attribute.columns = Traits::COLUMNS;
+	attribute.bIntegral = Traits::INTEGRAL;
+	attribute.bPacked = Traits::PACKED;
+
+	return attribute;
+}
+
+template<typename Vertex>
+constexpr bool VertexLayout::isValid()
+{
+	// Every GL 3.3 implementation has at least 16
+	constexpr GLuint MIN_MAX_VERTEX_ATTRIBS = 16;
+
+	const auto& attributes = VertexFormat<Vertex>::ATTRIBUTES;
+
+	for (const VertexAttribute& attribute : attributes)
+	{
+		if (attribute.count < 1 || attribute.count > 4 || attribute.columns < 1 || attribute.columns > 4)
+			return false;
+
+		if (attribute.offset + attribute.bytes > sizeof(Vertex))
+			return false;
+
+		if (attribute.location + attribute.columns > MIN_MAX_VERTEX_ATTRIBS)
+			return false;
+
+		if (attribute.mode == AttributeMode::INTEGER && !attribute.bIntegral)
+			return false;
+
+		if (attribute.mode == AttributeMode::NORMALIZED && !attribute.bIntegral && !attribute.bPacked)
+			return false;
+
+		for (const VertexAttribute& other : attributes)
+		{
+			if (&other == &attribute)
+				continue;
+
+			if (attribute.location < other.location + other.columns && other.location < attribute.location + attribute.columns)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename Vertex>
+constexpr GLuint VertexLayout::getLocationCount()
+{
+	GLuint count = 0;
+
+	for (const VertexAttribute& attribute : VertexFormat<Vertex>::ATTRIBUTES)
+		count += (GLuint)attribute.columns;
+
+	return count;
+}
+
+template<typename Vertex>
+void VertexLayout::apply(unsigned int vertexArray, unsigned int buffer, size_t baseOffset)
+{
+	static_assert(isValid<Vertex>(), "Invalid attribute table in VertexFormat");
+
+	// The buffer is bound once, each attribute keeps the buffer which was bound when it was set
+	GLState::get().bindVertexArray(vertexArray);
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	for (const VertexAttribute& attribute : VertexFormat<Vertex>::ATTRIBUTES)
+	{
+		const size_t columnBytes = attribute.bytes / attribute.columns;
+
+		for (GLint column = 0; column < attribute.columns; column++)
+		{
+			const GLuint location = attribute.location + column;
+			const void* pointer = (const void*)(baseOffset + attribute.offset + column * columnBytes);
+
+			glEnableVertexAttribArray(location);
+
+			if (attribute.mode == AttributeMode::INTEGER)
+				glVertexAttribIPointer(location, attribute.count, attribute.type, sizeof(Vertex), pointer);
+			else
+				glVertexAttribPointer(location, attribute.count, attribute.type, attribute.mode == AttributeMode::NORMALIZED ? GL_TRUE : GL_FALSE, sizeof(Vertex), pointer);
+
+			glVertexAttribDivisor(location, attribute.divisor);
+		}
+	}
+}
+
+template<typename Vertex, typename T>
+void VertexLayout::apply(const VertexArray& va, const VertexBuffer<T>& buffer, size_t baseOffset)
+{
+	apply<Vertex>(va.getID(), buffer.getID(), baseOffset);
+}
+
+// Positions only, like line_vertices
+struct PositionVertex
+{
+	glm::vec3 vPosition;
+};
+
+template<>
+struct VertexFormat<PositionVertex>
+{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		VertexAttribute::of<glm::vec3>(0, offsetof(PositionVertex, vPosition))
+	};
+};
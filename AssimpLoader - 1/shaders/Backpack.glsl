@@ -9,16 +9,26 @@ out vec3 vNormal;
 out vec3 vFragPos;
 
 uniform mat4 matModel;
+uniform mat3 matNormal;		// Transpose of the inverse of matModel, computed on the CPU
 uniform mat4 matView;
 uniform mat4 matProjection;
 
+// Compressed meshes store positions and texture coordinates in [0, 1] of their bounds (see VertexCompression.h),
+// the decode is the identity for the others
+uniform vec3 vPositionOffset;
+uniform vec3 vPositionScale;
+uniform vec2 vTexCoordOffset;
+uniform vec2 vTexCoordScale;
+
 void main()
 {
-	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
+	vec3 vPosition = vPositionOffset + vPos * vPositionScale;
+
+	gl_Position = matProjection * matView * matModel * vec4(vPosition, 1.0f);
 
-	TexCoords = vTexCoords;
-	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
-	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
+	TexCoords = vTexCoordOffset + vTexCoords * vTexCoordScale;
+	vNormal = matNormal * vNorm;
+	vFragPos = vec3(matModel * vec4(vPosition, 1.0f));
 }
 
 #endif
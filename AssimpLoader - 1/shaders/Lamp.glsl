@@ -6,9 +6,14 @@ uniform mat4 matModel;
 uniform mat4 matView;
 uniform mat4 matProjection;
 
+// Compressed meshes store positions in [0, 1] of their bounds (see VertexCompression.h), the decode is the
+// identity for the others
+uniform vec3 vPositionOffset;
+uniform vec3 vPositionScale;
+
 void main()
 {
-	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
+	gl_Position = matProjection * matView * matModel * vec4(vPositionOffset + vPos * vPositionScale, 1.0f);
 }
 #endif
 
@@ -0,0 +1,491 @@
+/**
+  * Offline compressor which turns images into block compressed textures with mip levels (see headers/TextureCache.h),
+  * so that they take a fraction of the video memory and are uploaded without decoding.
+  *
+  * Build from the project directory (no OpenGL needed), for example:
+  *		g++ -std=c++20 -O2 -Iheaders -I../externals tools/TextureCompressor.cpp -o TextureCompressor -pthread
+  *
+  * Usage: TextureCompressor [--force] [--no-flip] <image | directory>...
+  *	Directories are searched (non-recursively) for .png, .jpg and .tga files. Up-to-date textures are skipped unless
+  *	--force is given. Textures are flipped vertically like Texture2D::loadTexture() does by default, --no-flip
+  *	builds them for loaders which pass bFlipVertically = false.
+  *
+  * The format follows the channels of the image:
+  *	1 channel			BC4		(red)
+  *	2 channels			BC5		(red, green)
+  *	3 channels			BC1		(rgb)
+  *	4 channels			BC3		(rgb, alpha), BC1 if every pixel is opaque
+  */
+
+#include "../headers/TextureCache.h"
+#include "../headers/stb_image_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Uncompressed image, 'channels' bytes per pixel
+struct Image
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	int channels = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// Private utility function - next mip level, each pixel is the average of (up to) 2x2 pixels of 'source'
+static Image Downsample(const Image& source)
+{
+	Image result;
+	result.width = std::max(1u, source.width / 2);
+	result.height = std::max(1u, source.height / 2);
+	result.channels = source.channels;
+	result.pixels.resize((size_t)result.width * result.height * result.channels);
+
+	for (uint32_t y = 0; y < result.height; y++)
+	{
+		const uint32_t y0 = std::min(2 * y, source.height - 1);
+		const uint32_t y1 = std::min(2 * y + 1, source.height - 1);
+
+		for (uint32_t x = 0; x < result.width; x++)
+		{
+			const uint32_t x0 = std::min(2 * x, source.width - 1);
+			const uint32_t x1 = std::min(2 * x + 1, source.width - 1);
+
+			for (int c = 0; c < source.channels; c++)
+			{
+				auto at = [&](uint32_t px, uint32_t py) { return (uint32_t)source.pixels[((size_t)py * source.width + px) * source.channels + c]; };
+
+				const uint32_t sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+				result.pixels[((size_t)y * result.width + x) * result.channels + c] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+
+	return result;
+}
+
+// Private utility function - the 4x4 block at (bx, by) as RGBA, clamped at the edges of images which aren't a multiple of 4
+static void FetchBlock(const Image& image, uint32_t bx, uint32_t by, uint8_t block[16][4])
+{
+	for (int i = 0; i < 16; i++)
+	{
+		const uint32_t x = std::min(bx * 4 + i % 4, image.width - 1);
+		const uint32_t y = std::min(by * 4 + i / 4, image.height - 1);
+		const uint8_t* pixel = &image.pixels[((size_t)y * image.width + x) * image.channels];
+
+		block[i][0] = pixel[0];
+		block[i][1] = image.channels > 1 ? pixel[1] : 0;
+		block[i][2] = image.channels > 2 ? pixel[2] : 0;
+		block[i][3] = image.channels > 3 ? pixel[3] : 255;
+	}
+}
+
+// Private utility function - packs a color into RGB 5:6:5, rounding to the nearest value
+static uint16_t PackColor(const float color[3])
+{
+	const int r = std::clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+	const int g = std::clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+	const int b = std::clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// Private utility function - expands RGB 5:6:5 back to 8 bits per channel, like the hardware does
+static void UnpackColor(uint16_t packed, int color[3])
+{
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+/**
+  * Private utility function - encodes the rgb of a block into 8 bytes of BC1.
+  *
+  * The endpoints are the extremes of the colors along their principal axis, pulled in by 1/16 of the range since
+  * the extremes themselves are rarely hit exactly after quantization. The endpoints are ordered so that
+  * color0 > color1, which selects the 4 color mode (the 3 color mode would turn index 3 into black).
+  */
+static void EncodeBC1(const uint8_t block[16][4], uint8_t* output)
+{
+	float mean[3] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			mean[c] += block[i][c] / 16.0f;
+	}
+
+	// Covariance of the colors: xx, xy, xz, yy, yz, zz
+	float cov[6] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		const float r = block[i][0] - mean[0];
+		const float g = block[i][1] - mean[1];
+		const float b = block[i][2] - mean[2];
+
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+
+	// Principal axis by power iteration, starting from the luminance direction
+	float axis[3] = { 0.299f, 0.587f, 0.114f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+		const float fLength = std::max({ std::fabs(x), std::fabs(y), std::fabs(z) });
+		if (fLength < 1e-6f)
+			break;
+
+		axis[0] = x / fLength;
+		axis[1] = y / fLength;
+		axis[2] = z / fLength;
+	}
+
+	float fMin = 0.0f, fMax = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		const float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+		fMin = std::min(fMin, t);
+		fMax = std::max(fMax, t);
+	}
+
+	const float fInset = (fMax - fMin) / 16.0f;
+	fMin += fInset;
+	fMax -= fInset;
+
+	float endpoint0[3], endpoint1[3];
+	for (int c = 0; c < 3; c++)
+	{
+		endpoint0[c] = mean[c] + axis[c] * fMax;
+		endpoint1[c] = mean[c] + axis[c] * fMin;
+	}
+
+	uint16_t color0 = PackColor(endpoint0);
+	uint16_t color1 = PackColor(endpoint1);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+
+	// With equal endpoints every index would give the same color
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		UnpackColor(color0, palette[0]);
+		UnpackColor(color1, palette[1]);
+
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestError = INT32_MAX;
+
+			for (int p = 0; p < 4; p++)
+			{
+				const int r = block[i][0] - palette[p][0];
+				const int g = block[i][1] - palette[p][1];
+				const int b = block[i][2] - palette[p][2];
+
+				const int error = r * r + g * g + b * b;
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+
+			indices |= (uint32_t)best << (2 * i);
+		}
+	}
+
+	memcpy(output, &color0, 2);
+	memcpy(output + 2, &color1, 2);
+	memcpy(output + 4, &indices, 4);
+}
+
+// Private utility function - encodes one channel of a block into 8 bytes of BC4, in the 8 value mode (alpha0 > alpha1)
+static void EncodeBC4(const uint8_t block[16][4], int channel, uint8_t* output)
+{
+	uint8_t alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		alpha0 = std::max(alpha0, block[i][channel]);
+		alpha1 = std::min(alpha1, block[i][channel]);
+	}
+
+	uint64_t indices = 0;
+
+	if (alpha0 != alpha1)
+	{
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestError = INT32_MAX;
+
+			for (int p = 0; p < 8; p++)
+			{
+				const int error = std::abs(block[i][channel] - palette[p]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+
+			indices |= (uint64_t)best << (3 * i);
+		}
+	}
+
+	output[0] = alpha0;
+	output[1] = alpha1;
+
+	// 48 bits of indices, little endian
+	for (int i = 0; i < 6; i++)
+		output[2 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+// Private utility function - encodes the block at (bx, by) of 'image' into 'output'
+static void EncodeBlock(const Image& image, TextureCompression format, uint32_t bx, uint32_t by, uint8_t* output)
+{
+	uint8_t block[16][4];
+	FetchBlock(image, bx, by, block);
+
+	switch (format)
+	{
+	case TextureCompression::BC1:
+		EncodeBC1(block, output);
+		break;
+
+	case TextureCompression::BC3:
+		EncodeBC4(block, 3, output);
+		EncodeBC1(block, output + 8);
+		break;
+
+	case TextureCompression::BC4:
+		EncodeBC4(block, 0, output);
+		break;
+
+	case TextureCompression::BC5:
+	default:
+		EncodeBC4(block, 0, output);
+		EncodeBC4(block, 1, output + 8);
+		break;
+	}
+}
+
+// Private utility function - encodes a mip level into 'output', the rows of blocks are split between threads
+static void EncodeLevel(const Image& image, TextureCompression format, uint8_t* output)
+{
+	const uint32_t blocksX = (image.width + 3) / 4;
+	const uint32_t blocksY = (image.height + 3) / 4;
+	const uint32_t blockBytes = TextureCache::getBlockBytes(format);
+
+	auto encodeRows = [&](uint32_t firstRow, uint32_t lastRow)
+	{
+		for (uint32_t by = firstRow; by < lastRow; by++)
+		{
+			for (uint32_t bx = 0; bx < blocksX; bx++)
+				EncodeBlock(image, format, bx, by, output + ((size_t)by * blocksX + bx) * blockBytes);
+		}
+	};
+
+	const uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, blocksY);
+	const uint32_t rowsPerThread = (blocksY + threadCount - 1) / threadCount;
+
+	std::vector<std::thread> threads;
+	for (uint32_t first = rowsPerThread; first < blocksY; first += rowsPerThread)
+		threads.emplace_back(encodeRows, first, std::min(first + rowsPerThread, blocksY));
+
+	encodeRows(0, std::min(rowsPerThread, blocksY));
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+// Private utility function - picks the format for an image, see the top of the file
+static TextureCompression ChooseFormat(const Image& image)
+{
+	switch (image.channels)
+	{
+	case 1:
+		return TextureCompression::BC4;
+
+	case 2:
+		return TextureCompression::BC5;
+
+	case 3:
+		return TextureCompression::BC1;
+
+	default:
+		for (size_t i = 3; i < image.pixels.size(); i += 4)
+		{
+			if (image.pixels[i] != 255)
+				return TextureCompression::BC3;
+		}
+
+		return TextureCompression::BC1;
+	}
+}
+
+// Private utility function - compresses 'image' and all of its mip levels down to 1x1
+static void Compress(Image image, CompressedImage& result)
+{
+	result.format = ChooseFormat(image);
+	result.width = image.width;
+	result.height = image.height;
+	result.levelCount = TextureCache::getLevelCount(image.width, image.height);
+
+	size_t totalBytes = 0;
+	for (uint32_t level = 0; level < result.levelCount; level++)
+		totalBytes += TextureCache::getLevelBytes(result.format, std::max(1u, image.width >> level), std::max(1u, image.height >> level));
+
+	result.data.resize(totalBytes);
+
+	size_t offset = 0;
+	for (uint32_t level = 0; level < result.levelCount; level++)
+	{
+		if (level > 0)
+			image = Downsample(image);
+
+		EncodeLevel(image, result.format, result.data.data() + offset);
+		offset += TextureCache::getLevelBytes(result.format, image.width, image.height);
+	}
+}
+
+static const char* GetFormatName(TextureCompression format)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:	return "BC1";
+	case TextureCompression::BC3:	return "BC3";
+	case TextureCompression::BC4:	return "BC4";
+	default:						return "BC5";
+	}
+}
+
+static bool IsImage(const std::filesystem::path& path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga";
+}
+
+int main(int argc, char** argv)
+{
+	bool bForce = false;
+	bool bFlip = true;
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--force")
+		{
+			bForce = true;
+		}
+
+		else if (arg == "--no-flip")
+		{
+			bFlip = false;
+		}
+
+		else if (std::filesystem::is_directory(arg))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(arg))
+			{
+				if (IsImage(entry.path()))
+					files.push_back(entry.path().generic_string());
+			}
+		}
+
+		else
+		{
+			files.push_back(arg);
+		}
+	}
+
+	if (files.empty())
+	{
+		std::cout << "Usage: TextureCompressor [--force] [--no-flip] <image | directory>..." << std::endl;
+		return 1;
+	}
+
+	stbi_set_flip_vertically_on_load(bFlip);
+
+	int failed = 0;
+
+	for (const auto& file : files)
+	{
+		TextureFileView existing;
+		if (!bForce && TextureCache::load(file, bFlip, existing))
+		{
+			std::cout << file << ": up to date" << std::endl;
+			continue;
+		}
+
+		auto t1 = std::chrono::steady_clock::now();
+
+		int width, height, channels;
+		unsigned char* pixels = stbi_load(file.c_str(), &width, &height, &channels, 0);
+		if (!pixels)
+		{
+			std::cerr << file << ": failed to load (" << stbi_failure_reason() << ")" << std::endl;
+			failed++;
+			continue;
+		}
+
+		Image image;
+		image.width = (uint32_t)width;
+		image.height = (uint32_t)height;
+		image.channels = channels;
+		image.pixels.assign(pixels, pixels + (size_t)width * height * channels);
+		stbi_image_free(pixels);
+
+		CompressedImage compressed;
+		Compress(std::move(image), compressed);
+
+		if (!TextureCache::save(file, bFlip, compressed))
+		{
+			std::cerr << file << ": failed to write " << TextureCache::getCachePath(file) << std::endl;
+			failed++;
+			continue;
+		}
+
+		auto t2 = std::chrono::steady_clock::now();
+		std::chrono::duration<float, std::milli> elapsedTime = t2 - t1;
+
+		// What the texture takes in video memory as RGBA8 with mip levels, against the compressed levels
+		size_t uncompressedBytes = 0;
+		for (uint32_t level = 0; level < compressed.levelCount; level++)
+			uncompressedBytes += (size_t)std::max(1, width >> level) * std::max(1, height >> level) * 4;
+
+		std::cout << file << ": " << width << "x" << height << " " << GetFormatName(compressed.format) << ", " << compressed.levelCount << " levels, "
+			<< std::filesystem::file_size(file) / 1024 << " KB on disk, " << uncompressedBytes / 1024 << " KB -> " << compressed.data.size() / 1024
+			<< " KB in video memory (" << (float)uncompressedBytes / compressed.data.size() << ":1), " << elapsedTime.count() << " ms" << std::endl;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -12,6 +12,9 @@
 
 const size_t len = 10000;
 
+// First of the 4 attribute locations of the instance model matrix in Cube.shader
+constexpr unsigned int INSTANCE_LOCATION = 3;
+
 class Console : public OpenGL_Graphics
 {
 private:
@@ -26,6 +29,9 @@ private:
 	VertexArray cubeVAO;
 	BufferLayout cubeLayout;
 
+	// Model matrix of every cube, rewritten each frame
+	StreamBuffer<glm::mat4> cubeInstances;
+
 	// Light cube
 	VertexArray lightCubeVAO;
 	BufferLayout lightCubeLayout;
@@ -131,6 +137,15 @@ protected:
 		cubeLayout.setBufferLayout(cubeVAO, cubeVBO, 3, BufferType::FLOAT);
 		cubeLayout.setBufferLayout(cubeVAO, cubeVBO, 3, BufferType::FLOAT);
 		cubeLayout.setBufferLayout(cubeVAO, cubeVBO, 2, BufferType::FLOAT);
+
+		// Instance model matrices, a mat4 takes up 4 attribute locations. The offsets are set each frame.
+		cubeInstances.generate(len);
+		for (int i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(INSTANCE_LOCATION + i);
+			glVertexAttribDivisor(INSTANCE_LOCATION + i, 1);
+		}
+
 		cubeShader.load("shaders/Cube.shader");
 
 		// Light cube
@@ -210,25 +225,51 @@ protected:
 		// Set the current shader in use back to cube shader
 		cubeShader.use();
 
-		glActiveTexture(GL_TEXTURE0);
+		GLState::get().activeTexture(0);
 		diffuseTexture.bindTexture();
 
-		glActiveTexture(GL_TEXTURE1);
+		GLState::get().activeTexture(1);
 		specularTexture.bindTexture();
 
-		// Draw cubes
-		for (const auto& cubePos : aCubePos)
+		// Write the model matrices of this frame while the GPU may still be drawing the previous ones. If the region
+		// can't be mapped it holds no matrices for this frame, so the cubes are skipped rather than drawn from it.
+		glm::mat4* matModels = cubeInstances.map();
+		if (!matModels)
+			return;
+
+		// Every cube turns by the same angle, so only the translation differs
+		glm::mat4 matRotation = glm::mat4(1.0f);
+		matRotation = glm::rotate(matRotation, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
+		matRotation = glm::scale(matRotation, glm::vec3(2.0f, 2.0f, 2.0f));
+
+		for (size_t i = 0; i < len; i++)
+		{
+			glm::mat4 matModel = matRotation;
+			matModel[3] = glm::vec4(aCubePos[i], 1.0f);
+
+			matModels[i] = matModel;
+		}
+
+		cubeInstances.unmap();
+
+		SetInstanceOffset(cubeInstances.getOffset());
+
+		// Rasterize all cubes at once
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)len);
+
+		cubeInstances.fence();
+	}
+
+	// Points the instance attributes of the cube VAO at the region of the instance buffer written this frame
+	void SetInstanceOffset(size_t offset)
+	{
+		cubeVAO.bind();
+		cubeInstances.bind();
+
+		for (int i = 0; i < 4; i++)
 		{
-			glm::mat4 matModel = glm::mat4(1.0f);
-			
-			matModel = glm::translate(matModel, cubePos);
-			matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
-			matModel = glm::scale(matModel, glm::vec3(2.0f, 2.0f, 2.0f));
-
-			cubeShader.setMat4("matModel", matModel);
-			
-			// Rasterize the cube
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			const size_t columnOffset = offset + i * sizeof(glm::vec4);
+			glVertexAttribPointer(INSTANCE_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const void*)columnOffset);
 		}
 	}
 
@@ -339,12 +380,14 @@ protected:
 	{
 		axesVBO.free();
 		cubeVBO.free();
+		cubeInstances.free();
 
 		axesVAO.free();
 		cubeVAO.free();
 		lightCubeVAO.free();
 
-		std::cout << "\nDuration: " << std::fixed << std::setprecision(2) << fTimeSinceStart << 's' << std::endl;
+		std::cout << "\nInstance buffer stalls: " << cubeInstances.getStallCount() << std::endl;
+		std::cout << "Duration: " << std::fixed << std::setprecision(2) << fTimeSinceStart << 's' << std::endl;
 	}
 
 	int GetRandom()
@@ -9,6 +9,8 @@
 #include <chrono>
 #include <mutex>
 
+#include "GLState.h"
+
 std::mutex mtx;
 
 class OpenGL_Graphics
@@ -79,6 +81,8 @@ private:
 			float fElapsedTime = elapsedTime.count();
 			fTimeSinceStart += fElapsedTime;
 
+			GLState::get().beginFrame();
+
 			// Keyboard inputs
 			for (int i = 0; i < 348; i++)
 			{
@@ -144,8 +148,10 @@ private:
 				
 				if (window)
 				{
-					char s[32];
-					sprintf_s(s, 32, "%s : %d FPS", m_sAppName.c_str(), fps);
+					const GLState::Stats& calls = GLState::get().getFrameStats();
+
+					char s[128];
+					sprintf_s(s, 128, "%s : %d FPS | GL calls %zu (%zu avoided)", m_sAppName.c_str(), fps, calls.callsIssued, calls.callsAvoided);
 					glfwSetWindowTitle(window, s);
 				}
 
@@ -227,7 +233,7 @@ public:
 		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
 		// Enable z-buffer
-		glEnable(GL_DEPTH_TEST);
+		GLState::get().enable(GL_DEPTH_TEST);
 
 		// Display GPU info
 		CheckGPU();
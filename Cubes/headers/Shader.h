@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLState.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -115,7 +117,7 @@ void Shader::load(const std::string& shaderPath)
 
 void Shader::use()
 {
-	glUseProgram(id);
+	GLState::get().useProgram(id);
 }
 
 void Shader::setBool(const std::string& name, bool value)
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "GLState.h"
+
+/**
+  * Vertex buffer for data which is rewritten every frame, like per instance model matrices.
+  *
+  * The buffer is split into three regions used in turn. While the CPU writes the region of frame N, the GPU can
+  * still be reading the ones of frames N-1 and N-2. A region is mapped with GL_MAP_UNSYNCHRONIZED_BIT, so mapping
+  * never waits for the GPU to finish with the whole buffer, and each region gets a fence after its draws which is
+  * waited on before the region is written again three frames later. That wait only blocks when the CPU is more
+  * than two frames ahead.
+  *
+  * Usage per frame:
+  *
+  *	T* data = buffer.map();			// write up to getCapacity() elements
+  *	buffer.unmap();
+  *	...point the attributes at getOffset() and draw...
+  *	buffer.fence();
+  */
+template<typename T>
+class StreamBuffer
+{
+private:
+	static constexpr int REGION_COUNT = 3;
+
+	unsigned int m_StreamBufferID = 0;
+	size_t m_Capacity = 0;
+	int m_Region = 0;
+
+	GLsync m_Fences[REGION_COUNT] = { nullptr };
+
+	// Number of times map() had to wait for the GPU
+	size_t m_Stalls = 0;
+
+public:
+	StreamBuffer() = default;
+
+	// Allocates room for 'capacity' elements per frame
+	void generate(size_t capacity)
+	{
+		m_Capacity = capacity;
+
+		glGenBuffers(1, &m_StreamBufferID);
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_StreamBufferID);
+		glBufferData(GL_ARRAY_BUFFER, REGION_COUNT * capacity * sizeof(T), nullptr, GL_STREAM_DRAW);
+	}
+
+	void bind() const
+	{
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_StreamBufferID);
+	}
+
+	void unbind() const
+	{
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// Returns the current region for writing, once the GPU is done reading it. Leaves the buffer bound.
+	T* map()
+	{
+		WaitForRegion(m_Region);
+
+		bind();
+
+		const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+		return (T*)glMapBufferRange(GL_ARRAY_BUFFER, getOffset(), m_Capacity * sizeof(T), access);
+	}
+
+	void unmap() const
+	{
+		bind();
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	// Call after the draws reading the current region have been issued, moves on to the next region
+	void fence()
+	{
+		m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_Region = (m_Region + 1) % REGION_COUNT;
+	}
+
+	// Byte offset of the current region, for the attribute pointers
+	size_t getOffset() const
+	{
+		return m_Region * m_Capacity * sizeof(T);
+	}
+
+	size_t getCapacity() const
+	{
+		return m_Capacity;
+	}
+
+	size_t getStallCount() const
+	{
+		return m_Stalls;
+	}
+
+	void free()
+	{
+		for (int i = 0; i < REGION_COUNT; i++)
+		{
+			if (m_Fences[i])
+			{
+				glDeleteSync(m_Fences[i]);
+				m_Fences[i] = nullptr;
+			}
+		}
+
+		GLState::get().deleteBuffers(1, &m_StreamBufferID);
+	}
+
+private:
+	// Private utility function - blocks until the draws of the last frame which used 'region' have finished
+	void WaitForRegion(int region)
+	{
+		GLsync fence = m_Fences[region];
+		if (!fence)
+			return;
+
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			m_Stalls++;
+
+			// Flush the first time around, otherwise the fence might never reach the GPU
+			GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			do
+			{
+				result = glClientWaitSync(fence, flags, 1000000);	// 1 ms
+				flags = 0;
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence);
+		m_Fences[region] = nullptr;
+	}
+};
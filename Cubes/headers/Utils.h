@@ -10,6 +10,7 @@
 #include "Shader.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "StreamBuffer.h"
 #include "IndexBuffer.h"
 #include "BufferLayout.h"
 #include "Texture2D.h"
@@ -6,8 +6,8 @@
 layout (location = 0) in vec3 vPos;
 layout (location = 1) in vec3 vNorm;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 matModel;		// Per instance
 
-uniform mat4 matModel;
 uniform mat4 matView;
 uniform mat4 matProjection;
 
@@ -35,12 +35,12 @@ private:
 
 	Model textureCubeModel;
 
-	// Shaders
-	Shader lightingShader;
-	Shader terrainShader;
+	// Shaders, the lit ones are variants owned by ShaderVariants
+	Shader* lightingShader = nullptr;
+	Shader* terrainShader = nullptr;
 	Shader lampShader;
 
-	Shader textureCubeShader;
+	Shader* textureCubeShader = nullptr;
 
 	// Projection matrix
 	glm::mat4 matProjection;
@@ -74,28 +74,32 @@ public:
 		textureCubeModel.load("models/Grass2.obj");
 
 		// ---------------------------- Shader load ----------------------------
-		lightingShader.load("shaders/Lighting.glsl");
-		terrainShader.load("shaders/Terrain1.glsl");
+		ShaderVariants& variants = ShaderVariants::getInstance();
+
+		// One lamp, see InitalizeLightingShader()
+		lightingShader = variants.get("shaders/Lighting.glsl", ShaderDefines().set("NR_POINT_LIGHTS", 1));
+		terrainShader = variants.get("shaders/Terrain1.glsl", ShaderDefines().set("NR_POINT_LIGHTS", 1));
 		lampShader.load("shaders/Lamp.glsl");
-		textureCubeShader.load("shaders/TextureLighting.glsl");
+
+		// Grass2.png comes without a specular map, highlights would only ever sample black
+		textureCubeShader = variants.get("shaders/TextureLighting.glsl", ShaderDefines().set("NR_POINT_LIGHTS", 1).set("SPECULAR", 0));
 
 		// ---------------------------- Texture load ----------------------------
 		textureCubeModel.bindTextures({ "resources/textures/Grass2.png"});
 
 		// Set textures
-		textureCubeShader.use();
-		textureCubeShader.setInt("u_material.diffuse", 0);
-		textureCubeShader.setInt("u_material.specular", 1);
+		textureCubeShader->use();
+		textureCubeShader->setInt("u_material.diffuse", 0);
 
 		// Assign each model to its corresponding shader (by reference)
-		renderer.addModel(&cubeModel, &lightingShader);
-		renderer.addModel(&spaceshipModel, &lightingShader);
-		renderer.addModel(&sphereModel, &lightingShader);
-		renderer.addModel(&terrainModel, &terrainShader);
+		renderer.addModel(&cubeModel, lightingShader);
+		renderer.addModel(&spaceshipModel, lightingShader);
+		renderer.addModel(&sphereModel, lightingShader);
+		renderer.addModel(&terrainModel, terrainShader);
 		renderer.addModel(&lampModel, &lampShader);
 
 		// Test!
-		renderer.addModel(&textureCubeModel, &textureCubeShader);
+		renderer.addModel(&textureCubeModel, textureCubeShader);
 
 		// Initalize shaders
 		InitalizeLightingShader();
@@ -110,14 +114,14 @@ public:
 		matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
 		axesShader.use();
 		axesShader.setMat4("matProjection", matProjection);
-		lightingShader.use();
-		lightingShader.setMat4("matProjection", matProjection);
-		terrainShader.use();
-		terrainShader.setMat4("matProjection", matProjection);
+		lightingShader->use();
+		lightingShader->setMat4("matProjection", matProjection);
+		terrainShader->use();
+		terrainShader->setMat4("matProjection", matProjection);
 		lampShader.use();
 		lampShader.setMat4("matProjection", matProjection);
-		textureCubeShader.use();
-		textureCubeShader.setMat4("matProjection", matProjection);
+		textureCubeShader->use();
+		textureCubeShader->setMat4("matProjection", matProjection);
 
 		return true;
 	}
@@ -143,20 +147,20 @@ public:
 
 	void UpdateShader()
 	{
-		lightingShader.use();
-		lightingShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		lightingShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		lightingShader.setVec3("u_vViewPos", camera.vCameraPos);
+		lightingShader->use();
+		lightingShader->setVec3("u_spotLight.vPosition", camera.vCameraPos);
+		lightingShader->setVec3("u_spotLight.vDirection", camera.vCameraFront);
+		lightingShader->setVec3("u_vViewPos", camera.vCameraPos);
 
-		terrainShader.use();
-		terrainShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		terrainShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		terrainShader.setVec3("u_vViewPos", camera.vCameraPos);
+		terrainShader->use();
+		terrainShader->setVec3("u_spotLight.vPosition", camera.vCameraPos);
+		terrainShader->setVec3("u_spotLight.vDirection", camera.vCameraFront);
+		terrainShader->setVec3("u_vViewPos", camera.vCameraPos);
 
-		textureCubeShader.use();
-		textureCubeShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		textureCubeShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		textureCubeShader.setVec3("u_vViewPos", camera.vCameraPos);
+		textureCubeShader->use();
+		textureCubeShader->setVec3("u_spotLight.vPosition", camera.vCameraPos);
+		textureCubeShader->setVec3("u_spotLight.vDirection", camera.vCameraFront);
+		textureCubeShader->setVec3("u_vViewPos", camera.vCameraPos);
 
 		cubeModel.matModel = glm::mat4(1.0f);
 		cubeModel.matModel = glm::rotate(cubeModel.matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -183,128 +187,128 @@ public:
 
 	void InitalizeTextureShader()
 	{
-		textureCubeShader.use();
+		textureCubeShader->use();
 
 		// ---------------------------------------- Directional light ---------------------------------------- 
-		textureCubeShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		textureCubeShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
+		textureCubeShader->setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		textureCubeShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		textureCubeShader.setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		textureCubeShader.setVec3("u_dirLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
+		textureCubeShader->setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_dirLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
 
 		// ---------------------------------------- Point light ---------------------------------------- 
 		// TODO: Implement multiple lamps using a for-loop
-		textureCubeShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		textureCubeShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_pointLights[0].vPosition", vLampPos);
+		textureCubeShader->setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		textureCubeShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		textureCubeShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		textureCubeShader.setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
-		textureCubeShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		textureCubeShader.setFloat("u_pointLights[0].fLinear", 0.014f);
-		textureCubeShader.setFloat("u_pointLights[0].fQuadratic", 0.0007f);
+		textureCubeShader->setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
+		textureCubeShader->setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setFloat("u_pointLights[0].fConstant", 1.0f);
+		textureCubeShader->setFloat("u_pointLights[0].fLinear", 0.014f);
+		textureCubeShader->setFloat("u_pointLights[0].fQuadratic", 0.0007f);
 
-		textureCubeShader.setFloat("u_material.fShininess", 64.0f);
+		textureCubeShader->setFloat("u_material.fShininess", 64.0f);
 
 		// ---------------------------------------- Spot light ---------------------------------------- 
-		textureCubeShader.setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 0.0f, 1.0f));
+		textureCubeShader->setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 0.0f, 1.0f));
 
-		textureCubeShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		textureCubeShader.setVec3("u_spotLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		textureCubeShader.setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
+		textureCubeShader->setVec3("u_spotLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		textureCubeShader->setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		textureCubeShader.setFloat("u_spotLight.fConstant", 1.0f);
-		textureCubeShader.setFloat("u_spotLight.fLinear", 0.22f);
-		textureCubeShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+		textureCubeShader->setFloat("u_spotLight.fConstant", 1.0f);
+		textureCubeShader->setFloat("u_spotLight.fLinear", 0.22f);
+		textureCubeShader->setFloat("u_spotLight.fQuadratic", 0.20f);
 
 		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		textureCubeShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		textureCubeShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+		textureCubeShader->setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
+		textureCubeShader->setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
 	}
 
 	void InitalizeLightingShader()
 	{
-		lightingShader.use();
+		lightingShader->use();
 
 		// ---------------------------------------- Directional light ---------------------------------------- 
-		lightingShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		lightingShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
+		lightingShader->setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		lightingShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		lightingShader.setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_dirLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
+		lightingShader->setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_dirLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
 
 		// ---------------------------------------- Point light ---------------------------------------- 
 		// TODO: Implement multiple lamps using a for-loop
-		lightingShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		lightingShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_pointLights[0].vPosition", vLampPos);
+		lightingShader->setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		lightingShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		lightingShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		lightingShader.setFloat("u_pointLights[0].fLinear", 0.014f);
-		lightingShader.setFloat("u_pointLights[0].fQuadratic", 0.0007f);
+		lightingShader->setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
+		lightingShader->setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setFloat("u_pointLights[0].fConstant", 1.0f);
+		lightingShader->setFloat("u_pointLights[0].fLinear", 0.014f);
+		lightingShader->setFloat("u_pointLights[0].fQuadratic", 0.0007f);
 
-		lightingShader.setFloat("u_material.fShininess", 64.0f);
-		lightingShader.setVec3("u_material.vColor", glm::vec3(0.5f, 0.5f, 0.5f));
+		lightingShader->setFloat("u_material.fShininess", 64.0f);
+		lightingShader->setVec3("u_material.vColor", glm::vec3(0.5f, 0.5f, 0.5f));
 
 		// ---------------------------------------- Spot light ---------------------------------------- 
-		lightingShader.setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 0.0f, 1.0f));
+		lightingShader->setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 0.0f, 1.0f));
 
-		lightingShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		lightingShader.setVec3("u_spotLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
+		lightingShader->setVec3("u_spotLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader->setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		lightingShader.setFloat("u_spotLight.fConstant", 1.0f);
-		lightingShader.setFloat("u_spotLight.fLinear", 0.22f);
-		lightingShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+		lightingShader->setFloat("u_spotLight.fConstant", 1.0f);
+		lightingShader->setFloat("u_spotLight.fLinear", 0.22f);
+		lightingShader->setFloat("u_spotLight.fQuadratic", 0.20f);
 
 		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		lightingShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		lightingShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+		lightingShader->setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
+		lightingShader->setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
 	}
 
 	void InitalizeTerrainShader()
 	{
-		terrainShader.use();
+		terrainShader->use();
 
 		// ---------------------------------------- Directional light ---------------------------------------- 
-		terrainShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		terrainShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		terrainShader->setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
+		terrainShader->setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		terrainShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		terrainShader.setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+		terrainShader->setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
+		terrainShader->setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
 
 		// ---------------------------------------- Point light ---------------------------------------- 
 		// TODO: Implement multiple lamps using a for-loop
-		terrainShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		terrainShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		terrainShader->setVec3("u_pointLights[0].vPosition", vLampPos);
+		terrainShader->setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
 
-		terrainShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		terrainShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(0.7f, 0.7f, 0.7f));
+		terrainShader->setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
+		terrainShader->setVec3("u_pointLights[0].vDiffuse", glm::vec3(0.7f, 0.7f, 0.7f));
 
-		terrainShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		terrainShader.setFloat("u_pointLights[0].fLinear", 0.014f);
-		terrainShader.setFloat("u_pointLights[0].fQuadratic", 0.0007f);
+		terrainShader->setFloat("u_pointLights[0].fConstant", 1.0f);
+		terrainShader->setFloat("u_pointLights[0].fLinear", 0.014f);
+		terrainShader->setFloat("u_pointLights[0].fQuadratic", 0.0007f);
 
-		terrainShader.setFloat("u_material.fShininess", 64.0f);
-		terrainShader.setVec3("u_material.vColor", glm::vec3(0.13f, 0.55f, 0.13f));
+		terrainShader->setFloat("u_material.fShininess", 64.0f);
+		terrainShader->setVec3("u_material.vColor", glm::vec3(0.13f, 0.55f, 0.13f));
 
 		// ---------------------------------------- Spot light ---------------------------------------- 
-		terrainShader.setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 1.0f, 0.0f));
+		terrainShader->setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 1.0f, 0.0f));
 
-		terrainShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		terrainShader.setVec3("u_spotLight.vDiffuse", glm::vec3(0.2f, 0.2f, 0.2f));
+		terrainShader->setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
+		terrainShader->setVec3("u_spotLight.vDiffuse", glm::vec3(0.2f, 0.2f, 0.2f));
 
-		terrainShader.setFloat("u_spotLight.fConstant", 1.0f);
-		terrainShader.setFloat("u_spotLight.fLinear", 0.22f);
-		terrainShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+		terrainShader->setFloat("u_spotLight.fConstant", 1.0f);
+		terrainShader->setFloat("u_spotLight.fLinear", 0.22f);
+		terrainShader->setFloat("u_spotLight.fQuadratic", 0.20f);
 
 		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		terrainShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		terrainShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+		terrainShader->setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
+		terrainShader->setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
 	}
 
 	void RenderAxis()
@@ -368,14 +372,14 @@ public:
 			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
 			axesShader.use();
 			axesShader.setMat4("matProjection", matProjection);
-			lightingShader.use();
-			lightingShader.setMat4("matProjection", matProjection);
-			terrainShader.use();
-			terrainShader.setMat4("matProjection", matProjection);
+			lightingShader->use();
+			lightingShader->setMat4("matProjection", matProjection);
+			terrainShader->use();
+			terrainShader->setMat4("matProjection", matProjection);
 			lampShader.use();
 			lampShader.setMat4("matProjection", matProjection);
-			textureCubeShader.use();
-			textureCubeShader.setMat4("matProjection", matProjection);
+			textureCubeShader->use();
+			textureCubeShader->setMat4("matProjection", matProjection);
 		}
 
 		else if (GetKey('C').bReleased)
@@ -385,14 +389,14 @@ public:
 			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
 			axesShader.use();
 			axesShader.setMat4("matProjection", matProjection);
-			lightingShader.use();
-			lightingShader.setMat4("matProjection", matProjection);
-			terrainShader.use();
-			terrainShader.setMat4("matProjection", matProjection);
+			lightingShader->use();
+			lightingShader->setMat4("matProjection", matProjection);
+			terrainShader->use();
+			terrainShader->setMat4("matProjection", matProjection);
 			lampShader.use();
 			lampShader.setMat4("matProjection", matProjection);
-			textureCubeShader.use();
-			textureCubeShader.setMat4("matProjection", matProjection);
+			textureCubeShader->use();
+			textureCubeShader->setMat4("matProjection", matProjection);
 		}
 
 		if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
@@ -408,10 +412,10 @@ public:
 
 		// Update view matrix
 		camera.UpdateView(axesShader, "matView");
-		camera.UpdateView(lightingShader, "matView");
-		camera.UpdateView(terrainShader, "matView");
+		camera.UpdateView(*lightingShader, "matView");
+		camera.UpdateView(*terrainShader, "matView");
 		camera.UpdateView(lampShader, "matView");
-		camera.UpdateView(textureCubeShader, "matView");
+		camera.UpdateView(*textureCubeShader, "matView");
 	}
 
 	void Destroy() override
@@ -419,7 +423,24 @@ public:
 		axesVAO.free();
 		axesVBO.free();
 
+		ShaderVariants::getInstance().free();
+
 		std::cout << "\nDuration: " << std::fixed << std::setprecision(2) << fTimeSinceStart << 's' << std::endl;
+
+		// Startup cost of the shaders, compiling against loading the binaries of an earlier run
+		const ProgramCacheStats& programStats = ProgramCache::getInstance().getStats();
+		std::cout << "Programs: " << programStats.compiled << " compiled in " << programStats.fCompileMs << " ms, "
+			<< programStats.loaded << " loaded from the program cache in " << programStats.fLoadMs << " ms";
+
+		if (programStats.rejected > 0)
+			std::cout << " (" << programStats.rejected << " cached binaries rejected by the driver)";
+
+		std::cout << std::endl;
+
+		// Programs compile side by side, see ShaderCompiler.h
+		ShaderCompiler& compiler = ShaderCompiler::getInstance();
+		std::cout << "Compiled programs were ready " << compiler.getBatchMs() << " ms after the first was issued"
+			<< (compiler.hasParallelCompile() ? " (KHR_parallel_shader_compile)" : "") << std::endl;
 	}
 
 	static int random()
@@ -51,7 +51,7 @@ public:
 
 	void SetCameraPos(glm::vec3 vPos);
 
-	void UpdateView(Shader shader, const std::string& viewMat4ID);
+	void UpdateView(Shader& shader, const std::string& viewMat4ID);
 };
 
 void Camera::init(glm::vec3 vPos, glm::vec3 vFront)
@@ -144,7 +144,7 @@ void Camera::SetCameraPos(glm::vec3 vPos)
 	vCameraPos = vPos;
 }
 
-void Camera::UpdateView(Shader shader, const std::string& viewMat4ID)
+void Camera::UpdateView(Shader& shader, const std::string& viewMat4ID)
 {
 	shader.use();
 	shader.setMat4(viewMat4ID, matView);
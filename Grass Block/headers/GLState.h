@@ -0,0 +1,373 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+/**
+  * Remembers the GL state set through it and drops calls which wouldn't change anything.
+  *
+  * Tracked are the program, the vertex array, the GL_ARRAY_BUFFER binding, the active texture unit, the texture
+  * bound to each target of each unit and a few capabilities. Everything binding these has to go through here,
+  * a raw glBindTexture() or glUseProgram() elsewhere leaves the cache believing something that isn't true.
+  * Deleting an object unbinds it, and GL hands out the name again, so the delete calls go through here too.
+  *
+  * The element array binding belongs to the bound vertex array and other buffer targets are rarely bound twice
+  * in a row, so those calls are passed on without being tracked.
+  *
+  * All of this runs on the thread owning the context.
+  */
+class GLState
+{
+public:
+	// GL calls made and dropped since the last beginFrame()
+	struct Stats
+	{
+		size_t callsIssued = 0;
+		size_t callsAvoided = 0;
+	};
+
+	static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+
+private:
+	enum TextureTarget
+	{
+		TARGET_2D,
+		TARGET_2D_ARRAY,
+		TARGET_CUBE_MAP,
+		TARGET_BUFFER,
+		TARGET_COUNT
+	};
+
+	enum Capability
+	{
+		CAP_DEPTH_TEST,
+		CAP_CULL_FACE,
+		CAP_BLEND,
+		CAP_COUNT
+	};
+
+	unsigned int m_Program = 0;
+	unsigned int m_VertexArray = 0;
+	unsigned int m_ArrayBuffer = 0;
+	unsigned int m_ActiveUnit = 0;
+	unsigned int m_Textures[MAX_TEXTURE_UNITS][TARGET_COUNT] = {};
+
+	// Everything starts disabled in a new context
+	bool m_Capabilities[CAP_COUNT] = {};
+
+	Stats m_Frame;
+	Stats m_LastFrame;
+	Stats m_Total;
+	size_t m_nFrames = 0;
+
+	// This is a singleton class
+	GLState() {}
+
+public:
+	GLState(GLState const&) = delete;
+	void operator=(GLState const&) = delete;
+
+	static GLState& get();
+
+	void useProgram(unsigned int program);
+
+	void bindVertexArray(unsigned int vertexArray);
+
+	void bindBuffer(GLenum target, unsigned int buffer);
+
+	// 'unit' is the index, not GL_TEXTURE0 + index
+	void activeTexture(unsigned int unit);
+
+	// Binds to the active unit
+	void bindTexture(GLenum target, unsigned int texture);
+
+	// Makes 'unit' active and binds 'texture' to it
+	void bindTexture(unsigned int unit, GLenum target, unsigned int texture);
+
+	void enable(GLenum capability);
+
+	void disable(GLenum capability);
+
+	void deleteProgram(unsigned int program);
+
+	void deleteVertexArrays(int count, const unsigned int* vertexArrays);
+
+	void deleteBuffers(int count, const unsigned int* buffers);
+
+	void deleteTextures(int count, const unsigned int* textures);
+
+	// Forgets everything, for when code outside the cache has changed the state (or a new context is current)
+	void invalidate();
+
+	// Starts counting the calls of a new frame
+	void beginFrame();
+
+	const Stats& getFrameStats() const;
+
+	// Calls made and dropped per frame, averaged over all frames so far
+	Stats getAverageStats() const;
+
+private:
+	bool Skip(bool bRedundant);
+
+	static int TargetIndex(GLenum target);
+
+	static int CapabilityIndex(GLenum capability);
+};
+
+inline GLState& GLState::get()
+{
+	static GLState state;
+	return state;
+}
+
+void GLState::useProgram(unsigned int program)
+{
+	if (Skip(m_Program == program))
+		return;
+
+	glUseProgram(program);
+	m_Program = program;
+}
+
+void GLState::bindVertexArray(unsigned int vertexArray)
+{
+	if (Skip(m_VertexArray == vertexArray))
+		return;
+
+	glBindVertexArray(vertexArray);
+	m_VertexArray = vertexArray;
+}
+
+void GLState::bindBuffer(GLenum target, unsigned int buffer)
+{
+	if (target != GL_ARRAY_BUFFER)
+	{
+		Skip(false);
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (Skip(m_ArrayBuffer == buffer))
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	m_ArrayBuffer = buffer;
+}
+
+void GLState::activeTexture(unsigned int unit)
+{
+	if (Skip(m_ActiveUnit == unit))
+		return;
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	m_ActiveUnit = unit;
+}
+
+void GLState::bindTexture(GLenum target, unsigned int texture)
+{
+	const int index = TargetIndex(target);
+
+	if (index < 0 || m_ActiveUnit >= MAX_TEXTURE_UNITS)
+	{
+		Skip(false);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (Skip(m_Textures[m_ActiveUnit][index] == texture))
+		return;
+
+	glBindTexture(target, texture);
+	m_Textures[m_ActiveUnit][index] = texture;
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+	const int index = TargetIndex(target);
+
+	// Nothing to do, not even making the unit active
+	if (index >= 0 && unit < MAX_TEXTURE_UNITS && m_Textures[unit][index] == texture)
+	{
+		Skip(true);
+		return;
+	}
+
+	activeTexture(unit);
+	bindTexture(target, texture);
+}
+
+void GLState::enable(GLenum capability)
+{
+	const int index = CapabilityIndex(capability);
+
+	if (index < 0)
+	{
+		Skip(false);
+		glEnable(capability);
+		return;
+	}
+
+	if (Skip(m_Capabilities[index]))
+		return;
+
+	glEnable(capability);
+	m_Capabilities[index] = true;
+}
+
+void GLState::disable(GLenum capability)
+{
+	const int index = CapabilityIndex(capability);
+
+	if (index < 0)
+	{
+		Skip(false);
+		glDisable(capability);
+		return;
+	}
+
+	if (Skip(!m_Capabilities[index]))
+		return;
+
+	glDisable(capability);
+	m_Capabilities[index] = false;
+}
+
+void GLState::deleteProgram(unsigned int program)
+{
+	glDeleteProgram(program);
+
+	if (m_Program == program)
+		m_Program = 0;
+}
+
+void GLState::deleteVertexArrays(int count, const unsigned int* vertexArrays)
+{
+	glDeleteVertexArrays(count, vertexArrays);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (m_VertexArray == vertexArrays[i])
+			m_VertexArray = 0;
+	}
+}
+
+void GLState::deleteBuffers(int count, const unsigned int* buffers)
+{
+	glDeleteBuffers(count, buffers);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (m_ArrayBuffer == buffers[i])
+			m_ArrayBuffer = 0;
+	}
+}
+
+void GLState::deleteTextures(int count, const unsigned int* textures)
+{
+	glDeleteTextures(count, textures);
+
+	for (int i = 0; i < count; i++)
+	{
+		for (auto& unit : m_Textures)
+		{
+			for (unsigned int& texture : unit)
+			{
+				if (texture == textures[i])
+					texture = 0;
+			}
+		}
+	}
+}
+
+void GLState::invalidate()
+{
+	GLint value = 0;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+	m_Program = (unsigned int)value;
+
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+	m_VertexArray = (unsigned int)value;
+
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &value);
+	m_ArrayBuffer = (unsigned int)value;
+
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+	m_ActiveUnit = (unsigned int)(value - GL_TEXTURE0);
+
+	// Reading back every unit would be slower than binding again, so unknown bindings are set to a name GL never
+	// hands out, which makes the next bind go through
+	for (auto& unit : m_Textures)
+	{
+		for (unsigned int& texture : unit)
+			texture = ~0u;
+	}
+
+	m_Capabilities[CAP_DEPTH_TEST] = glIsEnabled(GL_DEPTH_TEST);
+	m_Capabilities[CAP_CULL_FACE] = glIsEnabled(GL_CULL_FACE);
+	m_Capabilities[CAP_BLEND] = glIsEnabled(GL_BLEND);
+}
+
+void GLState::beginFrame()
+{
+	if (m_Frame.callsIssued + m_Frame.callsAvoided > 0)
+	{
+		m_Total.callsIssued += m_Frame.callsIssued;
+		m_Total.callsAvoided += m_Frame.callsAvoided;
+		m_nFrames++;
+	}
+
+	m_LastFrame = m_Frame;
+	m_Frame = Stats();
+}
+
+const GLState::Stats& GLState::getFrameStats() const
+{
+	return m_LastFrame;
+}
+
+GLState::Stats GLState::getAverageStats() const
+{
+	if (m_nFrames == 0)
+		return Stats();
+
+	return { m_Total.callsIssued / m_nFrames, m_Total.callsAvoided / m_nFrames };
+}
+
+// Private utility function - counts a call as made or dropped and returns whether to drop it
+bool GLState::Skip(bool bRedundant)
+{
+	if (bRedundant)
+		m_Frame.callsAvoided++;
+	else
+		m_Frame.callsIssued++;
+
+	return bRedundant;
+}
+
+// Private utility function - index of a tracked texture target, -1 for the others
+int GLState::TargetIndex(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:			return TARGET_2D;
+	case GL_TEXTURE_2D_ARRAY:	return TARGET_2D_ARRAY;
+	case GL_TEXTURE_CUBE_MAP:	return TARGET_CUBE_MAP;
+	case GL_TEXTURE_BUFFER:		return TARGET_BUFFER;
+	default:					return -1;
+	}
+}
+
+// Private utility function - index of a tracked capability, -1 for the others
+int GLState::CapabilityIndex(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_DEPTH_TEST:	return CAP_DEPTH_TEST;
+	case GL_CULL_FACE:	return CAP_CULL_FACE;
+	case GL_BLEND:		return CAP_BLEND;
+	default:			return -1;
+	}
+}
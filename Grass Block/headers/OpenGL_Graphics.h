@@ -9,6 +9,8 @@
 #include <chrono>
 #include <mutex>
 
+#include "GLState.h"
+
 std::mutex mtx;
 
 class OpenGL_Graphics
@@ -78,6 +80,8 @@ private:
 			float fElapsedTime = elapsedTime.count();
 			fTimeSinceStart += fElapsedTime;
 
+			GLState::get().beginFrame();
+
 			// Keyboard inputs
 			for (int i = 0; i < 348; i++)
 			{
@@ -143,8 +147,10 @@ private:
 				
 				if (window)
 				{
-					char s[32];
-					sprintf_s(s, 32, "%s : %d FPS", m_sAppName.c_str(), fps);
+					const GLState::Stats& calls = GLState::get().getFrameStats();
+
+					char s[128];
+					sprintf_s(s, 128, "%s : %d FPS | GL calls %zu (%zu avoided)", m_sAppName.c_str(), fps, calls.callsIssued, calls.callsAvoided);
 					glfwSetWindowTitle(window, s);
 				}
 
@@ -225,8 +231,8 @@ public:
 		glViewport(0, 0, m_width, m_height);
 		
 		// Enable z-buffer and enable face-culling
-		glEnable(GL_DEPTH_TEST);        // Enable depth testing
-		glEnable(GL_CULL_FACE);         // Enable face culling
+		GLState::get().enable(GL_DEPTH_TEST);        // Enable depth testing
+		GLState::get().enable(GL_CULL_FACE);         // Enable face culling
 		glCullFace(GL_BACK);            // Cull back faces
 		glFrontFace(GL_CCW);            // Define front faces as counter-clockwise
 
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ARB_get_program_binary (core since 4.1) isn't covered by the loader, which only has 3.3
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// Header of a cached program binary, followed by the binary itself
+struct ProgramBinaryHeader
+{
+	static constexpr char MAGIC[4] = { 'C', 'P', 'R', 'G' };
+	static constexpr uint32_t VERSION = 1;
+
+	char magic[4] = { 'C', 'P', 'R', 'G' };
+	uint32_t version = VERSION;
+
+	uint64_t key = 0;
+	uint32_t binaryFormat = 0;
+	uint32_t binaryBytes = 0;
+};
+
+// Programs built by Shader::load() since startup
+struct ProgramCacheStats
+{
+	size_t compiled = 0;
+	size_t loaded = 0;
+
+	// Binaries the driver refused (after a driver update, for example), those programs were compiled
+	size_t rejected = 0;
+
+	float fCompileMs = 0.0f;
+	float fLoadMs = 0.0f;
+};
+
+/**
+  * On-disk cache of linked programs, so that a program only has to be compiled the first time it is used.
+  *
+  * Binaries go into a "cache" directory next to the shader file, named after a hash of the preprocessed sources
+  * and of the vendor, renderer and version strings of the driver. A changed shader, define or driver therefore
+  * never picks up an old binary. Binaries the driver rejects anyway are deleted and the program is compiled.
+  *
+  * Needs ARB_get_program_binary (all desktop drivers), without it every program is compiled.
+  */
+class ProgramCache
+{
+private:
+	typedef void (APIENTRYP GetProgramBinaryFunc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryFunc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriFunc)(GLuint program, GLenum pname, GLint value);
+
+	GetProgramBinaryFunc m_GetProgramBinary = nullptr;
+	ProgramBinaryFunc m_ProgramBinary = nullptr;
+	ProgramParameteriFunc m_ProgramParameteri = nullptr;
+
+	bool m_bInitialized = false;
+	bool m_bSupported = false;
+
+	// Hash of the driver strings, part of every key
+	uint64_t m_DriverHash = 0;
+
+	ProgramCacheStats m_Stats;
+
+	// This is a singleton class
+	ProgramCache() {}
+
+public:
+	ProgramCache(ProgramCache const&) = delete;
+	void operator=(ProgramCache const&) = delete;
+
+	static ProgramCache& getInstance();
+
+	// Key of the program built from these sources with the current driver
+	uint64_t getKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+	// Links 'program' from the cached binary. Returns false if there is none or the driver rejected it.
+	bool load(unsigned int program, const std::string& shaderPath, uint64_t key);
+
+	// Call before linking a program which is going to be saved, some drivers only keep the binary if asked to
+	void prepare(unsigned int program);
+
+	// Stores the binary of the linked 'program'
+	bool save(unsigned int program, const std::string& shaderPath, uint64_t key);
+
+	bool isSupported();
+
+	void addCompileTime(float fMs);
+	void addLoadTime(float fMs);
+
+	const ProgramCacheStats& getStats() const;
+
+private:
+	static std::string GetCachePath(const std::string& shaderPath, uint64_t key);
+	static uint64_t Hash(const std::string& text, uint64_t hash = 14695981039346656037ull);
+};
+
+inline ProgramCache& ProgramCache::getInstance()
+{
+	static ProgramCache cache;
+	return cache;
+}
+
+uint64_t ProgramCache::getKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	isSupported();
+
+	// The separator keeps "ab" + "c" and "a" + "bc" apart
+	return Hash(fragmentSource, Hash(std::string(1, '\0'), Hash(vertexSource, m_DriverHash)));
+}
+
+bool ProgramCache::load(unsigned int program, const std::string& shaderPath, uint64_t key)
+{
+	if (!isSupported())
+		return false;
+
+	const std::string cachePath = GetCachePath(shaderPath, key);
+
+	std::ifstream stream(cachePath, std::ios::binary);
+	if (!stream.is_open())
+		return false;
+
+	ProgramBinaryHeader header;
+	stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	bool bValid = stream.good() && memcmp(header.magic, ProgramBinaryHeader::MAGIC, sizeof(header.magic)) == 0 &&
+		header.version == ProgramBinaryHeader::VERSION && header.key == key && header.binaryBytes > 0;
+
+	std::vector<char> binary;
+	if (bValid)
+	{
+		binary.resize(header.binaryBytes);
+		stream.read(binary.data(), (std::streamsize)binary.size());
+		bValid = stream.good();
+	}
+
+	stream.close();
+
+	if (bValid)
+	{
+		m_ProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+		int result;
+		glGetProgramiv(program, GL_LINK_STATUS, &result);
+		if (result)
+			return true;
+
+		m_Stats.rejected++;
+	}
+
+	// Corrupt, or from a driver which reports the same strings but can't read it, it will be replaced
+	std::error_code error;
+	std::filesystem::remove(cachePath, error);
+
+	return false;
+}
+
+void ProgramCache::prepare(unsigned int program)
+{
+	if (isSupported())
+		m_ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::save(unsigned int program, const std::string& shaderPath, uint64_t key)
+{
+	if (!isSupported())
+		return false;
+
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	ProgramBinaryHeader header;
+	header.key = key;
+
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	m_GetProgramBinary(program, length, &written, &format, binary.data());
+
+	if (written <= 0)
+		return false;
+
+	header.binaryFormat = format;
+	header.binaryBytes = (uint32_t)written;
+
+	const std::string cachePath = GetCachePath(shaderPath, key);
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+	// Write into a temporary file first, so that a crash never leaves a half-written cache file behind
+	const std::string tempPath = cachePath + ".tmp";
+
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+			return false;
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(binary.data(), written);
+
+		if (!stream.good())
+			return false;
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	return !error;
+}
+
+bool ProgramCache::isSupported()
+{
+	if (m_bInitialized)
+		return m_bSupported;
+
+	m_bInitialized = true;
+
+	m_GetProgramBinary = (GetProgramBinaryFunc)glfwGetProcAddress("glGetProgramBinary");
+	m_ProgramBinary = (ProgramBinaryFunc)glfwGetProcAddress("glProgramBinary");
+	m_ProgramParameteri = (ProgramParameteriFunc)glfwGetProcAddress("glProgramParameteri");
+
+	// A driver may export the functions but support no binary format at all
+	int formatCount = 0;
+	if (m_GetProgramBinary && m_ProgramBinary && m_ProgramParameteri)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	m_bSupported = formatCount > 0;
+
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const char* value = (const char*)glGetString(name);
+		m_DriverHash = Hash(value ? value : "", m_DriverHash);
+	}
+
+	return m_bSupported;
+}
+
+void ProgramCache::addCompileTime(float fMs)
+{
+	m_Stats.compiled++;
+	m_Stats.fCompileMs += fMs;
+}
+
+void ProgramCache::addLoadTime(float fMs)
+{
+	m_Stats.loaded++;
+	m_Stats.fLoadMs += fMs;
+}
+
+const ProgramCacheStats& ProgramCache::getStats() const
+{
+	return m_Stats;
+}
+
+// Private utility function - path of the binary with 'key', e.g. shaders/cache/0123456789abcdef.bin
+std::string ProgramCache::GetCachePath(const std::string& shaderPath, uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+
+	return (std::filesystem::path(shaderPath).parent_path() / "cache" / name).generic_string();
+}
+
+// Private utility function - FNV-1a, continuing from 'hash'
+uint64_t ProgramCache::Hash(const std::string& text, uint64_t hash)
+{
+	for (char c : text)
+		hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+
+	return hash;
+}
@@ -49,6 +49,7 @@ void Renderer::render()
 		}
 
 		currentShader->setMat4("matModel", model->matModel);
+		currentShader->setMat3("matNormal", model->getNormalMatrix());
 		model->draw();
 	}
 }
\ No newline at end of file
@@ -4,23 +4,59 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLState.h"
+#include "ProgramCache.h"
+#include "ShaderCompiler.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <filesystem>
+#include <vector>
 
 class Shader
 {
+private:
+	// Set between issuing the program in load() and finishing it, see ShaderCompiler.h
+	bool m_bPending = false;
+	unsigned int m_VertexShader = 0;
+	unsigned int m_FragmentShader = 0;
+	std::string m_ShaderPath;
+	uint64_t m_CacheKey = 0;
+
+	// Files the source was read from, error logs refer to them by their index (the source string number)
+	std::vector<std::string> m_SourceFiles;
+	float m_fIssueMs = 0.0f;
+
 public:
 	unsigned int id;
 
 	Shader() = default;
 
-	void load(const std::string& shaderPath);
+	/**
+	  * Compiles the vertex and fragment sections of 'shaderPath'. Lines of the form #include "file" are replaced by
+	  * the file, relative to the file including it, and every file is included only once. 'defines' ("#define NAME
+	  * VALUE" lines) goes in front of both sections to specialize the shader, see ShaderVariants.h.
+	  *
+	  * #line directives keep the line numbers of the files, with the index of the file as the source string number,
+	  * so compile errors point into the right file (CheckShader() lists the files by index).
+	  *
+	  * Doesn't wait for the driver to compile the program, that happens on the first use() or finish().
+	  */
+	void load(const std::string& shaderPath, const std::string& defines = "");
+
+	// Whether use() would return without waiting for the driver to compile the program
+	bool isReady() const;
+
+	// Waits for the program and checks it for errors. Called by the first use().
+	void finish();
 
 	//Shader(const Shader&) = delete;
 	Shader& operator=(const Shader&) = delete;
@@ -30,17 +66,30 @@ public:
 	void setBool(const std::string& name, bool value);
 	void setInt(const std::string& name, int value);
 	void setFloat(const std::string& name, float value);
+	void setMat3(const std::string& name, const glm::mat3& mat);
 	void setMat4(const std::string& name, const glm::mat4& mat);
 	void setVec3(const std::string& name, const float& f1, const float& f2, const float& f3);
 	void setVec3(const std::string& name, const glm::vec3& vec);
 
 private:
-	unsigned int CompileShader(unsigned int type, const std::string& source, const std::string& shaderPath);
+	static bool ReadSource(const std::string& shaderPath, std::string& source, std::vector<std::string>& included);
+
+	unsigned int CompileShader(unsigned int type, const std::string& source);
+	void CheckShader(unsigned int shader, unsigned int type);
 };
 
-void Shader::load(const std::string& shaderPath)
+void Shader::load(const std::string& shaderPath, const std::string& defines)
 {
-	std::ifstream stream(shaderPath);
+	std::string source;
+	m_SourceFiles.clear();
+
+	if (!ReadSource(shaderPath, source, m_SourceFiles))
+	{
+		glfwTerminate();
+		exit(0);
+	}
+
+	std::istringstream stream(source);
 
 	enum class ShaderType
 	{
@@ -53,66 +102,149 @@ void Shader::load(const std::string& shaderPath)
 	ShaderType type = ShaderType::NONE;
 	std::stringstream ss[2];
 
+	// Lines in front of the first section are shared by both
+	std::stringstream common;
+
+	// Position in the files, from the #line directives written by ReadSource()
+	int nLine = 1;
+	int nFile = 0;
+
 	while (getline(stream, line))
 	{
+		std::stringstream& target = type == ShaderType::NONE ? common : ss[(int)type];
+
+		if (line.compare(0, 6, "#line ") == 0)
+		{
+			std::istringstream(line.substr(6)) >> nLine >> nFile;
+			target << line << '\n';
+			continue;
+		}
+
 		if (line.find("SHADER") != std::string::npos)
 		{
 			if (line.find("VERTEX") != std::string::npos)
 				type = ShaderType::VERTEX;
 			else if (line.find("FRAGMENT") != std::string::npos)
 				type = ShaderType::FRAGMENT;
+
+			// The section is compiled after the lines put in front of it, so it starts with its own position
+			if (type != ShaderType::NONE)
+				ss[(int)type] << "#line " << nLine + 1 << ' ' << nFile << '\n';
 		}
 
 		else
 		{
-			ss[(int)type] << line << '\n';
+			target << line << '\n';
 		}
+
+		nLine++;
 	}
 
-	const std::string vertexShader = "#version 330 core\n #define SHADER_VERTEX\n #ifdef SHADER_VERTEX\n" + ss[0].str();
-	const std::string fragmentShader = "#version 330 core\n #define SHADER_FRAGMENT\n #ifdef SHADER_FRAGMENT\n" + ss[1].str();
+	const std::string header = "#version 330 core\n" + defines + common.str();
 
-	// Compile shaders
-	unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader, shaderPath);
-	unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader, shaderPath);
+	const std::string vertexShader = header + " #define SHADER_VERTEX\n #ifdef SHADER_VERTEX\n" + ss[0].str();
+	const std::string fragmentShader = header + " #define SHADER_FRAGMENT\n #ifdef SHADER_FRAGMENT\n" + ss[1].str();
 
-	// Link shaders
+	ProgramCache& cache = ProgramCache::getInstance();
+	const uint64_t key = cache.getKey(vertexShader, fragmentShader);
+
+	auto t1 = std::chrono::steady_clock::now();
+
+	// Use the binary of an earlier run if there is one
 	id = glCreateProgram();
-	glAttachShader(id, vs);
-	glAttachShader(id, fs);
+	if (cache.load(id, shaderPath, key))
+	{
+		std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - t1;
+		cache.addLoadTime(elapsedTime.count());
+		return;
+	}
+
+	// Compile and link without asking for the results, which would wait for the driver
+	m_VertexShader = CompileShader(GL_VERTEX_SHADER, vertexShader);
+	m_FragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+
+	// Link shaders
+	glAttachShader(id, m_VertexShader);
+	glAttachShader(id, m_FragmentShader);
+	cache.prepare(id);
 	glLinkProgram(id);
-	glValidateProgram(id);
 
-	// Check for linking errors
+	m_bPending = true;
+	m_ShaderPath = shaderPath;
+	m_CacheKey = key;
+
+	std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - t1;
+	m_fIssueMs = elapsedTime.count();
+
+	ShaderCompiler::getInstance().onIssued();
+}
+
+bool Shader::isReady() const
+{
+	return !m_bPending || ShaderCompiler::getInstance().isComplete(id);
+}
+
+void Shader::finish()
+{
+	if (!m_bPending)
+		return;
+
+	m_bPending = false;
+
+	auto t1 = std::chrono::steady_clock::now();
+
+	// Check for linking errors, this waits for the driver
 	int result;
 	glGetProgramiv(id, GL_LINK_STATUS, &result);
 
 	if (!result)
 	{
+		// A shader which didn't compile is the more useful message
+		CheckShader(m_VertexShader, GL_VERTEX_SHADER);
+		CheckShader(m_FragmentShader, GL_FRAGMENT_SHADER);
+
 		int length;
 		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
 
 		char* message = (char*)alloca(length * sizeof(char));
 		//char* message = new char[length];
-		glGetShaderInfoLog(id, length, &length, message);
+		glGetProgramInfoLog(id, length, &length, message);
 
-		std::cout << "[OpenGL Error] Linking error in \'" << shaderPath << "\'" << std::endl;
+		std::cout << "[OpenGL Error] Linking error in \'" << m_ShaderPath << "\'" << std::endl;
 		std::cout << "Log: " << message << std::endl;
 
-		glDeleteShader(vs);
-		glDeleteShader(fs);
+		glDeleteShader(m_VertexShader);
+		glDeleteShader(m_FragmentShader);
 
 		glfwTerminate();
 		exit(0);
 	}
 
-	glDeleteShader(vs);
-	glDeleteShader(fs);
+#ifdef _DEBUG
+	// Validation checks the program against the current state, it tells little before the program is used for drawing
+	glValidateProgram(id);
+#endif
+
+	glDeleteShader(m_VertexShader);
+	glDeleteShader(m_FragmentShader);
+	m_VertexShader = m_FragmentShader = 0;
+
+	// Time the thread spent issuing and waiting, compiling in the background is free
+	std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - t1;
+
+	ProgramCache& cache = ProgramCache::getInstance();
+	cache.addCompileTime(m_fIssueMs + elapsedTime.count());
+	cache.save(id, m_ShaderPath, m_CacheKey);
+
+	ShaderCompiler::getInstance().onFinished();
 }
 
 void Shader::use()
 {
-	glUseProgram(id);
+	if (m_bPending)
+		finish();
+
+	GLState::get().useProgram(id);
 }
 
 void Shader::setBool(const std::string& name, bool value)
@@ -130,6 +262,11 @@ void Shader::setFloat(const std::string& name, float value)
 	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
 }
 
+void Shader::setMat3(const std::string& name, const glm::mat3& mat)
+{
+	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 {
 	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
@@ -145,15 +282,74 @@ void Shader::setVec3(const std::string& name, const glm::vec3& vec)
 	glUniform3f(glGetUniformLocation(id, name.c_str()), vec.x, vec.y, vec.z);
 }
 
-// Private utility function - to compile vertex and fragment shader
-unsigned int Shader::CompileShader(unsigned int type, const std::string& source, const std::string& shaderPath)
+// Private utility function - to read a shader file into 'source' with its #include lines resolved. Every file
+// starts with a #line directive, and so does the rest of a file after an #include, numbered by the index of the
+// file in 'included'.
+bool Shader::ReadSource(const std::string& shaderPath, std::string& source, std::vector<std::string>& included)
+{
+	std::ifstream stream(shaderPath);
+	if (!stream)
+	{
+		std::cout << "[OpenGL Error] Failed to open shader \'" << shaderPath << "\'" << std::endl;
+		return false;
+	}
+
+	const size_t fileIndex = included.size();
+	included.push_back(std::filesystem::path(shaderPath).lexically_normal().generic_string());
+
+	const std::filesystem::path directory = std::filesystem::path(shaderPath).parent_path();
+
+	source += "#line 1 " + std::to_string(fileIndex) + '\n';
+
+	std::string line;
+	int nLine = 0;
+
+	while (getline(stream, line))
+	{
+		nLine++;
+
+		const size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			source += line;
+			source += '\n';
+			continue;
+		}
+
+		const size_t first = line.find('"', start);
+		const size_t last = line.rfind('"');
+		if (first == std::string::npos || last <= first)
+		{
+			std::cout << "[OpenGL Error] Malformed #include in \'" << shaderPath << "\': " << line << std::endl;
+			return false;
+		}
+
+		const std::string includePath = (directory / line.substr(first + 1, last - first - 1)).lexically_normal().generic_string();
+
+		if (std::find(included.begin(), included.end(), includePath) == included.end() && !ReadSource(includePath, source, included))
+			return false;
+
+		// Back in this file, after the #include line
+		source += "#line " + std::to_string(nLine + 1) + ' ' + std::to_string(fileIndex) + '\n';
+	}
+
+	return true;
+}
+
+// Private utility function - to issue the compilation of a vertex or fragment shader, without waiting for it
+unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 {
 	unsigned int shader = glCreateShader(type);
 	const char* shaderSource = source.c_str();
 	glShaderSource(shader, 1, &shaderSource, NULL);
 	glCompileShader(shader);
 
+	return shader;
+}
 
+// Private utility function - to report a shader which failed to compile, and quit
+void Shader::CheckShader(unsigned int shader, unsigned int type)
+{
 	int result;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
 
@@ -166,7 +362,12 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source,
 		char* message = (char*)alloca(length * sizeof(char));
 		glGetShaderInfoLog(shader, length, &length, message);
 
-		std::cout << "[OpenGL Error] Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader in \'" << shaderPath << "\'" << std::endl;
+		std::cout << "[OpenGL Error] Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader in \'" << m_ShaderPath << "\'" << std::endl;
+
+		// The log gives the index of the file in front of the line number
+		for (size_t i = 0; i < m_SourceFiles.size(); i++)
+			std::cout << "File " << i << ": " << m_SourceFiles[i] << std::endl;
+
 		std::cout << "Log: " << message << std::endl;
 
 		glDeleteShader(shader);
@@ -174,8 +375,6 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source,
 		glfwTerminate();
 		exit(0);
 	}
-
-	return shader;
 }
 
 #endif
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstring>
+
+// KHR_parallel_shader_compile isn't covered by the loader, which only has 3.3
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/**
+  * Lets the driver compile programs while the application carries on.
+  *
+  * Shader::load() only issues glCompileShader() and glLinkProgram(). Asking for the result is what makes the
+  * calling thread wait, so that is put off until the program is first used (Shader::use() or Shader::finish()).
+  * Drivers compile on their own threads, so every program loaded in Setup() is compiled at the same time and the
+  * first frame waits for the slowest one instead of the sum of all of them.
+  *
+  * With KHR_parallel_shader_compile the driver is told to use as many threads as it likes, and can be asked
+  * whether a program is done without waiting for it (Shader::isReady()).
+  */
+class ShaderCompiler
+{
+private:
+	typedef void (APIENTRYP MaxShaderCompilerThreadsFunc)(GLuint count);
+
+	bool m_bInitialized = false;
+	bool m_bParallelCompile = false;
+
+	size_t m_nPending = 0;
+
+	// From the first program issued to the last one finished, while programs are pending
+	std::chrono::steady_clock::time_point m_BatchStart;
+	float m_fBatchMs = 0.0f;
+
+	// This is a singleton class
+	ShaderCompiler() {}
+
+public:
+	ShaderCompiler(ShaderCompiler const&) = delete;
+	void operator=(ShaderCompiler const&) = delete;
+
+	static ShaderCompiler& getInstance();
+
+	// Whether the driver has KHR_parallel_shader_compile
+	bool hasParallelCompile();
+
+	// False while the driver is still working on 'program'. Without KHR_parallel_shader_compile there is no way to
+	// ask, then it's always true and the first use of the program may wait.
+	bool isComplete(unsigned int program);
+
+	// Called by Shader when it issues and finishes a program
+	void onIssued();
+	void onFinished();
+
+	size_t getPendingCount() const;
+
+	// Time from issuing the first program of the last batch until all of them were finished
+	float getBatchMs() const;
+
+private:
+	static bool HasExtension(const char* name);
+};
+
+inline ShaderCompiler& ShaderCompiler::getInstance()
+{
+	static ShaderCompiler compiler;
+	return compiler;
+}
+
+bool ShaderCompiler::hasParallelCompile()
+{
+	if (m_bInitialized)
+		return m_bParallelCompile;
+
+	m_bInitialized = true;
+
+	if (HasExtension("GL_KHR_parallel_shader_compile"))
+	{
+		auto maxShaderCompilerThreads = (MaxShaderCompilerThreadsFunc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+
+		// 0xFFFFFFFF leaves the number of threads to the driver
+		if (maxShaderCompilerThreads)
+			maxShaderCompilerThreads(0xFFFFFFFF);
+
+		m_bParallelCompile = true;
+	}
+
+	return m_bParallelCompile;
+}
+
+bool ShaderCompiler::isComplete(unsigned int program)
+{
+	if (!hasParallelCompile())
+		return true;
+
+	int result = 0;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &result);
+
+	return result != 0;
+}
+
+void ShaderCompiler::onIssued()
+{
+	// Makes sure the thread count is set before the first compile
+	hasParallelCompile();
+
+	if (m_nPending == 0)
+		m_BatchStart = std::chrono::steady_clock::now();
+
+	m_nPending++;
+}
+
+void ShaderCompiler::onFinished()
+{
+	if (m_nPending == 0)
+		return;
+
+	m_nPending--;
+
+	std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - m_BatchStart;
+	m_fBatchMs = elapsedTime.count();
+}
+
+size_t ShaderCompiler::getPendingCount() const
+{
+	return m_nPending;
+}
+
+float ShaderCompiler::getBatchMs() const
+{
+	return m_fBatchMs;
+}
+
+// Private utility function - looks 'name' up in the extensions of the current context
+bool ShaderCompiler::HasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
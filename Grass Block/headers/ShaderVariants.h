@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Set of preprocessor defines specializing a shader, e.g. ShaderDefines().set("NR_POINT_LIGHTS", 4).set("SPOT_LIGHT", 0)
+class ShaderDefines
+{
+private:
+	// Ordered by name, so that the same set of defines always gives the same source and key
+	std::map<std::string, int> m_Values;
+
+public:
+	ShaderDefines() = default;
+
+	ShaderDefines& set(const std::string& name, int value = 1);
+
+	// "#define NAME VALUE" lines, to be passed to Shader::load()
+	std::string getSource() const;
+};
+
+/**
+  * Compiles each combination of a shader file and a set of defines once, the first time it is asked for, and hands
+  * out the same program from then on.
+  *
+  * Shaders test their features with #if, so that a variant only contains the code it uses: no branches on uniforms
+  * and no loops over lights which aren't there. Defines which aren't given keep the default of the shader file.
+  */
+class ShaderVariants
+{
+private:
+	// Key is the shader path followed by the defines
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Variants;
+
+	// This is a singleton class
+	ShaderVariants() {}
+
+public:
+	ShaderVariants(ShaderVariants const&) = delete;
+	void operator=(ShaderVariants const&) = delete;
+
+	static ShaderVariants& getInstance();
+
+	// The program of 'shaderPath' specialized by 'defines', compiled if this is the first request for it
+	Shader* get(const std::string& shaderPath, const ShaderDefines& defines = ShaderDefines());
+
+	size_t getVariantCount() const;
+
+	// Deletes every program, pointers returned by get() are invalid afterwards
+	void free();
+};
+
+ShaderDefines& ShaderDefines::set(const std::string& name, int value)
+{
+	m_Values[name] = value;
+	return *this;
+}
+
+std::string ShaderDefines::getSource() const
+{
+	std::string source;
+
+	for (const auto& [name, value] : m_Values)
+		source += "#define " + name + " " + std::to_string(value) + "\n";
+
+	return source;
+}
+
+inline ShaderVariants& ShaderVariants::getInstance()
+{
+	static ShaderVariants variants;
+	return variants;
+}
+
+Shader* ShaderVariants::get(const std::string& shaderPath, const ShaderDefines& defines)
+{
+	const std::string source = defines.getSource();
+	const std::string key = shaderPath + "\n" + source;
+
+	auto it = m_Variants.find(key);
+	if (it != m_Variants.end())
+		return it->second.get();
+
+	auto shader = std::make_unique<Shader>();
+	shader->load(shaderPath, source);
+
+	Shader* result = shader.get();
+	m_Variants.emplace(key, std::move(shader));
+
+	return result;
+}
+
+size_t ShaderVariants::getVariantCount() const
+{
+	return m_Variants.size();
+}
+
+void ShaderVariants::free()
+{
+	for (auto& [key, shader] : m_Variants)
+		GLState::get().deleteProgram(shader->id);
+
+	m_Variants.clear();
+}
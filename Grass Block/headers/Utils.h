@@ -11,6 +11,7 @@
 #include "BufferLayout.h"
 #include "Texture2D.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
 #include "Camera.h"
 
 #include "random.h"
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 template<typename T>
 class VertexBuffer
 {
@@ -37,19 +39,19 @@ void VertexBuffer<T>::generate(size_t vertexCount)
 	m_VertexCount = vertexCount;
 
 	glGenBuffers(1, &m_VertexBufferID);
-	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
 }
 
 template<typename T>
 void VertexBuffer<T>::bind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
 }
 
 template<typename T>
 void VertexBuffer<T>::unbind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 template<typename T>
@@ -74,7 +76,7 @@ size_t VertexBuffer<T>::getVertexCount() const
 template<typename T>
 void VertexBuffer<T>::free() const
 {
-	glDeleteBuffers(1, &m_VertexBufferID);
+	GLState::get().deleteBuffers(1, &m_VertexBufferID);
 }
 
 template<typename T>
@@ -0,0 +1,189 @@
+// Phong lighting shared by the lighting shaders, include it in the fragment section.
+//
+// What gets compiled is chosen by the defines of the variant (see ShaderVariants.h), so a program only contains the
+// lights it uses:
+//	NR_POINT_LIGHTS		number of point lights, 0 for none
+//	DIR_LIGHT			directional light on (1) or off (0)
+//	SPOT_LIGHT			spot light on (1) or off (0)
+//	SPECULAR			specular highlights on (1) or off (0)
+//	TEXTURED			diffuse and specular maps (1) or the flat u_material.vColor (0), needs 'TexCoords' if set
+
+struct Material
+{
+#if TEXTURED
+	sampler2D diffuse;
+	sampler2D specular;
+#else
+	vec3 vColor;
+#endif
+
+	float fShininess;
+};
+
+struct DirLight
+{
+	vec3 vDirection;
+	vec3 vLightColor;
+
+	vec3 vAmbient;
+	vec3 vDiffuse;
+	vec3 vSpecular;
+};
+
+struct PointLight
+{
+	vec3 vPosition;
+	vec3 vLightColor;
+
+	float fConstant;
+	float fLinear;
+	float fQuadratic;
+
+	vec3 vAmbient;
+	vec3 vDiffuse;
+	vec3 vSpecular;
+};
+
+struct SpotLight
+{
+	vec3 vPosition;
+	vec3 vDirection;
+	vec3 vLightColor;
+
+	vec3 vAmbient;
+	vec3 vDiffuse;
+	vec3 vSpecular;
+
+	float fCutOff;
+	float fOuterCutOff;
+
+	float fConstant;
+	float fLinear;
+	float fQuadratic;
+};
+
+// Uniforms are indicated by the 'u_' prefix
+
+#if DIR_LIGHT
+uniform DirLight u_dirLight;
+#endif
+
+#if NR_POINT_LIGHTS > 0
+uniform PointLight u_pointLights[NR_POINT_LIGHTS];
+#endif
+
+#if SPOT_LIGHT
+uniform SpotLight u_spotLight;
+#endif
+
+uniform vec3 u_vViewPos;
+uniform Material u_material;
+
+// Specular part of a light, black if the variant has no highlights
+vec3 CalcSpecular(vec3 vLightSpecular, vec3 vLightDir, vec3 vNormal, vec3 vViewDir, vec3 vSpecularColor)
+{
+#if SPECULAR
+	vec3 vReflectDir = reflect(-vLightDir, vNormal);
+	float fSpec = pow(max(dot(vViewDir, vReflectDir), 0.0f), u_material.fShininess);
+	return vLightSpecular * fSpec * vSpecularColor;
+#else
+	return vec3(0.0f);
+#endif
+}
+
+vec3 CalcDirLight(DirLight light, vec3 vNormal, vec3 vViewDir, vec3 vColor, vec3 vSpecularColor)
+{
+	vec3 vLightDir = normalize(-light.vDirection);
+
+	// Ambient shading
+	vec3 vAmbient = light.vAmbient * vColor;
+
+	// Diffuse shading
+	float fDiff = max(dot(vNormal, vLightDir), 0.0f);
+	vec3 vDiffuse = light.vDiffuse * fDiff * vColor;
+
+	// Specular shading
+	vec3 vSpecular = CalcSpecular(light.vSpecular, vLightDir, vNormal, vViewDir, vSpecularColor);
+
+	return light.vLightColor * (vAmbient + vDiffuse + vSpecular);
+}
+
+vec3 CalcPointLight(PointLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir, vec3 vColor, vec3 vSpecularColor)
+{
+	vec3 vLightDir = normalize(light.vPosition - vFragPos);
+
+	// Ambient shading
+	vec3 vAmbient = light.vAmbient * vColor;
+
+	// Diffuse shading
+	float fDiff = max(dot(vNormal, vLightDir), 0.0f);
+	vec3 vDiffuse = light.vDiffuse * fDiff * vColor;
+
+	// Specular shading
+	vec3 vSpecular = CalcSpecular(light.vSpecular, vLightDir, vNormal, vViewDir, vSpecularColor);
+
+	// Attenuation
+	float fDistance = length(light.vPosition - vFragPos);
+	float fAttenuation = 1.0f / (light.fConstant + light.fLinear * fDistance + light.fQuadratic * (fDistance * fDistance));
+
+	// We'll leave out attenuating the ambient shading
+	return light.vLightColor * (vAmbient + (vDiffuse + vSpecular) * fAttenuation);
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir, vec3 vColor, vec3 vSpecularColor)
+{
+	vec3 vLightDir = normalize(light.vPosition - vFragPos);
+
+	// Ambient shading
+	vec3 vAmbient = light.vAmbient * vColor;
+
+	// Diffuse shading
+	float fDiff = max(dot(vLightDir, vNormal), 0.0f);
+	vec3 vDiffuse = light.vDiffuse * fDiff * vColor;
+
+	// Specular shading
+	vec3 vSpecular = CalcSpecular(light.vSpecular, vLightDir, vNormal, vViewDir, vSpecularColor);
+
+	// SpotLight
+	float fTheta = dot(vLightDir, normalize(-light.vDirection));
+	float fEpsilion = light.fCutOff - light.fOuterCutOff;
+	float fIntensity = clamp((fTheta - light.fOuterCutOff) / fEpsilion, 0.0f, 1.0f);
+
+	// Attenuation
+	float fDistance = length(light.vPosition - vFragPos);
+	float fAttenuation = 1.0f / (light.fConstant + light.fLinear * fDistance + light.fQuadratic * (fDistance * fDistance));
+
+	return light.vLightColor * (vAmbient + (vDiffuse + vSpecular) * fIntensity) * fAttenuation;
+}
+
+// Sum of all lights of the variant
+vec3 CalcLighting(vec3 vNormal, vec3 vFragPos)
+{
+	vec3 vViewDir = normalize(u_vViewPos - vFragPos);
+
+	// The material is sampled once instead of once per light
+#if TEXTURED
+	vec3 vColor = texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vSpecularColor = texture(u_material.specular, TexCoords).rgb;
+#else
+	vec3 vColor = u_material.vColor;
+	vec3 vSpecularColor = u_material.vColor;
+#endif
+
+	vec3 vResult = vec3(0.0f, 0.0f, 0.0f);
+
+#if DIR_LIGHT
+	vResult += CalcDirLight(u_dirLight, vNormal, vViewDir, vColor, vSpecularColor);
+#endif
+
+#if NR_POINT_LIGHTS > 0
+	for (int i = 0; i < NR_POINT_LIGHTS; i++)
+		vResult += CalcPointLight(u_pointLights[i], vNormal, vFragPos, vViewDir, vColor, vSpecularColor);
+#endif
+
+#if SPOT_LIGHT
+	vResult += CalcSpotLight(u_spotLight, vNormal, vFragPos, vViewDir, vColor, vSpecularColor);
+#endif
+
+	return vResult;
+}
@@ -0,0 +1,72 @@
+// Vertex and fragment stages of the lighting shaders, see Lights.glsl for the defines choosing the variant.
+// Including shaders may define their own defaults first, the defines of the variant take precedence over both.
+
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 1
+#endif
+
+#ifndef DIR_LIGHT
+#define DIR_LIGHT 1
+#endif
+
+#ifndef SPOT_LIGHT
+#define SPOT_LIGHT 1
+#endif
+
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+
+#ifndef TEXTURED
+#define TEXTURED 0
+#endif
+
+#ifdef SHADER_VERTEX
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+#if TEXTURED
+layout (location = 2) in vec2 aTexCoords;
+#endif
+
+uniform mat4 matModel;
+uniform mat3 matNormal;		// Transpose of the inverse of matModel, computed on the CPU
+uniform mat4 matView;
+uniform mat4 matProjection;
+
+out vec3 vNormal;
+out vec3 vFragPos;
+#if TEXTURED
+out vec2 TexCoords;
+#endif
+
+void main()
+{
+	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
+
+	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
+	vNormal = matNormal * vNorm;
+#if TEXTURED
+	TexCoords = aTexCoords;
+#endif
+}
+#endif
+
+#ifdef SHADER_FRAGMENT
+
+in vec3 vNormal;
+in vec3 vFragPos;
+#if TEXTURED
+in vec2 TexCoords;
+#endif
+
+out vec4 FragColor;
+
+#include "Lights.glsl"
+
+void main()
+{
+	FragColor = vec4(CalcLighting(normalize(vNormal), vFragPos), 1.0f);
+}
+
+#endif
@@ -130,7 +130,7 @@ public:
 		vCameraPos = vPos;
 	}
 
-	void UpdateView(Shader shader, const std::string& viewMat4ID)
+	void UpdateView(Shader& shader, const std::string& viewMat4ID)
 	{
 		shader.use();
 		shader.setMat4(viewMat4ID, matView);
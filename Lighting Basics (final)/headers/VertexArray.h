@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 class VertexArray
 {
 private:
@@ -15,21 +17,21 @@ public:
 	void generate()
 	{
 		glGenVertexArrays(1, &m_VertexArrayID);
-		glBindVertexArray(m_VertexArrayID);
+		GLState::get().bindVertexArray(m_VertexArrayID);
 	}
 
 	void bind() const
 	{
-		glBindVertexArray(m_VertexArrayID);
+		GLState::get().bindVertexArray(m_VertexArrayID);
 	}
 
 	void unbind() const
 	{
-		glBindVertexArray(0);
+		GLState::get().bindVertexArray(0);
 	}
 
 	void free() const
 	{
-		glDeleteVertexArrays(1, &m_VertexArrayID);
+		GLState::get().deleteVertexArrays(1, &m_VertexArrayID);
 	}
 };
\ No newline at end of file
@@ -120,10 +120,10 @@ public:
 		cubeShader.setInt("u_material.specular", 1);
 
 		// Activate textures
-		glActiveTexture(GL_TEXTURE0);
+		GLState::get().activeTexture(0);
 		diffuseTexture.bindTexture();
 
-		glActiveTexture(GL_TEXTURE1);
+		GLState::get().activeTexture(1);
 		specularTexture.bindTexture();
 
 		// Set projection matrix in shaders as they do not change often
@@ -239,6 +239,7 @@ public:
 		glm::mat4 matModel = glm::mat4(1.0f);
 		matModel = glm::translate(matModel, glm::vec3(0.0f, 0.0f, 0.0f));
 		cubeShader.setMat4("matModel", matModel);
+		cubeShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		// Draw the moving cube
 		glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -247,6 +248,7 @@ public:
 		matModel = glm::mat4(1.0f);
 		matModel = glm::translate(matModel, glm::vec3(0.0f, 0.0f, 1.0f));
 		cubeShader.setMat4("matModel", matModel);
+		cubeShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		// Draw the moving cube
 		glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -258,6 +260,7 @@ public:
 			matModel = glm::translate(matModel, cubePos);
 			matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 			cubeShader.setMat4("matModel", matModel);
+			cubeShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
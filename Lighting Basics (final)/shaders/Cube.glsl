@@ -5,6 +5,7 @@ layout (location = 1) in vec3 vNorm;
 layout (location = 2) in vec2 aTexCoords;
 
 uniform mat4 matModel;
+uniform mat3 matNormal;		// Transpose of the inverse of matModel, computed on the CPU
 uniform mat4 matView;
 uniform mat4 matProjection;
 
@@ -17,7 +18,7 @@ void main()
 	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
 
 	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
-	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
+	vNormal = matNormal * vNorm;
 	TexCoords = aTexCoords;
 }
 #endif
@@ -362,9 +362,10 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char* argv[])
 {
 	Window window;
+	window.ParseArguments(argc, argv);
 	window.ConstructWindow(800, 600, "OpenGL");
 	window.Start();
 
@@ -23,6 +23,10 @@ private:
 	std::vector<Texture2D> textures;
 	int nr_indices = 0;
 
+	// Normal matrix of matModel, recomputed by getNormalMatrix() only when matModel changes
+	glm::mat4 matNormalSource = glm::mat4(1.0f);
+	glm::mat3 matNormal = glm::mat3(1.0f);
+
 public:
 	glm::mat4 matModel = glm::mat4(1.0f);
 
@@ -38,6 +42,9 @@ public:
 	// Function which draws the model onto the screen. Make sure to bind shaders and VAO before calling this function.
 	void draw();
 
+	// Transpose of the inverse of matModel, for transforming normals. Saves the shaders inverting matModel for every vertex.
+	const glm::mat3& getNormalMatrix();
+
 	// Destructor
 	~Model();
 
@@ -56,7 +63,7 @@ void Model::bindTextures()
 	// Bind textures
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 }
@@ -68,6 +75,17 @@ void Model::draw()
 	glDrawArrays(GL_TRIANGLES, 0, nr_indices);
 }
 
+const glm::mat3& Model::getNormalMatrix()
+{
+	if (matModel != matNormalSource)
+	{
+		matNormal = glm::transpose(glm::inverse(glm::mat3(matModel)));
+		matNormalSource = matModel;
+	}
+
+	return matNormal;
+}
+
 Model::~Model()
 {
 	vbo.free();
@@ -4,6 +4,7 @@ layout (location = 0) in vec3 vPos;
 layout (location = 1) in vec3 vNorm;
 
 uniform mat4 matModel;
+uniform mat3 matNormal;		// Transpose of the inverse of matModel, computed on the CPU
 uniform mat4 matView;
 uniform mat4 matProjection;
 
@@ -15,7 +16,7 @@ void main()
 	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
 
 	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
-	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
+	vNormal = matNormal * vNorm;
 }
 #endif
 
@@ -6,15 +6,29 @@
 #include "VertexData.h"
 #include "Model.h"
 #include "Renderer.h"
+#include "SceneUniforms.h"
 
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
 #include <vector>
 
 // Upper limit of random number generator. For lower limit, negate this value.
 constexpr int MAX_RAND = 100;
 
+// Small lamps circling above the platform, on top of the main lamp
+constexpr int NR_LAMPS = 256;
+
+// Path of one of the small lamps
+struct LampOrbit
+{
+	glm::vec3 vCenter;
+	float fRadius;
+	float fSpeed;
+	float fPhase;
+};
+
 class Window : public OpenGL_Graphics
 {
 private:
@@ -38,9 +52,18 @@ private:
 	Shader terrainShader;
 	Shader lampShader;
 
+	// Camera and lights, shared by all shaders through uniform blocks
+	SceneUniforms sceneUniforms;
+
+	// Point lights, assigned to clusters of the view every frame. The main lamp is light 0.
+	ClusteredLights clusteredLights;
+	std::vector<LampOrbit> lampOrbits;
+
 	// Projection matrix
 	glm::mat4 matProjection;
 	float fFov = 80.0f;
+	const float fNear = 0.1f;
+	const float fFar = 1000.0f;
 
 	// Camera
 	Camera camera;
@@ -70,6 +93,17 @@ public:
 		// Load lamp shader
 		lampShader.load("shaders/Lamp.glsl");
 
+		// Connect the shaders to the shared camera and light blocks
+		sceneUniforms.generate();
+		sceneUniforms.attach(axesShader);
+		sceneUniforms.attach(lightingShader);
+		sceneUniforms.attach(terrainShader);
+		sceneUniforms.attach(lampShader);
+
+		clusteredLights.generate();
+		clusteredLights.attach(lightingShader);
+		clusteredLights.attach(terrainShader);
+
 		// Models
 		cubeModel.load("models/Cube.obj");
 		spaceshipModel.load("models/SpaceShip.obj");
@@ -84,7 +118,8 @@ public:
 		renderer.addModel(&terrainModel, &terrainShader);
 		renderer.addModel(&lampModel, &lampShader);
 
-		// Initalize shaders
+		// Initalize lights and shaders
+		InitalizeLights();
 		InitalizeLightingShader();
 		InitalizeTerrainShader();
 		
@@ -92,16 +127,8 @@ public:
 		lampShader.use();
 		lampShader.setVec3("vLampColor", vLampColor);
 
-		// Set projection matrix in shaders as they do not change often
-		matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-		axesShader.use();
-		axesShader.setMat4("matProjection", matProjection);
-		lightingShader.use();
-		lightingShader.setMat4("matProjection", matProjection);
-		terrainShader.use();
-		terrainShader.setMat4("matProjection", matProjection);
-		lampShader.use();
-		lampShader.setMat4("matProjection", matProjection);
+		// Set projection matrix
+		SetProjectionMatrix();
 
 		return true;
 	}
@@ -116,8 +143,26 @@ public:
 		// Some shader variables and models need to update every frame, hence call them on every frame
 		UpdateShader();
 
-		// Render all objects
-		renderer.render();
+		// Render all objects inside the camera's view
+		{
+			ScopedCpuTimer cpuTimer(GetProfiler(), "Models");
+			ScopedGpuTimer gpuTimer(GetProfiler(), "Models");
+			renderer.render(camera.getFrustum(matProjection), camera.vCameraPos);
+		}
+
+		RenderLamps();
+
+		const CullingStats& stats = renderer.getStats();
+		const RenderStats& renderStats = renderer.getRenderStats();
+		const ClusterStats& lightStats = clusteredLights.getStats();
+
+		std::stringstream title;
+		title << " | Models drawn: " << stats.drawn << ", culled: " << stats.culled
+			<< " | State changes: " << renderStats.stateChanges << " (" << renderStats.bindsSkipped << " skipped)"
+			<< " | Lights: " << lightStats.visibleLights << '/' << lightStats.lightCount
+			<< ", clusters: " << lightStats.occupiedClusters << '/' << CLUSTER_COUNT
+			<< " (max " << lightStats.maxLightsPerCluster << ", avg " << std::fixed << std::setprecision(1) << lightStats.fAverageLightsPerCluster << ')';
+		SetTitleInfo(title.str());
 
 		// Displays coordinate axes (for debugging)
 		RenderAxis();
@@ -127,15 +172,25 @@ public:
 
 	void UpdateShader()
 	{
-		lightingShader.use();
-		lightingShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		lightingShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		lightingShader.setVec3("u_vViewPos", camera.vCameraPos);
+		// Move the small lamps along their orbits and sort all lamps into the clusters of the view
+		for (size_t i = 0; i < lampOrbits.size(); i++)
+		{
+			const LampOrbit& orbit = lampOrbits[i];
+			const float fAngle = orbit.fPhase + orbit.fSpeed * fTimeSinceStart;
 
-		terrainShader.use();
-		terrainShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		terrainShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		terrainShader.setVec3("u_vViewPos", camera.vCameraPos);
+			clusteredLights.lights[i + 1].vPosition = orbit.vCenter + orbit.fRadius * glm::vec3(cosf(fAngle), 0.0f, sinf(fAngle));
+		}
+
+		{
+			ScopedCpuTimer cpuTimer(GetProfiler(), "Clusters");
+			clusteredLights.update(sceneUniforms.camera.matView, matProjection, fNear, fFar, ScreenWidth(), ScreenHeight(), sceneUniforms.lights.clusters);
+		}
+
+		// The spot light is attached to the camera. Camera and lights go to the GPU in one buffer update.
+		sceneUniforms.lights.spotLight.vPosition = camera.vCameraPos;
+		sceneUniforms.lights.spotLight.vDirection = camera.vCameraFront;
+		sceneUniforms.camera.vViewPos = camera.vCameraPos;
+		sceneUniforms.upload();
 
 		// Changes lamp color but the light emitted is still white (weird isn't it?)
 		lampShader.use();
@@ -160,86 +215,107 @@ public:
 		lampModel.matModel = glm::scale(lampModel.matModel, glm::vec3(0.2f));
 	}
 
-	void InitalizeLightingShader()
+	void InitalizeLights()
 	{
-		lightingShader.use();
+		LightUniforms& lights = sceneUniforms.lights;
 
-		lightingShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		lightingShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		// ---------------------------------------- Directional light ---------------------------------------- 
+		lights.dirLight.vDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+		lights.dirLight.vLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		lightingShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		lightingShader.setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_dirLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lights.dirLight.vAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+		lights.dirLight.vDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		lights.dirLight.vSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		// ---------------------------------------- Point light ---------------------------------------- 
-		// TODO: Implement multiple lamps using a for-loop
-		lightingShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		lightingShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		// ---------------------------------------- Point lights ---------------------------------------- 
+		PointLight lamp;
+		lamp.vPosition = vLampPos;
+		lamp.vLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		lightingShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		lightingShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		lightingShader.setFloat("u_pointLights[0].fLinear", 0.014f);
-		lightingShader.setFloat("u_pointLights[0].fQuadratic", 0.0007f);
+		lamp.vAmbient = glm::vec3(0.3f, 0.3f, 0.3f);
+		lamp.vDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		lamp.vSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+		lamp.fConstant = 1.0f;
+		lamp.fLinear = 0.014f;
+		lamp.fQuadratic = 0.0007f;
+		lamp.fRadius = 60.0f;
 
-		lightingShader.setFloat("u_material.fShininess", 64.0f);
-		lightingShader.setVec3("u_material.vColor", glm::vec3(0.5f, 0.5f, 0.5f));
+		clusteredLights.lights.push_back(lamp);
+
+		// Benchmarks and headless runs always place the small lamps the same way
+		if (IsHeadless() || IsBenchmark())
+			Random::mt.seed(1337u);
+
+		for (int i = 0; i < NR_LAMPS; i++)
+		{
+			LampOrbit orbit;
+			orbit.vCenter = glm::vec3(random() * 0.45f, -9.0f + Random::get(0, 30) * 0.1f, random() * 0.45f);
+			orbit.fRadius = Random::get(10, 60) * 0.1f;
+			orbit.fSpeed = Random::get(-100, 100) * 0.01f;
+			orbit.fPhase = Random::get(0, 628) * 0.01f;
+			lampOrbits.push_back(orbit);
+
+			PointLight light;
+			light.vLightColor = glm::vec3(Random::get(20, 100), Random::get(20, 100), Random::get(20, 100)) * 0.01f;
+			light.vAmbient = glm::vec3(0.05f);
+			light.vDiffuse = glm::vec3(1.0f);
+			light.vSpecular = glm::vec3(0.5f);
+			light.fLinear = 0.35f;
+			light.fQuadratic = 0.44f;
+			light.fRadius = 5.0f;
+			clusteredLights.lights.push_back(light);
+		}
 
 		// ---------------------------------------- Spot light ---------------------------------------- 
-		lightingShader.setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 0.0f, 1.0f));
+		// Position and direction follow the camera, see UpdateShader()
+		lights.spotLight.vLightColor = glm::vec3(0.0f, 0.0f, 1.0f);
 
-		lightingShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		lightingShader.setVec3("u_spotLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		lightingShader.setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lights.spotLight.vAmbient = glm::vec3(0.6f, 0.6f, 0.6f);
+		lights.spotLight.vDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		lights.spotLight.vSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		lightingShader.setFloat("u_spotLight.fConstant", 1.0f);
-		lightingShader.setFloat("u_spotLight.fLinear", 0.22f);
-		lightingShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+		lights.spotLight.fConstant = 1.0f;
+		lights.spotLight.fLinear = 0.22f;
+		lights.spotLight.fQuadratic = 0.20f;
 
 		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		lightingShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		lightingShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+		lights.spotLight.fCutOff = cosf(30.0f * pi / 180.0f);
+		lights.spotLight.fOuterCutOff = cosf(45.0f * pi / 180.0f);
 	}
 
-	void InitalizeTerrainShader()
+	void InitalizeLightingShader()
 	{
-		terrainShader.use();
-
-		terrainShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		terrainShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-
-		terrainShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		terrainShader.setVec3("u_dirLight.vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-
-		// ---------------------------------------- Point light ---------------------------------------- 
-		// TODO: Implement multiple lamps using a for-loop
-		terrainShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		terrainShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		lightingShader.use();
 
-		terrainShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		terrainShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(0.7f, 0.7f, 0.7f));
+		lightingShader.setFloat("u_material.fShininess", 64.0f);
+		lightingShader.setVec3("u_material.vColor", glm::vec3(0.5f, 0.5f, 0.5f));
+	}
 
-		terrainShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		terrainShader.setFloat("u_pointLights[0].fLinear", 0.014f);
-		terrainShader.setFloat("u_pointLights[0].fQuadratic", 0.0007f);
+	void InitalizeTerrainShader()
+	{
+		terrainShader.use();
 
 		terrainShader.setFloat("u_material.fShininess", 64.0f);
 		terrainShader.setVec3("u_material.vColor", glm::vec3(0.13f, 0.55f, 0.13f));
+	}
 
-		// ---------------------------------------- Spot light ---------------------------------------- 
-		terrainShader.setVec3("u_spotLight.vLightColor", glm::vec3(0.0f, 1.0f, 0.0f));
+	void RenderLamps()
+	{
+		// The main lamp is drawn by the renderer
+		lampShader.use();
 
-		terrainShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		terrainShader.setVec3("u_spotLight.vDiffuse", glm::vec3(0.2f, 0.2f, 0.2f));
+		for (size_t i = 1; i < clusteredLights.lights.size(); i++)
+		{
+			const PointLight& light = clusteredLights.lights[i];
 
-		terrainShader.setFloat("u_spotLight.fConstant", 1.0f);
-		terrainShader.setFloat("u_spotLight.fLinear", 0.22f);
-		terrainShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+			glm::mat4 matModel = glm::mat4(1.0f);
+			matModel = glm::translate(matModel, light.vPosition);
+			matModel = glm::scale(matModel, glm::vec3(0.1f));
 
-		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		terrainShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		terrainShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+			lampShader.setMat4("matModel", matModel);
+			lampShader.setVec3("vLampColor", light.vLightColor);
+			lampModel.draw();
+		}
 	}
 
 	void RenderAxis()
@@ -278,76 +354,87 @@ public:
 
 	void HandleInputs(float fElapsedTime)
 	{
-		/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
-		if (GetKey('W').bHeld && !GetKey('S').bHeld)
-			camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
-		else if (GetKey('S').bHeld && !GetKey('W').bHeld)
-			camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
-
-		if (GetKey('A').bHeld && !GetKey('D').bHeld)
-			camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
-		else if (GetKey('D').bHeld && !GetKey('A').bHeld)
-			camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
-
-		if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
-			camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
-		else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
-			camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
-
-		// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
-		if (GetKey('C').bHeld)
+		// Benchmarks replay a camera path instead of reading the inputs
+		CameraPose pose;
+		if (GetBenchmarkPose(pose))
 		{
-			if (fFov > 10.0f)
-				fFov -= fElapsedTime * 200.0f;
-
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			lightingShader.use();
-			lightingShader.setMat4("matProjection", matProjection);
-			terrainShader.use();
-			terrainShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
-		}
+			camera.setPose(pose);
 
-		else if (GetKey('C').bReleased)
-		{
-			fFov = 80.0f;
-
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			lightingShader.use();
-			lightingShader.setMat4("matProjection", matProjection);
-			terrainShader.use();
-			terrainShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
+			if (pose.fFov != fFov)
+			{
+				fFov = pose.fFov;
+				SetProjectionMatrix();
+			}
 		}
 
-		if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
-			camera.fCameraSpeed = 20.0f;
 		else
-			camera.fCameraSpeed = 5.0f;
-
-		if (GetKey(GLFW_KEY_HOME).bPressed)
-			camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		{
+			/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
+			if (GetKey('W').bHeld && !GetKey('S').bHeld)
+				camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
+			else if (GetKey('S').bHeld && !GetKey('W').bHeld)
+				camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
+
+			if (GetKey('A').bHeld && !GetKey('D').bHeld)
+				camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
+			else if (GetKey('D').bHeld && !GetKey('A').bHeld)
+				camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
+
+			if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
+				camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
+			else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
+				camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
+
+			// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
+			if (GetKey('C').bHeld)
+			{
+				if (fFov > 10.0f)
+					fFov -= fElapsedTime * 200.0f;
+
+				SetProjectionMatrix();
+			}
+
+			else if (GetKey('C').bReleased)
+			{
+				fFov = 80.0f;
+
+				SetProjectionMatrix();
+			}
+
+			if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
+				camera.fCameraSpeed = 20.0f;
+			else
+				camera.fCameraSpeed = 5.0f;
+
+			if (GetKey(GLFW_KEY_HOME).bPressed)
+				camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+
+			/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
+			camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+
+			// Saved with --record, to be replayed with --benchmark
+			pose = camera.getPose();
+			pose.fFov = fFov;
+			RecordCameraPose(pose);
+		}
 
-		/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
-		camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+		// Update view matrix, uploaded with the other shared uniforms in UpdateShader()
+		sceneUniforms.camera.matView = camera.getLookAt();
+	}
 
-		// Update view matrix
-		camera.UpdateView(axesShader, "matView");
-		camera.UpdateView(lightingShader, "matView");
-		camera.UpdateView(terrainShader, "matView");
-		camera.UpdateView(lampShader, "matView");
+	void SetProjectionMatrix()
+	{
+		// Shared by all shaders through the Camera block, uploaded every frame in UpdateShader()
+		matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), fNear, fFar);
+		sceneUniforms.camera.matProjection = matProjection;
 	}
 
 	void Destroy() override
 	{
 		axesVAO.free();
 		axesVBO.free();
+		sceneUniforms.free();
+		clusteredLights.free();
 
 		std::cout << "\nDuration: " << std::fixed << std::setprecision(2) << fTimeSinceStart << 's' << std::endl;
 	}
@@ -358,9 +445,10 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char* argv[])
 {
 	Window window;
+	window.ParseArguments(argc, argv);
 	window.ConstructWindow(800, 600, "OpenGL");
 	window.Start();
 
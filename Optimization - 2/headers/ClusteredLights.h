@@ -0,0 +1,390 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Shader.h"
+#include "GLState.h"
+
+// Size of the light grid: tiles across and up the screen, and slices along the view depth
+constexpr unsigned int CLUSTER_X = 16;
+constexpr unsigned int CLUSTER_Y = 9;
+constexpr unsigned int CLUSTER_Z = 24;
+constexpr unsigned int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+// Texture units of the buffer textures read by the lighting shaders, above the ones used by materials
+constexpr int CLUSTER_CELLS_TEXTURE_UNIT = 13;
+constexpr int CLUSTER_INDICES_TEXTURE_UNIT = 14;
+constexpr int POINT_LIGHTS_TEXTURE_UNIT = 15;
+
+struct PointLight
+{
+	glm::vec3 vPosition = glm::vec3(0.0f);
+	glm::vec3 vLightColor = glm::vec3(1.0f);
+
+	glm::vec3 vAmbient = glm::vec3(0.0f);
+	glm::vec3 vDiffuse = glm::vec3(1.0f);
+	glm::vec3 vSpecular = glm::vec3(1.0f);
+
+	float fConstant = 1.0f;
+	float fLinear = 0.0f;
+	float fQuadratic = 0.0f;
+
+	// The light fades out towards this distance and has no effect beyond it
+	float fRadius = 10.0f;
+};
+
+/**
+  * Mirrors the cluster members of the Lights block (std140):
+  *
+  *	uvec4 u_vClusterSize;		// Tiles across, tiles up, depth slices, number of lights
+  *	vec4 u_vClusterScale;		// Tile width and height in pixels, depth slice scale and bias
+  */
+struct ClusterUniforms
+{
+	glm::uvec4 vSize = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, 0);
+	glm::vec4 vScale = glm::vec4(1.0f);
+};
+
+static_assert(sizeof(ClusterUniforms) == 32, "ClusterUniforms doesn't match the std140 layout of the Lights block");
+
+// Light and cluster counts of the last call to ClusteredLights::update()
+struct ClusterStats
+{
+	size_t lightCount = 0;
+	size_t visibleLights = 0;
+
+	size_t occupiedClusters = 0;
+	size_t maxLightsPerCluster = 0;
+
+	// Sum of the light lists of all clusters
+	size_t indexCount = 0;
+
+	// Average over the occupied clusters only
+	float fAverageLightsPerCluster = 0.0f;
+};
+
+/**
+  * Clustered forward shading for many point lights.
+  *
+  * The view frustum is split into CLUSTER_X x CLUSTER_Y screen tiles and CLUSTER_Z slices along the view depth
+  * (spaced exponentially, so clusters near the camera are thin). Every frame, update() tests the sphere of each
+  * light against the clusters it may touch and builds a list of lights per cluster on the CPU. Three buffer
+  * textures carry the result to the shaders:
+  *
+  *	cells		RG32UI, per cluster: offset into the index list and number of lights
+  *	indices		R32UI, the light lists of all clusters one after the other
+  *	lights		RGBA32F, 4 texels per light (see UploadLights())
+  *
+  * A fragment finds its cluster from gl_FragCoord and its view depth and only shades the lights in that list.
+  */
+class ClusteredLights
+{
+private:
+	// Buffers and the buffer textures reading them, in the order cells, indices, lights
+	unsigned int m_Buffers[3] = { 0, 0, 0 };
+	unsigned int m_Textures[3] = { 0, 0, 0 };
+
+	// View space bounding box of every cluster, rebuilt when the projection changes
+	std::vector<glm::vec3> m_ClusterMin;
+	std::vector<glm::vec3> m_ClusterMax;
+	glm::mat4 m_matProjection = glm::mat4(0.0f);
+	float m_fNear = 0.0f;
+	float m_fFar = 0.0f;
+
+	// Scratch buffers of update()
+	std::vector<glm::uvec2> m_Cells;
+	std::vector<unsigned int> m_Indices;
+	std::vector<glm::uvec2> m_Assignments;		// Cluster and light
+	std::vector<glm::vec4> m_LightTexels;
+
+	ClusterStats m_Stats;
+
+public:
+	// Lights to shade, in world space. Can be changed freely between frames.
+	std::vector<PointLight> lights;
+
+	ClusteredLights() = default;
+
+	ClusteredLights(const ClusteredLights&) = delete;
+	ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+	void generate();
+
+	// Connects the buffer textures of a shader (if it uses them) to their texture units. Once per shader.
+	void attach(Shader& shader);
+
+	// Assigns the lights to the clusters of the view, uploads the result and binds the buffer textures.
+	// 'uniforms' receives the grid parameters for the Lights block. Call once per frame before drawing.
+	void update(const glm::mat4& matView, const glm::mat4& matProjection, float fNear, float fFar, int width, int height, ClusterUniforms& uniforms);
+
+	const ClusterStats& getStats() const;
+
+	void free();
+
+private:
+	void BuildClusterBounds(const glm::mat4& matProjection, float fNear, float fFar);
+	void UploadLights();
+
+	static unsigned int GetSlice(float fDepth, float fNear, float fFar);
+	static bool SphereIntersectsBox(const glm::vec3& vCenter, float fRadius, const glm::vec3& vMin, const glm::vec3& vMax);
+};
+
+void ClusteredLights::generate()
+{
+	const GLenum formats[3] = { GL_RG32UI, GL_R32UI, GL_RGBA32F };
+
+	glGenBuffers(3, m_Buffers);
+	glGenTextures(3, m_Textures);
+
+	for (int i = 0; i < 3; i++)
+	{
+		// Buffer textures can't be empty, so start out with a little storage
+		glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+
+		GLState::get().bindTexture(GL_TEXTURE_BUFFER, m_Textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_Buffers[i]);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	GLState::get().bindTexture(GL_TEXTURE_BUFFER, 0);
+
+	m_Cells.resize(CLUSTER_COUNT);
+}
+
+void ClusteredLights::attach(Shader& shader)
+{
+	shader.use();
+	shader.setInt("u_clusterCells", CLUSTER_CELLS_TEXTURE_UNIT);
+	shader.setInt("u_clusterLightIndices", CLUSTER_INDICES_TEXTURE_UNIT);
+	shader.setInt("u_pointLights", POINT_LIGHTS_TEXTURE_UNIT);
+}
+
+void ClusteredLights::update(const glm::mat4& matView, const glm::mat4& matProjection, float fNear, float fFar, int width, int height, ClusterUniforms& uniforms)
+{
+	if (matProjection != m_matProjection || fNear != m_fNear || fFar != m_fFar)
+		BuildClusterBounds(matProjection, fNear, fFar);
+
+	m_Assignments.clear();
+	std::fill(m_Cells.begin(), m_Cells.end(), glm::uvec2(0));
+
+	m_Stats = ClusterStats();
+	m_Stats.lightCount = lights.size();
+
+	const float fLogRatio = std::log(fFar / fNear);
+
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const PointLight& light = lights[i];
+
+		const glm::vec3 vCenter = glm::vec3(matView * glm::vec4(light.vPosition, 1.0f));
+		const float fRadius = light.fRadius;
+
+		// View space looks down -z
+		const float fDepth = -vCenter.z;
+		if (fDepth + fRadius < fNear || fDepth - fRadius > fFar)
+			continue;
+
+		const unsigned int z0 = GetSlice(std::max(fDepth - fRadius, fNear), fNear, fFar);
+		const unsigned int z1 = GetSlice(std::min(fDepth + fRadius, fFar), fNear, fFar);
+
+		// Screen tiles covered by the light's bounding box. A box reaching behind the near plane may cover any tile.
+		unsigned int x0 = 0, x1 = CLUSTER_X - 1, y0 = 0, y1 = CLUSTER_Y - 1;
+
+		if (fDepth - fRadius > fNear)
+		{
+			const float fNearest = fDepth - fRadius, fFarthest = fDepth + fRadius;
+
+			auto tileRange = [&](float fCenter, float fScale, unsigned int tiles, unsigned int& first, unsigned int& last)
+			{
+				const float fMin = fScale * std::min((fCenter - fRadius) / fNearest, (fCenter - fRadius) / fFarthest);
+				const float fMax = fScale * std::max((fCenter + fRadius) / fNearest, (fCenter + fRadius) / fFarthest);
+
+				// Normalized device coordinates to tiles
+				first = (unsigned int)std::clamp((fMin * 0.5f + 0.5f) * tiles, 0.0f, (float)tiles - 1.0f);
+				last = (unsigned int)std::clamp((fMax * 0.5f + 0.5f) * tiles, 0.0f, (float)tiles - 1.0f);
+			};
+
+			tileRange(vCenter.x, matProjection[0][0], CLUSTER_X, x0, x1);
+			tileRange(vCenter.y, matProjection[1][1], CLUSTER_Y, y0, y1);
+		}
+
+		bool bVisible = false;
+
+		for (unsigned int z = z0; z <= z1; z++)
+		{
+			for (unsigned int y = y0; y <= y1; y++)
+			{
+				for (unsigned int x = x0; x <= x1; x++)
+				{
+					const unsigned int cluster = x + CLUSTER_X * (y + CLUSTER_Y * z);
+
+					if (!SphereIntersectsBox(vCenter, fRadius, m_ClusterMin[cluster], m_ClusterMax[cluster]))
+						continue;
+
+					m_Assignments.push_back(glm::uvec2(cluster, (unsigned int)i));
+					m_Cells[cluster].y++;
+					bVisible = true;
+				}
+			}
+		}
+
+		if (bVisible)
+			m_Stats.visibleLights++;
+	}
+
+	// Offsets of the light lists, then place the lights of each cluster in its list
+	unsigned int offset = 0;
+	for (auto& cell : m_Cells)
+	{
+		cell.x = offset;
+		offset += cell.y;
+
+		if (cell.y > 0)
+		{
+			m_Stats.occupiedClusters++;
+			m_Stats.maxLightsPerCluster = std::max(m_Stats.maxLightsPerCluster, (size_t)cell.y);
+		}
+
+		// Counts again while filling the lists
+		cell.y = 0;
+	}
+
+	m_Indices.resize(std::max(offset, 1u));
+	for (const auto& assignment : m_Assignments)
+	{
+		glm::uvec2& cell = m_Cells[assignment.x];
+		m_Indices[cell.x + cell.y++] = assignment.y;
+	}
+
+	m_Stats.indexCount = offset;
+	if (m_Stats.occupiedClusters > 0)
+		m_Stats.fAverageLightsPerCluster = (float)offset / (float)m_Stats.occupiedClusters;
+
+	// Orphan the old storage, the previous frame may still be reading it
+	glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[0]);
+	glBufferData(GL_TEXTURE_BUFFER, m_Cells.size() * sizeof(glm::uvec2), m_Cells.data(), GL_STREAM_DRAW);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[1]);
+	glBufferData(GL_TEXTURE_BUFFER, m_Indices.size() * sizeof(unsigned int), m_Indices.data(), GL_STREAM_DRAW);
+
+	UploadLights();
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	const int textureUnits[3] = { CLUSTER_CELLS_TEXTURE_UNIT, CLUSTER_INDICES_TEXTURE_UNIT, POINT_LIGHTS_TEXTURE_UNIT };
+	for (int i = 0; i < 3; i++)
+		GLState::get().bindTexture(textureUnits[i], GL_TEXTURE_BUFFER, m_Textures[i]);
+
+	GLState::get().activeTexture(0);
+
+	// The shaders find the slice with log(depth) * scale + bias
+	uniforms.vSize = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, (unsigned int)lights.size());
+	uniforms.vScale.x = (float)width / CLUSTER_X;
+	uniforms.vScale.y = (float)height / CLUSTER_Y;
+	uniforms.vScale.z = CLUSTER_Z / fLogRatio;
+	uniforms.vScale.w = -(float)CLUSTER_Z * std::log(fNear) / fLogRatio;
+}
+
+const ClusterStats& ClusteredLights::getStats() const
+{
+	return m_Stats;
+}
+
+void ClusteredLights::free()
+{
+	if (m_Buffers[0])
+	{
+		GLState::get().deleteTextures(3, m_Textures);
+		GLState::get().deleteBuffers(3, m_Buffers);
+
+		for (int i = 0; i < 3; i++)
+			m_Buffers[i] = m_Textures[i] = 0;
+	}
+}
+
+// Private utility function - to compute the view space bounding box of every cluster for a symmetric perspective projection
+void ClusteredLights::BuildClusterBounds(const glm::mat4& matProjection, float fNear, float fFar)
+{
+	m_matProjection = matProjection;
+	m_fNear = fNear;
+	m_fFar = fFar;
+
+	m_ClusterMin.resize(CLUSTER_COUNT);
+	m_ClusterMax.resize(CLUSTER_COUNT);
+
+	for (unsigned int z = 0; z < CLUSTER_Z; z++)
+	{
+		const float fSliceNear = fNear * std::pow(fFar / fNear, (float)z / CLUSTER_Z);
+		const float fSliceFar = fNear * std::pow(fFar / fNear, (float)(z + 1) / CLUSTER_Z);
+
+		for (unsigned int y = 0; y < CLUSTER_Y; y++)
+		{
+			for (unsigned int x = 0; x < CLUSTER_X; x++)
+			{
+				// Tile corners in normalized device coordinates
+				const glm::vec2 vNdcMin = glm::vec2((float)x / CLUSTER_X, (float)y / CLUSTER_Y) * 2.0f - 1.0f;
+				const glm::vec2 vNdcMax = glm::vec2((float)(x + 1) / CLUSTER_X, (float)(y + 1) / CLUSTER_Y) * 2.0f - 1.0f;
+
+				const glm::vec2 vScale = glm::vec2(matProjection[0][0], matProjection[1][1]);
+
+				// The tile widens with depth, so the box spans its corners at both ends of the slice
+				const glm::vec2 vNearMin = vNdcMin * fSliceNear / vScale, vNearMax = vNdcMax * fSliceNear / vScale;
+				const glm::vec2 vFarMin = vNdcMin * fSliceFar / vScale, vFarMax = vNdcMax * fSliceFar / vScale;
+
+				const unsigned int cluster = x + CLUSTER_X * (y + CLUSTER_Y * z);
+				m_ClusterMin[cluster] = glm::vec3(glm::min(vNearMin, vFarMin), -fSliceFar);
+				m_ClusterMax[cluster] = glm::vec3(glm::max(vNearMax, vFarMax), -fSliceNear);
+			}
+		}
+	}
+}
+
+/**
+  * Private utility function - to fill the light buffer. Each light takes 4 texels, with the light color already
+  * multiplied in:
+  *
+  *	0: position, radius
+  *	1: ambient, constant
+  *	2: diffuse, linear
+  *	3: specular, quadratic
+  */
+void ClusteredLights::UploadLights()
+{
+	m_LightTexels.resize(std::max(lights.size(), (size_t)1) * 4);
+
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const PointLight& light = lights[i];
+
+		m_LightTexels[i * 4 + 0] = glm::vec4(light.vPosition, light.fRadius);
+		m_LightTexels[i * 4 + 1] = glm::vec4(light.vAmbient * light.vLightColor, light.fConstant);
+		m_LightTexels[i * 4 + 2] = glm::vec4(light.vDiffuse * light.vLightColor, light.fLinear);
+		m_LightTexels[i * 4 + 3] = glm::vec4(light.vSpecular * light.vLightColor, light.fQuadratic);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[2]);
+	glBufferData(GL_TEXTURE_BUFFER, m_LightTexels.size() * sizeof(glm::vec4), m_LightTexels.data(), GL_STREAM_DRAW);
+}
+
+// Private utility function - depth slice of a (positive) view depth, the inverse of the spacing in BuildClusterBounds()
+unsigned int ClusteredLights::GetSlice(float fDepth, float fNear, float fFar)
+{
+	const float fSlice = std::log(fDepth / fNear) / std::log(fFar / fNear) * CLUSTER_Z;
+	return (unsigned int)std::clamp(fSlice, 0.0f, (float)CLUSTER_Z - 1.0f);
+}
+
+// Private utility function - true if the sphere touches the box
+bool ClusteredLights::SphereIntersectsBox(const glm::vec3& vCenter, float fRadius, const glm::vec3& vMin, const glm::vec3& vMax)
+{
+	const glm::vec3 vClosest = glm::clamp(vCenter, vMin, vMax);
+	const glm::vec3 vOffset = vCenter - vClosest;
+
+	return glm::dot(vOffset, vOffset) <= fRadius * fRadius;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+// Math library
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Number of objects which passed and failed the frustum test in the last frame
+struct CullingStats
+{
+	size_t drawn = 0;
+	size_t culled = 0;
+};
+
+/**
+  * View frustum made up of 6 planes (left, right, bottom, top, near, far) pointing inwards.
+  * The planes are extracted from the combined projection * view matrix (Gribb & Hartmann), so they
+  * are in world space and can be tested directly against world space bounding boxes.
+  */
+struct Frustum
+{
+	// (a, b, c, d) with a*x + b*y + c*z + d >= 0 for points on the inside
+	glm::vec4 planes[6];
+
+	static Frustum fromMatrix(const glm::mat4& matViewProjection);
+
+	// Tests a single axis-aligned box given by its center and half-extents
+	bool intersects(const glm::vec3& vCenter, const glm::vec3& vExtents) const;
+};
+
+/**
+  * Axis-aligned bounding boxes stored as a structure of arrays (all center x values together, all center y
+  * values together, ...). This keeps the culling loop free of branches and gathers, so the compiler can
+  * vectorize it and test several boxes per instruction.
+  */
+class BoundingBoxes
+{
+private:
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+
+	// Scratch space for cull(), one entry per box
+	mutable std::vector<uint8_t> m_Inside;
+
+public:
+	void add(const glm::vec3& vMin, const glm::vec3& vMax);
+
+	void clear();
+
+	size_t size() const;
+
+	// Writes the indices of all boxes which intersect the frustum into 'visible', returns how many there are
+	size_t cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+	// World space bounds of a model space box after transforming it by 'matModel'
+	static void transform(const glm::mat4& matModel, const glm::vec3& vMin, const glm::vec3& vMax, glm::vec3& vOutMin, glm::vec3& vOutMax);
+};
+
+Frustum Frustum::fromMatrix(const glm::mat4& m)
+{
+	Frustum frustum;
+
+	// glm matrices are column-major, m[column][row]
+	const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	frustum.planes[0] = row3 + row0;	// Left
+	frustum.planes[1] = row3 - row0;	// Right
+	frustum.planes[2] = row3 + row1;	// Bottom
+	frustum.planes[3] = row3 - row1;	// Top
+	frustum.planes[4] = row3 + row2;	// Near
+	frustum.planes[5] = row3 - row2;	// Far
+
+	for (auto& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	return frustum;
+}
+
+bool Frustum::intersects(const glm::vec3& vCenter, const glm::vec3& vExtents) const
+{
+	for (const auto& plane : planes)
+	{
+		// Distance of the center from the plane, plus the largest distance a corner can add towards the plane
+		const glm::vec3 vNormal(plane);
+		const float fDistance = glm::dot(vNormal, vCenter) + plane.w;
+		const float fRadius = glm::dot(glm::abs(vNormal), vExtents);
+
+		if (fDistance + fRadius < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+void BoundingBoxes::add(const glm::vec3& vMin, const glm::vec3& vMax)
+{
+	const glm::vec3 vCenter = (vMin + vMax) * 0.5f;
+	const glm::vec3 vExtents = (vMax - vMin) * 0.5f;
+
+	m_CenterX.push_back(vCenter.x);
+	m_CenterY.push_back(vCenter.y);
+	m_CenterZ.push_back(vCenter.z);
+	m_ExtentX.push_back(vExtents.x);
+	m_ExtentY.push_back(vExtents.y);
+	m_ExtentZ.push_back(vExtents.z);
+}
+
+void BoundingBoxes::clear()
+{
+	m_CenterX.clear();
+	m_CenterY.clear();
+	m_CenterZ.clear();
+	m_ExtentX.clear();
+	m_ExtentY.clear();
+	m_ExtentZ.clear();
+}
+
+size_t BoundingBoxes::size() const
+{
+	return m_CenterX.size();
+}
+
+size_t BoundingBoxes::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	const size_t count = size();
+	visible.clear();
+
+	m_Inside.assign(count, 1);
+	uint8_t* inside = m_Inside.data();
+
+	const float* cx = m_CenterX.data();
+	const float* cy = m_CenterY.data();
+	const float* cz = m_CenterZ.data();
+	const float* ex = m_ExtentX.data();
+	const float* ey = m_ExtentY.data();
+	const float* ez = m_ExtentZ.data();
+
+	// One pass over all boxes per plane. The loop body has no branches, so it gets vectorized.
+	for (const auto& plane : frustum.planes)
+	{
+		const float nx = plane.x, ny = plane.y, nz = plane.z, d = plane.w;
+		const float ax = std::fabs(nx), ay = std::fabs(ny), az = std::fabs(nz);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float fDistance = nx * cx[i] + ny * cy[i] + nz * cz[i] + d;
+			const float fRadius = ax * ex[i] + ay * ey[i] + az * ez[i];
+			inside[i] &= (uint8_t)(fDistance + fRadius >= 0.0f);
+		}
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (inside[i])
+			visible.push_back((uint32_t)i);
+	}
+
+	return visible.size();
+}
+
+void BoundingBoxes::transform(const glm::mat4& matModel, const glm::vec3& vMin, const glm::vec3& vMax, glm::vec3& vOutMin, glm::vec3& vOutMax)
+{
+	const glm::vec3 vCenter = (vMin + vMax) * 0.5f;
+	const glm::vec3 vExtents = (vMax - vMin) * 0.5f;
+
+	// The extents of the transformed box are the extents projected onto the absolute values of the matrix axes
+	const glm::vec3 vNewCenter = glm::vec3(matModel * glm::vec4(vCenter, 1.0f));
+	const glm::mat3 matAbs = glm::mat3(glm::abs(glm::vec3(matModel[0])), glm::abs(glm::vec3(matModel[1])), glm::abs(glm::vec3(matModel[2])));
+	const glm::vec3 vNewExtents = matAbs * vExtents;
+
+	vOutMin = vNewCenter - vNewExtents;
+	vOutMax = vNewCenter + vNewExtents;
+}
@@ -4,11 +4,13 @@
 #include "VertexBuffer.h"
 #include "BufferLayout.h"
 #include "Texture2D.h"
+#include "Frustum.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <map>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -23,6 +25,18 @@ private:
 	std::vector<Texture2D> textures;
 	int nr_indices = 0;
 
+	// Texture set of the textures above, looked up again by getTextureSetID() only when they change
+	std::vector<unsigned int> textureSetSource;
+	unsigned int textureSetID = 0;
+
+	// Normal matrix of matModel, recomputed by getNormalMatrix() only when matModel changes
+	glm::mat4 matNormalSource = glm::mat4(1.0f);
+	glm::mat3 matNormal = glm::mat3(1.0f);
+
+	// Model space bounding box
+	glm::vec3 vBoundsMin = glm::vec3(0.0f);
+	glm::vec3 vBoundsMax = glm::vec3(0.0f);
+
 public:
 	glm::mat4 matModel = glm::mat4(1.0f);
 
@@ -38,11 +52,28 @@ public:
 	// Function which draws the model onto the screen. Make sure to bind shaders and VAO before calling this function.
 	void draw();
 
+	// Issues only the draw call, for callers which bind the vertex array and textures themselves (see RenderQueue)
+	void drawArrays() const;
+
+	const VertexArray& getVertexArray() const;
+
+	// Identifies the textures bindTextures() binds, in unit order. Models binding the same textures share an ID,
+	// so draws can be grouped by it. 0 if the model has no textures.
+	unsigned int getTextureSetID();
+
+	// Transpose of the inverse of matModel, for transforming normals. Saves the shaders inverting matModel for every vertex.
+	const glm::mat3& getNormalMatrix();
+
+	// Model space bounding box, used for frustum culling
+	const glm::vec3& getBoundsMin() const;
+	const glm::vec3& getBoundsMax() const;
+
 	// Destructor
 	~Model();
 
 private:
 	// Utility functions
+	static unsigned int GetTextureSetID(const std::vector<unsigned int>& textureIDs);
 	bool LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile);
 };
 
@@ -56,7 +87,7 @@ void Model::bindTextures()
 	// Bind textures
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 }
@@ -68,12 +99,73 @@ void Model::draw()
 	glDrawArrays(GL_TRIANGLES, 0, nr_indices);
 }
 
+void Model::drawArrays() const
+{
+	glDrawArrays(GL_TRIANGLES, 0, nr_indices);
+}
+
+const VertexArray& Model::getVertexArray() const
+{
+	return vao;
+}
+
+unsigned int Model::getTextureSetID()
+{
+	bool bChanged = textures.size() != textureSetSource.size();
+	for (size_t i = 0; i < textures.size() && !bChanged; i++)
+		bChanged = textures[i].getTextureID() != textureSetSource[i];
+
+	if (bChanged)
+	{
+		textureSetSource.clear();
+		for (const auto& texture : textures)
+			textureSetSource.push_back(texture.getTextureID());
+
+		textureSetID = GetTextureSetID(textureSetSource);
+	}
+
+	return textureSetID;
+}
+
+const glm::vec3& Model::getBoundsMin() const
+{
+	return vBoundsMin;
+}
+
+const glm::vec3& Model::getBoundsMax() const
+{
+	return vBoundsMax;
+}
+
+const glm::mat3& Model::getNormalMatrix()
+{
+	if (matModel != matNormalSource)
+	{
+		matNormal = glm::transpose(glm::inverse(glm::mat3(matModel)));
+		matNormalSource = matModel;
+	}
+
+	return matNormal;
+}
+
 Model::~Model()
 {
 	vbo.free();
 	vao.free();
 }
 
+// Private utility function - IDs of the texture sets in use, shared by all models. 0 is the empty set.
+unsigned int Model::GetTextureSetID(const std::vector<unsigned int>& textureIDs)
+{
+	if (textureIDs.empty())
+		return 0;
+
+	static std::map<std::vector<unsigned int>, unsigned int> textureSets;
+
+	auto [it, bInserted] = textureSets.try_emplace(textureIDs, (unsigned int)textureSets.size() + 1);
+	return it->second;
+}
+
 // Utility function to load models (written earlier so I'm lazy to properly integrate it in load() function :/
 // TODO: Add texture functonality
 bool Model::LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile)
@@ -151,6 +243,17 @@ bool Model::LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCou
 	cubeLayout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);	// normals
 	vertexCount = vertices.size();
 
+	// Bounding box of the positions
+	if (!temp_positions.empty())
+	{
+		vBoundsMin = vBoundsMax = temp_positions[0];
+		for (const auto& position : temp_positions)
+		{
+			vBoundsMin = glm::min(vBoundsMin, position);
+			vBoundsMax = glm::max(vBoundsMax, position);
+		}
+	}
+
 	inputFileStream.close();
 
 	//std::cout << "Finished loading!\n";
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "GLState.h"
+#include "Shader.h"
+#include "Model.h"
+
+// State changes made by the last RenderQueue::execute(), as counted by GLState
+struct RenderStats
+{
+	size_t drawCalls = 0;
+
+	// Binds made, and binds dropped because the state was already in place
+	size_t stateChanges = 0;
+	size_t bindsSkipped = 0;
+};
+
+/**
+  * Collects the draws of a frame and issues them in an order which keeps state changes low.
+  *
+  * Every submission gets a 64 bit sort key, from the most to the least significant bits:
+  *
+  *	16 bits		shader program
+  *	16 bits		texture set (see Model::getTextureSetID())
+  *	16 bits		vertex array
+  *	16 bits		depth, front to back
+  *
+  * so after sorting, draws using the same shader are next to each other, within those the ones using the same
+  * textures and so on. Opaque draws are sorted front to back within the same state to help early depth testing.
+  * GL object names and texture set IDs are small integers, only their low 16 bits go into the key. Names sharing
+  * those bits only end up less well grouped, the binds are still correct.
+  *
+  * The keys are sorted with a least significant digit radix sort (8 passes of 8 bits, passes in which all keys
+  * have the same digit are skipped). While executing, every draw binds its program, textures and vertex array
+  * through GLState, which drops the binds the sorted order made redundant. The locations of the per-draw
+  * uniforms are looked up once per program.
+  */
+class RenderQueue
+{
+private:
+	struct Command
+	{
+		Model* model;
+		Shader* shader;
+	};
+
+	// Per-draw uniforms of a program
+	struct DrawUniforms
+	{
+		Uniform matModel;
+		Uniform matNormal;
+	};
+
+	// Sort key and the index of its command
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t command;
+	};
+
+	std::vector<Command> m_Commands;
+	std::vector<SortItem> m_Items;
+	std::vector<SortItem> m_Scratch;
+
+	// Indexed by program
+	std::unordered_map<unsigned int, DrawUniforms> m_Uniforms;
+
+	RenderStats m_Stats;
+
+public:
+	// Range of depths mapped onto the 16 bit depth field, depths outside are clamped
+	float fMaxDepth = 1000.0f;
+
+	RenderQueue() = default;
+
+	// Forgets the submissions of the previous frame
+	void clear();
+
+	// Queues a draw of 'model' with 'shader'. 'fDepth' is the distance to the camera.
+	void submit(Model* model, Shader* shader, float fDepth = 0.0f);
+
+	// Sorts the queued draws and issues them. Sets each model's "matModel" and "matNormal".
+	void execute();
+
+	size_t size() const;
+
+	const RenderStats& getStats() const;
+
+	static uint64_t MakeKey(unsigned int program, unsigned int textureSet, unsigned int vertexArray, uint16_t depth);
+
+private:
+	void Sort();
+
+	const DrawUniforms& GetDrawUniforms(const Shader& shader);
+};
+
+void RenderQueue::clear()
+{
+	m_Commands.clear();
+	m_Items.clear();
+}
+
+void RenderQueue::submit(Model* model, Shader* shader, float fDepth)
+{
+	const float fNormalized = glm::clamp(fDepth / fMaxDepth, 0.0f, 1.0f);
+	const uint16_t depth = (uint16_t)(fNormalized * 65535.0f);
+
+	const uint64_t key = MakeKey(shader->id, model->getTextureSetID(), model->getVertexArray().getID(), depth);
+
+	m_Items.push_back({ key, (uint32_t)m_Commands.size() });
+	m_Commands.push_back({ model, shader });
+}
+
+void RenderQueue::execute()
+{
+	Sort();
+
+	// Binds go through GLState, which drops the ones that would not change anything. After sorting most of them
+	// don't, so the state changes of the queue are what GLState counted while executing it.
+	const GLState::Stats before = GLState::get().getFrameStats();
+	m_Stats = RenderStats();
+
+	for (const SortItem& item : m_Items)
+	{
+		const Command& command = m_Commands[item.command];
+
+		command.shader->use();
+		command.model->bindTextures();
+		command.model->getVertexArray().bind();
+
+		const DrawUniforms& uniforms = GetDrawUniforms(*command.shader);
+		command.shader->setMat4(uniforms.matModel, command.model->matModel);
+		command.shader->setMat3(uniforms.matNormal, command.model->getNormalMatrix());
+		command.model->drawArrays();
+
+		m_Stats.drawCalls++;
+	}
+
+	const GLState::Stats& after = GLState::get().getFrameStats();
+	m_Stats.stateChanges = after.callsIssued - before.callsIssued;
+	m_Stats.bindsSkipped = after.callsAvoided - before.callsAvoided;
+}
+
+size_t RenderQueue::size() const
+{
+	return m_Commands.size();
+}
+
+const RenderStats& RenderQueue::getStats() const
+{
+	return m_Stats;
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int program, unsigned int textureSet, unsigned int vertexArray, uint16_t depth)
+{
+	return ((uint64_t)(program & 0xFFFF) << 48) | ((uint64_t)(textureSet & 0xFFFF) << 32) | ((uint64_t)(vertexArray & 0xFFFF) << 16) | depth;
+}
+
+// Private utility function - LSD radix sort of the items by key, stable so that equal keys keep their submission order
+void RenderQueue::Sort()
+{
+	if (m_Items.size() < 2)
+		return;
+
+	m_Scratch.resize(m_Items.size());
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = {};
+
+		for (const SortItem& item : m_Items)
+			counts[(item.key >> shift) & 0xFF]++;
+
+		// Every key has the same digit, the pass wouldn't change the order
+		if (counts[(m_Items[0].key >> shift) & 0xFF] == m_Items.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			const size_t digitCount = count;
+			count = offset;
+			offset += digitCount;
+		}
+
+		for (const SortItem& item : m_Items)
+			m_Scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+
+		m_Items.swap(m_Scratch);
+	}
+}
+
+// Private utility function - looks up the uniform locations the first time a program is drawn with
+const RenderQueue::DrawUniforms& RenderQueue::GetDrawUniforms(const Shader& shader)
+{
+	auto [it, bInserted] = m_Uniforms.try_emplace(shader.id);
+	if (bInserted)
+	{
+		it->second.matModel = shader.getUniform("matModel");
+		it->second.matNormal = shader.getUniform("matNormal");
+	}
+
+	return it->second;
+}
@@ -2,16 +2,27 @@
 
 #include "Shader.h"
 #include "Model.h"
+#include "Frustum.h"
+#include "RenderQueue.h"
 
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 class Renderer
 {
 private:
 	// Stores references to each model and its corresponding shader
 
-	std::unordered_map<Model*, Shader*> models;
-	Shader* currentShader = nullptr;
+	std::vector<std::pair<Model*, Shader*>> models;
+
+	// Rebuilt every frame for culling, as the model matrices can change between frames
+	BoundingBoxes bounds;
+	std::vector<uint32_t> visible;
+
+	// Sorts the draws of a frame by shader, texture and vertex array, see RenderQueue.h
+	RenderQueue queue;
+
+	CullingStats stats;
 
 	// This is a singleton class
 	Renderer() {}
@@ -25,6 +36,15 @@ public:
 	void addModel(Model* model, Shader* shader);
 
 	void render();
+
+	// Renders only the models whose bounding box intersects the frustum, front to back from 'vViewPos'
+	void render(const Frustum& frustum, const glm::vec3& vViewPos);
+
+	// Number of models drawn and culled by the last call to render(frustum)
+	const CullingStats& getStats() const;
+
+	// Draw calls and state changes of the last call to render()
+	const RenderStats& getRenderStats() const;
 };
 
 inline Renderer& Renderer::getInstance()
@@ -35,20 +55,62 @@ inline Renderer& Renderer::getInstance()
 
 void Renderer::addModel(Model* model, Shader* shader)
 {
-	models.insert(std::make_pair(model, shader));
+	for (const auto& [addedModel, addedShader] : models)
+	{
+		if (addedModel == model)
+			return;
+	}
+
+	models.emplace_back(model, shader);
 }
 
 void Renderer::render()
 {
+	queue.clear();
+
+	for (const auto& [model, shader] : models)
+		queue.submit(model, shader);
+
+	queue.execute();
+}
+
+void Renderer::render(const Frustum& frustum, const glm::vec3& vViewPos)
+{
+	bounds.clear();
+
 	for (const auto& [model, shader] : models)
 	{
-		if (!currentShader || (currentShader->id != shader->id))
-		{
-			shader->use();
-			currentShader = shader;
-		}
-
-		currentShader->setMat4("matModel", model->matModel);
-		model->draw();
+		glm::vec3 vMin, vMax;
+		BoundingBoxes::transform(model->matModel, model->getBoundsMin(), model->getBoundsMax(), vMin, vMax);
+
+		bounds.add(vMin, vMax);
+	}
+
+	bounds.cull(frustum, visible);
+
+	stats.drawn = visible.size();
+	stats.culled = models.size() - visible.size();
+
+	queue.clear();
+
+	for (uint32_t index : visible)
+	{
+		auto& [model, shader] = models[index];
+
+		// Distance to the center of the bounding box, for sorting front to back
+		const glm::vec3 vCenter = glm::vec3(model->matModel * glm::vec4((model->getBoundsMin() + model->getBoundsMax()) * 0.5f, 1.0f));
+		queue.submit(model, shader, glm::length(vCenter - vViewPos));
 	}
+
+	queue.execute();
+}
+
+const CullingStats& Renderer::getStats() const
+{
+	return stats;
+}
+
+const RenderStats& Renderer::getRenderStats() const
+{
+	return queue.getStats();
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLState.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -13,6 +15,13 @@
 #include <fstream>
 #include <sstream>
 
+// Handle to a uniform of a shader program. Fetch it once with Shader::getUniform() and pass it to the
+// set functions to avoid looking up the uniform location by name every time.
+struct Uniform
+{
+	int location = -1;
+};
+
 class Shader
 {
 public:
@@ -27,13 +36,23 @@ public:
 
 	void use();
 
+	// Connects the uniform block 'blockName' to a binding point. Does nothing if the program has no such block.
+	void bindUniformBlock(const std::string& blockName, unsigned int binding);
+
 	void setBool(const std::string& name, bool value);
 	void setInt(const std::string& name, int value);
 	void setFloat(const std::string& name, float value);
+	void setMat3(const std::string& name, const glm::mat3& mat);
 	void setMat4(const std::string& name, const glm::mat4& mat);
 	void setVec3(const std::string& name, const float& f1, const float& f2, const float& f3);
 	void setVec3(const std::string& name, const glm::vec3& vec);
 
+	// Returns a handle to the uniform 'name'. If no such uniform is active, setting it does nothing.
+	Uniform getUniform(const std::string& name) const;
+
+	void setMat3(Uniform uniform, const glm::mat3& mat);
+	void setMat4(Uniform uniform, const glm::mat4& mat);
+
 private:
 	unsigned int CompileShader(unsigned int type, const std::string& source, const std::string& shaderPath);
 };
@@ -112,7 +131,14 @@ void Shader::load(const std::string& shaderPath)
 
 void Shader::use()
 {
-	glUseProgram(id);
+	GLState::get().useProgram(id);
+}
+
+void Shader::bindUniformBlock(const std::string& blockName, unsigned int binding)
+{
+	unsigned int index = glGetUniformBlockIndex(id, blockName.c_str());
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(id, index, binding);
 }
 
 void Shader::setBool(const std::string& name, bool value)
@@ -130,6 +156,11 @@ void Shader::setFloat(const std::string& name, float value)
 	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
 }
 
+void Shader::setMat3(const std::string& name, const glm::mat3& mat)
+{
+	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 {
 	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
@@ -145,6 +176,21 @@ void Shader::setVec3(const std::string& name, const glm::vec3& vec)
 	glUniform3f(glGetUniformLocation(id, name.c_str()), vec.x, vec.y, vec.z);
 }
 
+Uniform Shader::getUniform(const std::string& name) const
+{
+	return Uniform{ glGetUniformLocation(id, name.c_str()) };
+}
+
+void Shader::setMat3(Uniform uniform, const glm::mat3& mat)
+{
+	glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat4(Uniform uniform, const glm::mat4& mat)
+{
+	glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 // Private utility function - to compile vertex and fragment shader
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source, const std::string& shaderPath)
 {
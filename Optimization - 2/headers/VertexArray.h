@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 class VertexArray
 {
 private:
@@ -17,25 +19,32 @@ public:
 	void unbind() const;
 
 	void free() const;
+
+	unsigned int getID() const;
 };
 
 void VertexArray::generate()
 {
 	glGenVertexArrays(1, &m_VertexArrayID);
-	glBindVertexArray(m_VertexArrayID);
+	GLState::get().bindVertexArray(m_VertexArrayID);
 }
 
 void VertexArray::bind() const
 {
-	glBindVertexArray(m_VertexArrayID);
+	GLState::get().bindVertexArray(m_VertexArrayID);
 }
 
 void VertexArray::unbind() const
 {
-	glBindVertexArray(0);
+	GLState::get().bindVertexArray(0);
 }
 
 void VertexArray::free() const
 {
-	glDeleteVertexArrays(1, &m_VertexArrayID);
+	GLState::get().deleteVertexArrays(1, &m_VertexArrayID);
+}
+
+unsigned int VertexArray::getID() const
+{
+	return m_VertexArrayID;
 }
\ No newline at end of file
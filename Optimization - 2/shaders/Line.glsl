@@ -3,8 +3,14 @@
 layout (location = 0) in vec3 vPos;
 
 uniform mat4 matModel;
-uniform mat4 matView;
-uniform mat4 matProjection;
+
+// Shared by all shaders, see SceneUniforms.h
+layout (std140) uniform Camera
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec3 u_vViewPos;
+};
 
 void main()
 {
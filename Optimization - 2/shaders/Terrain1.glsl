@@ -4,8 +4,15 @@ layout (location = 0) in vec3 vPos;
 layout (location = 1) in vec3 vNorm;
 
 uniform mat4 matModel;
-uniform mat4 matView;
-uniform mat4 matProjection;
+uniform mat3 matNormal;		// Transpose of the inverse of matModel, computed on the CPU
+
+// Shared by all shaders, see SceneUniforms.h
+layout (std140) uniform Camera
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec3 u_vViewPos;
+};
 
 out vec3 vNormal;
 out vec3 vFragPos;
@@ -15,7 +22,7 @@ void main()
 	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
 
 	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
-	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
+	vNormal = matNormal * vNorm;
 }
 #endif
 
@@ -28,6 +35,7 @@ struct Material
 	float fShininess;
 };
 
+// The members are ordered for the std140 layout of the Lights block, see SceneUniforms.h
 struct DirLight
 {
 	vec3 vDirection;
@@ -35,46 +43,67 @@ struct DirLight
 
 	vec3 vAmbient;
 	vec3 vDiffuse;
+	vec3 vSpecular;
 };
 
+// Read from u_pointLights, the light color is already multiplied into the ambient, diffuse and specular colors
 struct PointLight
 {
 	vec3 vPosition;
-	vec3 vLightColor;
-	
-	float fConstant;
-	float fLinear;
-	float fQuadratic;
+	float fRadius;
 
 	vec3 vAmbient;
 	vec3 vDiffuse;
+	vec3 vSpecular;
+
+	float fConstant;
+	float fLinear;
+	float fQuadratic;
 };
 
 struct SpotLight
 {
 	vec3 vPosition;
+	float fConstant;
 	vec3 vDirection;
+	float fLinear;
 	vec3 vLightColor;
+	float fQuadratic;
 
 	vec3 vAmbient;
-	vec3 vDiffuse;
-
 	float fCutOff;
+	vec3 vDiffuse;
 	float fOuterCutOff;
-
-	float fConstant;
-	float fLinear;
-	float fQuadratic;
+	vec3 vSpecular;
 };
 
 // Uniforms are indicated by the 'u_' prefix
 
-#define	NR_POINT_LIGHTS 1
-uniform DirLight u_dirLight;
-uniform PointLight u_pointLights[NR_POINT_LIGHTS];
-uniform SpotLight u_spotLight;
+layout (std140) uniform Lights
+{
+	DirLight u_dirLight;
+	SpotLight u_spotLight;
+
+	// Light grid, see ClusteredLights.h
+	uvec4 u_vClusterSize;		// Tiles across, tiles up, depth slices, number of lights
+	vec4 u_vClusterScale;		// Tile width and height in pixels, depth slice scale and bias
+};
+
+// Per cluster: offset into u_clusterLightIndices and number of lights
+uniform usamplerBuffer u_clusterCells;
+uniform usamplerBuffer u_clusterLightIndices;
+
+// 4 texels per light
+uniform samplerBuffer u_pointLights;
+
+// Shared by all shaders, see SceneUniforms.h
+layout (std140) uniform Camera
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec3 u_vViewPos;
+};
 
-uniform vec3 u_vViewPos;
 uniform Material u_material;
 
 in vec3 vNormal;
@@ -84,6 +113,8 @@ out vec4 FragColor;
 
 vec3 CalcDirLight(DirLight light, vec3 vNormal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir);
+PointLight FetchPointLight(int index);
+uint GetCluster();
 vec3 CalcSpotLight(SpotLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir);
 
 void main()
@@ -96,10 +127,12 @@ void main()
 	// Directional lighting
 	//vResult += CalcDirLight(u_dirLight, vNorm, vViewDir);
 
-	// Point lights
-	for(int i=0; i<NR_POINT_LIGHTS; i++)
+	// Point lights, only the ones whose range reaches this fragment's cluster
+	uvec2 vCell = texelFetch(u_clusterCells, int(GetCluster())).xy;
+	for(uint i=0u; i<vCell.y; i++)
 	{
-		vResult += CalcPointLight(u_pointLights[i], vNorm, vFragPos, vViewDir);
+		int index = int(texelFetch(u_clusterLightIndices, int(vCell.x + i)).x);
+		vResult += CalcPointLight(FetchPointLight(index), vNorm, vFragPos, vViewDir);
 	}
 
 	vResult += CalcSpotLight(u_spotLight, vNorm, vFragPos, vViewDir);
@@ -136,23 +169,59 @@ vec3 CalcSpotLight(SpotLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir)
 
 vec3 CalcPointLight(PointLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir)
 {
-	vec3 vLightDir = normalize(light.vPosition - vFragPos);
+	float fDistance = length(light.vPosition - vFragPos);
+	if (fDistance >= light.fRadius)
+		return vec3(0.0f);
+
+	vec3 vLightDir = (light.vPosition - vFragPos) / fDistance;
 
 	// Ambient shading
-	vec3 vAmbient = light.vAmbient * light.vLightColor * u_material.vColor;
+	vec3 vAmbient = light.vAmbient * u_material.vColor;
 
 	// Diffuse shading
 	float fDiff = max(dot(vNormal, vLightDir), 0.0f);
-	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * u_material.vColor;
+	vec3 vDiffuse = light.vDiffuse * fDiff * u_material.vColor;
 
-	// Attenuation
-	float fDistance = length(light.vPosition - vFragPos);
+	// Attenuation, faded to zero at the radius so that there is no seam where the light's clusters end.
+	// With many lights the ambient shading has to fade out too.
 	float fAttenuation = 1.0f / (light.fConstant + light.fLinear * fDistance + light.fQuadratic * (fDistance * fDistance));
+	float fFade = 1.0f - pow(fDistance / light.fRadius, 4.0f);
+	fAttenuation *= fFade * fFade;
 
-	// We'll leave out attenuating the ambient shading
-	vDiffuse = vDiffuse * fAttenuation;
+	return (vAmbient + vDiffuse) * fAttenuation;
+}
 
-	return (vAmbient + vDiffuse);
+PointLight FetchPointLight(int index)
+{
+	vec4 vTexel0 = texelFetch(u_pointLights, index * 4);
+	vec4 vTexel1 = texelFetch(u_pointLights, index * 4 + 1);
+	vec4 vTexel2 = texelFetch(u_pointLights, index * 4 + 2);
+	vec4 vTexel3 = texelFetch(u_pointLights, index * 4 + 3);
+
+	PointLight light;
+	light.vPosition = vTexel0.xyz;
+	light.fRadius = vTexel0.w;
+	light.vAmbient = vTexel1.xyz;
+	light.fConstant = vTexel1.w;
+	light.vDiffuse = vTexel2.xyz;
+	light.fLinear = vTexel2.w;
+	light.vSpecular = vTexel3.xyz;
+	light.fQuadratic = vTexel3.w;
+
+	return light;
+}
+
+// Index of the cluster the fragment is in, from its screen position and view depth
+uint GetCluster()
+{
+	float fViewDepth = -(matView * vec4(vFragPos, 1.0f)).z;
+
+	uvec3 vCluster;
+	vCluster.xy = uvec2(gl_FragCoord.xy / u_vClusterScale.xy);
+	vCluster.z = uint(max(log(fViewDepth) * u_vClusterScale.z + u_vClusterScale.w, 0.0f));
+	vCluster = min(vCluster, u_vClusterSize.xyz - 1u);
+
+	return vCluster.x + u_vClusterSize.x * (vCluster.y + u_vClusterSize.y * vCluster.z);
 }
 
 vec3 CalcDirLight(DirLight light, vec3 vNormal, vec3 vViewDir)
@@ -0,0 +1,311 @@
+/**
+  * Compares the vertex throughput of the lighting vertex shader with the normal matrix computed per vertex
+  * (mat3(transpose(inverse(matModel))), as the shaders used to do it) and passed in as the 'matNormal' uniform
+  * (computed once per draw on the CPU, as Renderer does it now).
+  *
+  * Every frame draws a dense sphere a number of times, each with its own model matrix, into a small framebuffer.
+  * Each variant is timed twice: once with every triangle culled after the vertex stage (so only vertex work is
+  * measured) and once rendering normally. The gap is largest on a software rasterizer, where the vertex shader
+  * runs on the CPU. With Mesa, llvmpipe can be forced with LIBGL_ALWAYS_SOFTWARE=1.
+  *
+  * Build from the project directory, for example:
+  *		g++ -std=c++20 -O2 -Iheaders -I../externals tools/NormalMatrixBenchmark.cpp "../AssimpLoader - 1/src/glad.c" -o NormalMatrixBenchmark -lglfw -ldl
+  *
+  * Usage: NormalMatrixBenchmark [frames] [segments]	(defaults to 60 frames of a sphere with 512 segments)
+  */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Framebuffer size, small so that rasterization costs little next to the vertex shader
+constexpr int TARGET_SIZE = 128;
+
+// Draws per frame, each with a different model matrix
+constexpr int DRAWS_PER_FRAME = 8;
+
+static const char* VERTEX_SHADER_INVERSE = R"(#version 330 core
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+
+uniform mat4 matModel;
+uniform mat4 matViewProjection;
+
+out vec3 vNormal;
+
+void main()
+{
+	gl_Position = matViewProjection * matModel * vec4(vPos, 1.0f);
+	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
+}
+)";
+
+static const char* VERTEX_SHADER_UNIFORM = R"(#version 330 core
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+
+uniform mat4 matModel;
+uniform mat3 matNormal;
+uniform mat4 matViewProjection;
+
+out vec3 vNormal;
+
+void main()
+{
+	gl_Position = matViewProjection * matModel * vec4(vPos, 1.0f);
+	vNormal = matNormal * vNorm;
+}
+)";
+
+static const char* FRAGMENT_SHADER = R"(#version 330 core
+in vec3 vNormal;
+
+out vec4 FragColor;
+
+void main()
+{
+	float fDiffuse = max(dot(normalize(vNormal), normalize(vec3(0.3f, 1.0f, 0.5f))), 0.0f);
+	FragColor = vec4(vec3(0.1f + fDiffuse), 1.0f);
+}
+)";
+
+static unsigned int CompileProgram(const char* vertexSource, const char* fragmentSource)
+{
+	unsigned int shaders[2] = { glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER) };
+	const char* sources[2] = { vertexSource, fragmentSource };
+
+	unsigned int program = glCreateProgram();
+
+	for (int i = 0; i < 2; i++)
+	{
+		glShaderSource(shaders[i], 1, &sources[i], nullptr);
+		glCompileShader(shaders[i]);
+
+		int result;
+		glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &result);
+		if (!result)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shaders[i], sizeof(infoLog), nullptr, infoLog);
+			std::cout << "Failed to compile shader:\n" << infoLog << std::endl;
+		}
+
+		glAttachShader(program, shaders[i]);
+	}
+
+	glLinkProgram(program);
+
+	for (unsigned int shader : shaders)
+		glDeleteShader(shader);
+
+	return program;
+}
+
+// Unindexed triangles of a UV sphere, position and normal interleaved
+static std::vector<float> BuildSphere(int segments)
+{
+	const int rings = segments / 2;
+	const float PI = 3.14159265f;
+
+	auto point = [&](int ring, int segment)
+	{
+		const float fTheta = PI * ring / rings;
+		const float fPhi = 2.0f * PI * segment / segments;
+		return glm::vec3(std::sin(fTheta) * std::cos(fPhi), std::cos(fTheta), std::sin(fTheta) * std::sin(fPhi));
+	};
+
+	std::vector<float> vertices;
+	vertices.reserve((size_t)rings * segments * 6 * 6);
+
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			const glm::vec3 quad[6] = {
+				point(ring, segment), point(ring + 1, segment), point(ring + 1, segment + 1),
+				point(ring, segment), point(ring + 1, segment + 1), point(ring, segment + 1)
+			};
+
+			// On a unit sphere the normal is the position
+			for (const glm::vec3& p : quad)
+				vertices.insert(vertices.end(), { p.x, p.y, p.z, p.x, p.y, p.z });
+		}
+	}
+
+	return vertices;
+}
+
+// Median milliseconds per frame
+static double RunVariant(unsigned int program, bool bNormalUniform, int frames, int vertexCount)
+{
+	glUseProgram(program);
+
+	const int uModel = glGetUniformLocation(program, "matModel");
+	const int uNormal = glGetUniformLocation(program, "matNormal");
+
+	const glm::mat4 matViewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::vec3(0.0f, 0.0f, 12.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	glUniformMatrix4fv(glGetUniformLocation(program, "matViewProjection"), 1, GL_FALSE, glm::value_ptr(matViewProjection));
+
+	std::vector<double> frameTimes;
+
+	// One extra frame to warm up the driver
+	for (int frame = -1; frame < frames; frame++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		for (int draw = 0; draw < DRAWS_PER_FRAME; draw++)
+		{
+			// Non-uniform scale, so that the normal matrix differs from the model matrix
+			glm::mat4 matModel = glm::mat4(1.0f);
+			matModel = glm::translate(matModel, glm::vec3((draw % 4) * 3.0f - 4.5f, (draw / 4) * 3.0f - 1.5f, 0.0f));
+			matModel = glm::rotate(matModel, 0.01f * (frame + 1) + draw, glm::vec3(0.0f, 1.0f, 0.0f));
+			matModel = glm::scale(matModel, glm::vec3(1.0f, 1.5f, 1.0f));
+
+			glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(matModel));
+
+			if (bNormalUniform)
+			{
+				const glm::mat3 matNormal = glm::transpose(glm::inverse(glm::mat3(matModel)));
+				glUniformMatrix3fv(uNormal, 1, GL_FALSE, glm::value_ptr(matNormal));
+			}
+
+			glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+		}
+
+		glFinish();
+
+		if (frame >= 0)
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	return frameTimes[frameTimes.size() / 2];
+}
+
+int main(int argc, char* argv[])
+{
+	const int frames = std::max(argc > 1 ? std::atoi(argv[1]) : 60, 1);
+	const int segments = std::max(argc > 2 ? std::atoi(argv[2]) : 512, 4);
+
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW" << std::endl;
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(TARGET_SIZE, TARGET_SIZE, "NormalMatrixBenchmark", nullptr, nullptr);
+	if (!window)
+	{
+		std::cout << "Failed to create the window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << '\n';
+
+	// Render into a framebuffer of our own, a hidden window's default framebuffer may not be backed by anything
+	unsigned int framebuffer, colorBuffer, depthBuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_SIZE, TARGET_SIZE);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, TARGET_SIZE, TARGET_SIZE);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	glViewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+	glEnable(GL_DEPTH_TEST);
+
+	const std::vector<float> vertices = BuildSphere(segments);
+	const int vertexCount = (int)(vertices.size() / 6);
+
+	unsigned int vao, vbo;
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (const void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (const void*)(3 * sizeof(float)));
+
+	const unsigned int inverseProgram = CompileProgram(VERTEX_SHADER_INVERSE, FRAGMENT_SHADER);
+	const unsigned int uniformProgram = CompileProgram(VERTEX_SHADER_UNIFORM, FRAGMENT_SHADER);
+
+	const double fVerticesPerFrame = (double)vertexCount * DRAWS_PER_FRAME;
+
+	std::cout << "Vertices per frame: " << (size_t)fVerticesPerFrame << ", median of " << frames << " frames\n";
+	std::cout << std::fixed << std::setprecision(2);
+
+	for (bool bVertexOnly : { true, false })
+	{
+		// Culling both faces throws every triangle away right after the vertex stage
+		if (bVertexOnly)
+		{
+			glEnable(GL_CULL_FACE);
+			glCullFace(GL_FRONT_AND_BACK);
+		}
+		else
+		{
+			glDisable(GL_CULL_FACE);
+		}
+
+		const double fInverseTime = RunVariant(inverseProgram, false, frames, vertexCount);
+		const double fUniformTime = RunVariant(uniformProgram, true, frames, vertexCount);
+
+		std::cout << '\n' << (bVertexOnly ? "Vertex stage only" : "Full frame") << '\n';
+		std::cout << "Normal matrix    ms/frame    Mvertices/s\n";
+		std::cout << "per vertex   " << std::setw(12) << fInverseTime << std::setw(15) << fVerticesPerFrame / fInverseTime / 1000.0 << '\n';
+		std::cout << "uniform      " << std::setw(12) << fUniformTime << std::setw(15) << fVerticesPerFrame / fUniformTime / 1000.0 << '\n';
+		std::cout << "Speedup: " << fInverseTime / fUniformTime << "x" << std::endl;
+	}
+
+	glDeleteProgram(inverseProgram);
+	glDeleteProgram(uniformProgram);
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+
+	glfwTerminate();
+	return 0;
+}
@@ -5,8 +5,11 @@
 #include "OpenGL_Graphics.h"
 #include "VertexData.h"
 #include "Model.h"
+#include "JobSystem.h"
+#include "SceneUniforms.h"
 
-#include "Block.h"
+#include "BlockTextureArray.h"
+#include "World.h"
 
 #include <iostream>
 #include <iomanip>
@@ -32,8 +35,14 @@ private:
 	Shader blockShader;
 	Shader lampShader;
 
-	// Blocks
-	std::vector<Block*> blocks;
+	// Terrain, made up of 16x16x256 chunks which are drawn with one mesh each
+	World world;
+	BlockTextureArray blockTextures;
+
+	// Worker threads which generate and mesh the chunks and load the models
+	JobSystem jobs;
+	std::chrono::system_clock::time_point tGenerationStart;
+	bool bWorldReady = false;
 
 	// Projection matrix
 	glm::mat4 matProjection;
@@ -42,14 +51,25 @@ private:
 	// Camera
 	Camera camera;
 
+	// Handles of uniforms which are set every frame
+	Uniform uAxesModel, uAxesColor;
+	Uniform uBlockChunkOffset;
+	Uniform uLampModel;
+
+	// Camera and lights, shared by all shaders through uniform blocks
+	SceneUniforms sceneUniforms;
+
 	// Light positions and colors
-	glm::vec3 vLampPos = glm::vec3(1.2f, 1.0f, 2.0f);
+	glm::vec3 vLampPos = glm::vec3(128.0f, 90.0f, 128.0f);
+
+	// Where the camera starts, above the middle of the world
+	const glm::vec3 vCameraStart = glm::vec3(128.0f, 90.0f, 160.0f);
 	glm::vec3 vLampColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
 public:
 	bool Setup() override
 	{
-		camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		camera.init(vCameraStart, glm::vec3(0.0f, 0.0f, -1.0f));
 
 		// Axes
 		axesVAO.generate();
@@ -58,17 +78,32 @@ public:
 		axesLayout.setBufferLayout(axesVAO, axesVBO, 3, BufferType::FLOAT);
 		axesShader.load("shaders/Line.glsl");
 
+		jobs.init();
+
 		// ---------------------------- Load Models ------------------------------
-		lampModel.load("models/Cube.obj");
+		lampModel.loadAsync("models/Cube.obj", jobs);
 
 		// ---------------------------- Load Shaders -----------------------------
-		blockShader.load("shaders/Block.glsl");
+		blockShader.load("shaders/Chunk.glsl");
 		lampShader.load("shaders/Lamp.glsl");
 
+		// Connect the shaders to the shared camera and light blocks
+		sceneUniforms.generate();
+		sceneUniforms.attach(axesShader);
+		sceneUniforms.attach(blockShader);
+		sceneUniforms.attach(lampShader);
+
+		// ---------------------------- Uniform handles ------------------------
+		uAxesModel = axesShader.getUniform("matModel");
+		uAxesColor = axesShader.getUniform("vColor");
+
+		uBlockChunkOffset = blockShader.getUniform("u_vChunkOffset");
+
+		uLampModel = lampShader.getUniform("matModel");
+
 		// ---------------------------- Set Shaders ----------------------------
 		blockShader.use();
-		blockShader.setInt("u_material.diffuse", 0);
-		blockShader.setInt("u_material.specular", 1);
+		blockShader.setInt("u_material.blocks", 0);
 
 		// Initalize block shader
 		InitalizeBlockShader();
@@ -78,25 +113,16 @@ public:
 		lampShader.setVec3("vLampColor", vLampColor);
 
 		// ---------------------------- Others ---------------------------------
-		auto dt1 = std::chrono::system_clock::now();
-
-		std::cout << "Generating blocks..." << std::endl;
-		Block* block = new GrassBlock({ 0.0f, 0.0f, 0.0f }, 0.0f, pi);
-		blocks.push_back(block);
-		for (int x = 0; x < 200; x++)
-		{
-			for (int z = 0; z < 200; z++)
-			{
-				Block* block = new GrassBlock(glm::vec3((float)x, -10.0f, (float)z), glm::radians(Random::get(0, 3) * 90.0f), pi);
-				blocks.push_back(block);
-			}
-		}
+		// The world can't be drawn without its textures
+		if (!blockTextures.load())
+			return false;
 
-		auto dt2 = std::chrono::system_clock::now();
-		std::chrono::duration<float> elapsedTime = dt2 - dt1;
-		float dt = elapsedTime.count();
-
-		std::cout << "Finished generating! Time taken: " << dt << " seconds" << std::endl;
+		// 16x16 chunks, 256x256 blocks. Chunks appear as the workers finish them, see Update().
+		std::cout << "Generating world on " << jobs.getThreadCount() << " worker threads..." << std::endl;
+		tGenerationStart = std::chrono::system_clock::now();
+		// Headless runs always render the same world
+		const uint32_t seed = IsHeadless() ? 1337u : (uint32_t)Random::get(0, 1 << 30);
+		world.generateAsync(16, 16, seed, jobs);
 
 		SetProjectionMatrix();
 
@@ -112,13 +138,37 @@ public:
 
 		UpdateShader();
 
-		// Draw models
-		blockShader.use();
-		for (const auto& block : blocks)
+		// Pick up finished jobs (uploads meshes), then hand the chunks which need a new mesh to the workers.
+		// Neither waits for a job.
 		{
-			block->draw(blockShader);
+			ScopedCpuTimer timer(GetProfiler(), "Jobs");
+			jobs.processCompleted();
+			world.update(jobs);
 		}
 
+		if (!bWorldReady && world.isReady())
+		{
+			std::chrono::duration<float> elapsedTime = std::chrono::system_clock::now() - tGenerationStart;
+			std::cout << "Finished generating! Time taken: " << elapsedTime.count() << " seconds" << std::endl;
+			std::cout << "Chunks: " << world.getChunkCount() << ", triangles: " << world.getTriangleCount() << std::endl;
+
+			bWorldReady = true;
+		}
+
+		// Draw the chunks inside the camera's view, one draw call each
+		{
+			ScopedCpuTimer cpuTimer(GetProfiler(), "Chunks");
+			ScopedGpuTimer gpuTimer(GetProfiler(), "Chunks");
+
+			blockShader.use();
+			GLState::get().activeTexture(0);
+			blockTextures.bind();
+			world.render(blockShader, uBlockChunkOffset, camera.getFrustum(matProjection));
+		}
+
+		const CullingStats& stats = world.getStats();
+		SetTitleInfo(" | Chunks drawn: " + std::to_string(stats.drawn) + ", culled: " + std::to_string(stats.culled));
+
 		// Displays coordinate axes (for debugging)
 		RenderAxis();
 
@@ -127,16 +177,17 @@ public:
 
 	void UpdateShader()
 	{
-		blockShader.use();
-		blockShader.setVec3("u_spotLight.vPosition", camera.vCameraPos);
-		blockShader.setVec3("u_spotLight.vDirection", camera.vCameraFront);
-		blockShader.setVec3("u_vViewPos", camera.vCameraPos);
+		// The spot light is attached to the camera. Camera and lights go to the GPU in one buffer update.
+		sceneUniforms.lights.spotLight.vPosition = camera.vCameraPos;
+		sceneUniforms.lights.spotLight.vDirection = camera.vCameraFront;
+		sceneUniforms.camera.vViewPos = camera.vCameraPos;
+		sceneUniforms.upload();
 
 		lampShader.use();
 		glm::mat4 matLampModel = glm::mat4(1.0f);
 		matLampModel = glm::translate(matLampModel, vLampPos);
 		matLampModel = glm::scale(matLampModel, glm::vec3(0.2f));
-		lampShader.setMat4("matModel", matLampModel);
+		lampShader.setMat4(uLampModel, matLampModel);
 		lampModel.draw();
 	}
 
@@ -157,17 +208,17 @@ public:
 
 		glm::mat4 matModel = glm::mat4(1.0f);
 		matModel = glm::scale(matModel, glm::vec3(5.0f, 5.0f, 5.0f));
-		axesShader.setMat4("matModel", matModel);
+		axesShader.setMat4(uAxesModel, matModel);
 
 		// Increase line width
 		glLineWidth(2.0f);
 
 		// Draw lines
-		axesShader.setVec3("vColor", 1.0f, 0.0f, 0.0f);
+		axesShader.setVec3(uAxesColor, 1.0f, 0.0f, 0.0f);
 		glDrawArrays(GL_LINES, 0, 2);
-		axesShader.setVec3("vColor", 0.0f, 1.0f, 0.0f);
+		axesShader.setVec3(uAxesColor, 0.0f, 1.0f, 0.0f);
 		glDrawArrays(GL_LINES, 2, 2);
-		axesShader.setVec3("vColor", 0.0f, 0.0f, 1.0f);
+		axesShader.setVec3(uAxesColor, 0.0f, 0.0f, 1.0f);
 		glDrawArrays(GL_LINES, 4, 2);
 
 		// Set line width back to normal
@@ -177,131 +228,140 @@ public:
 	void InitalizeBlockShader()
 	{
 		blockShader.use();
+		blockShader.setFloat("u_material.fShininess", 64.0f);
+
+		LightUniforms& lights = sceneUniforms.lights;
 
 		// ---------------------------------------- Directional light ---------------------------------------- 
-		blockShader.setVec3("u_dirLight.vDirection", glm::vec3(0.0f, -1.0f, 0.0f));
-		blockShader.setVec3("u_dirLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		lights.dirLight.vDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+		lights.dirLight.vLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		blockShader.setVec3("u_dirLight.vAmbient", glm::vec3(0.1f, 0.1f, 0.1f));
-		blockShader.setVec3("u_dirLight.vDiffuse", glm::vec3(0.2f, 0.2f, 0.2f));
-		blockShader.setVec3("u_dirLight.vSpecular", glm::vec3(0.2f, 0.2f, 0.2f));
+		lights.dirLight.vAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+		lights.dirLight.vDiffuse = glm::vec3(0.2f, 0.2f, 0.2f);
+		lights.dirLight.vSpecular = glm::vec3(0.2f, 0.2f, 0.2f);
 
 		// ---------------------------------------- Point light ---------------------------------------- 
-		blockShader.setVec3("u_pointLights[0].vPosition", vLampPos);
-		blockShader.setVec3("u_pointLights[0].vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		lights.pointLights[0].vPosition = vLampPos;
+		lights.pointLights[0].vLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		blockShader.setVec3("u_pointLights[0].vAmbient", glm::vec3(0.3f, 0.3f, 0.3f));
-		blockShader.setVec3("u_pointLights[0].vDiffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-		blockShader.setVec3("u_pointLights[0].vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
-		blockShader.setFloat("u_pointLights[0].fConstant", 1.0f);
-		blockShader.setFloat("u_pointLights[0].fLinear", 0.14f);
-		blockShader.setFloat("u_pointLights[0].fQuadratic", 0.07f);
-
-		blockShader.setFloat("u_material.fShininess", 64.0f);
+		lights.pointLights[0].vAmbient = glm::vec3(0.3f, 0.3f, 0.3f);
+		lights.pointLights[0].vDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		lights.pointLights[0].vSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+		lights.pointLights[0].fConstant = 1.0f;
+		lights.pointLights[0].fLinear = 0.14f;
+		lights.pointLights[0].fQuadratic = 0.07f;
 
 		// ---------------------------------------- Spot light ---------------------------------------- 
-		blockShader.setVec3("u_spotLight.vLightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+		// Position and direction follow the camera, see UpdateShader()
+		lights.spotLight.vLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		blockShader.setVec3("u_spotLight.vAmbient", glm::vec3(0.6f, 0.6f, 0.6f));
-		blockShader.setVec3("u_spotLight.vDiffuse", glm::vec3(0.5f, 0.5f, 0.5f));
-		blockShader.setVec3("u_spotLight.vSpecular", glm::vec3(1.0f, 1.0f, 1.0f));
+		lights.spotLight.vAmbient = glm::vec3(0.6f, 0.6f, 0.6f);
+		lights.spotLight.vDiffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+		lights.spotLight.vSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		blockShader.setFloat("u_spotLight.fConstant", 1.0f);
-		blockShader.setFloat("u_spotLight.fLinear", 0.22f);
-		blockShader.setFloat("u_spotLight.fQuadratic", 0.20f);
+		lights.spotLight.fConstant = 1.0f;
+		lights.spotLight.fLinear = 0.22f;
+		lights.spotLight.fQuadratic = 0.20f;
 
 		// Cutoff and outer cutoff angles are 30 and 45 degrees respectively
-		blockShader.setFloat("u_dirLight.fCutOff", 30.0f * pi / 180.0f);
-		blockShader.setFloat("u_dirLight.fOuterCutOff", 45.0f * pi / 180.0f);
+		lights.spotLight.fCutOff = cosf(30.0f * pi / 180.0f);
+		lights.spotLight.fOuterCutOff = cosf(45.0f * pi / 180.0f);
 	}
 
 	void HandleInputs(float fElapsedTime)
 	{
-		/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
-		if (GetKey('W').bHeld && !GetKey('S').bHeld)
-			camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
-		else if (GetKey('S').bHeld && !GetKey('W').bHeld)
-			camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
-
-		if (GetKey('A').bHeld && !GetKey('D').bHeld)
-			camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
-		else if (GetKey('D').bHeld && !GetKey('A').bHeld)
-			camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
-
-		if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
-			camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
-		else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
-			camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
-
-		// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
-		if (GetKey('C').bHeld)
+		// Benchmarks replay a camera path instead of reading the inputs
+		CameraPose pose;
+		if (GetBenchmarkPose(pose))
 		{
-			if (fFov > 10.0f)
-				fFov -= fElapsedTime * 200.0f;
+			camera.setPose(pose);
 
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			blockShader.use();
-			blockShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
+			if (pose.fFov != fFov)
+			{
+				fFov = pose.fFov;
+				SetProjectionMatrix();
+			}
 		}
 
-		else if (GetKey('C').bReleased)
+		else
 		{
-			fFov = 80.0f;
+			/* ------------------------------------------ - Keyboard Control - ------------------------------------------- */
+			if (GetKey('W').bHeld && !GetKey('S').bHeld)
+				camera.ProcessKeyboard(CameraMovement::FORWARD, fElapsedTime);
+			else if (GetKey('S').bHeld && !GetKey('W').bHeld)
+				camera.ProcessKeyboard(CameraMovement::BACKWARD, fElapsedTime);
+
+			if (GetKey('A').bHeld && !GetKey('D').bHeld)
+				camera.ProcessKeyboard(CameraMovement::LEFT, fElapsedTime);
+			else if (GetKey('D').bHeld && !GetKey('A').bHeld)
+				camera.ProcessKeyboard(CameraMovement::RIGHT, fElapsedTime);
+
+			if (GetKey(GLFW_KEY_SPACE).bHeld && !GetKey(GLFW_KEY_LEFT_SHIFT).bHeld)
+				camera.ProcessKeyboard(CameraMovement::UP, fElapsedTime);
+			else if (GetKey(GLFW_KEY_LEFT_SHIFT).bHeld && !GetKey(GLFW_KEY_SPACE).bHeld)
+				camera.ProcessKeyboard(CameraMovement::DOWN, fElapsedTime);
+
+			// Emulate a "zoom-in" view by decreasing the FOV if 'C' is pressed
+			if (GetKey('C').bHeld)
+			{
+				if (fFov > 10.0f)
+					fFov -= fElapsedTime * 200.0f;
 
-			matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-			axesShader.use();
-			axesShader.setMat4("matProjection", matProjection);
-			blockShader.use();
-			blockShader.setMat4("matProjection", matProjection);
-			lampShader.use();
-			lampShader.setMat4("matProjection", matProjection);
-		}
+				SetProjectionMatrix();
+			}
 
-		if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
-			camera.fCameraSpeed = 20.0f;
-		else
-			camera.fCameraSpeed = 5.0f;
+			else if (GetKey('C').bReleased)
+			{
+				fFov = 80.0f;
 
-		if (GetKey(GLFW_KEY_HOME).bPressed)
-			camera.init(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+				SetProjectionMatrix();
+			}
+
+			if (GetKey(GLFW_KEY_LEFT_CONTROL).bHeld)
+				camera.fCameraSpeed = 20.0f;
+			else
+				camera.fCameraSpeed = 5.0f;
 
-		/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
-		camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+			if (GetKey(GLFW_KEY_HOME).bPressed)
+				camera.init(vCameraStart, glm::vec3(0.0f, 0.0f, -1.0f));
+
+			/* ------------------------------------------ - Mouse Control - ------------------------------------------- */
+			camera.ProcessMouse(this, GetMousePosX(), GetMousePosY());
+
+			// Saved with --record, to be replayed with --benchmark
+			pose = camera.getPose();
+			pose.fFov = fFov;
+			RecordCameraPose(pose);
+		}
 
 		// Update view matrix
-		camera.UpdateView(axesShader, "matView");
-		camera.UpdateView(blockShader, "matView");
-		camera.UpdateView(lampShader, "matView");
+		sceneUniforms.camera.matView = camera.getLookAt();
 	}
 
 	void SetProjectionMatrix()
 	{
-		// Set projection matrix in shaders as they do not change often
+		// Shared by all shaders through the Camera block, uploaded every frame in UpdateShader()
 		matProjection = glm::perspective(fFov * pi / 180.0f, (float)ScreenWidth() / (float)ScreenHeight(), 0.1f, 1000.0f);
-		axesShader.use();
-		axesShader.setMat4("matProjection", matProjection);
-		blockShader.use();
-		blockShader.setMat4("matProjection", matProjection);
-		lampShader.use();
-		lampShader.setMat4("matProjection", matProjection);
+		sceneUniforms.camera.matProjection = matProjection;
+	}
+
+	bool IsReady() override
+	{
+		// A lamp which failed to load is left out instead of holding the run up
+		return world.isReady() && (lampModel.isLoaded() || lampModel.hasLoadFailed());
 	}
 
 	void Destroy() override
 	{
-		for (auto& block : blocks)
-		{
-			delete block;
-			block = nullptr;
-		}
+		// Stop the workers first, their completions refer to the world and the models
+		jobs.shutdown();
 
-		blocks.clear();
+		world.free();
+		blockTextures.free();
 
 		axesVAO.free();
 		axesVBO.free();
+		sceneUniforms.free();
 
 		std::cout << "\nDuration: " << std::fixed << std::setprecision(2) << fTimeSinceStart << 's' << std::endl;
 	}
@@ -312,9 +372,10 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char* argv[])
 {
 	Window window;
+	window.ParseArguments(argc, argv);
 	window.ConstructWindow(800, 600, "OpenGL");
 	window.Start();
 
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Math library
+#include <glm/glm.hpp>
+
+#include "stb_image_impl.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Source textures of the block texture array, the block models (models/grass.obj, ...) use the same ones
+constexpr const char* GRASS_TEXTURE_PATH = "resources/textures/Grass4.png";
+constexpr const char* DIRT_TEXTURE_PATH = "resources/textures/Dirt2.png";
+constexpr const char* STONE_TEXTURE_PATH = "resources/textures/Stone.png";
+
+// Type of a block stored in a chunk. AIR is empty space.
+enum class BlockID : uint8_t
+{
+	AIR = 0,
+	GRASS,
+	DIRT,
+	STONE,
+	COUNT
+};
+
+// Layers of the block texture array
+enum class BlockLayer : uint8_t
+{
+	GRASS_TOP = 0,
+	GRASS_SIDE,
+	DIRT,
+	STONE,
+	COUNT
+};
+
+// Layers used by the faces of a block
+struct BlockFaces
+{
+	BlockLayer top;
+	BlockLayer bottom;
+	BlockLayer side;
+};
+
+inline BlockFaces getBlockFaces(BlockID id)
+{
+	switch (id)
+	{
+	case BlockID::GRASS:
+		return { BlockLayer::GRASS_TOP, BlockLayer::GRASS_TOP, BlockLayer::GRASS_SIDE };
+
+	case BlockID::DIRT:
+		return { BlockLayer::DIRT, BlockLayer::DIRT, BlockLayer::DIRT };
+
+	case BlockID::STONE:
+	default:
+		return { BlockLayer::STONE, BlockLayer::STONE, BlockLayer::STONE };
+	}
+}
+
+/**
+  * All block textures in a single GL_TEXTURE_2D_ARRAY, one layer per face texture, so that a whole world of mixed
+  * block types is drawn with one texture bound. Chunk vertices carry the layer of their face.
+  *
+  * The block models use a part of their texture per face (Grass4.png has the side on the left half and the top on
+  * the right half, Dirt2.png is a cube net), so each layer is cut out of its source texture using the same UV
+  * rectangle the model uses, and resampled to 'layerSize' x 'layerSize' pixels. By default the layers are as large
+  * as the largest cut-out (rounded up to a power of two), so the textures keep their resolution. Mipmaps are built
+  * per layer, so unlike in a 2D atlas the layers never bleed into each other and each one can simply repeat across
+  * merged faces.
+  */
+class BlockTextureArray
+{
+private:
+	// Layers larger than this are taken down to it
+	static constexpr int MAX_LAYER_SIZE = 1024;
+
+	unsigned int m_TextureID = 0;
+	int m_LayerSize = 0;
+
+	// A source texture in memory, RGBA with row 0 at the bottom
+	struct SourceImage
+	{
+		const char* path = nullptr;
+		unsigned char* data = nullptr;
+		int width = 0, height = 0;
+	};
+
+public:
+	BlockTextureArray() = default;
+
+	// Builds the texture array. A 'layerSize' of 0 picks the size from the source textures.
+	// Returns false if one of the textures fails to load.
+	bool load(int layerSize = 0);
+
+	void bind() const;
+
+	int getLayerCount() const;
+
+	int getLayerSize() const;
+
+	void free();
+
+private:
+	// Resamples the UV rectangle (u0, v0) - (u1, v1) of 'image' into 'pixels' (one layer, RGBA)
+	void CopyLayer(std::vector<uint8_t>& pixels, const SourceImage& image, float u0, float v0, float u1, float v1) const;
+};
+
+bool BlockTextureArray::load(int layerSize)
+{
+	struct LayerSource
+	{
+		BlockLayer layer;
+		const char* texturePath;
+		float u0, v0, u1, v1;
+	};
+
+	// UV rectangles match the ones in models/grass.obj and models/Grass2.obj
+	const LayerSource sources[] =
+	{
+		{ BlockLayer::GRASS_TOP, GRASS_TEXTURE_PATH, 0.5025f, 0.005f, 0.9975f, 0.995f },
+		{ BlockLayer::GRASS_SIDE, GRASS_TEXTURE_PATH, 0.0025f, 0.005f, 0.4975f, 0.995f },
+		{ BlockLayer::DIRT, DIRT_TEXTURE_PATH, 0.003836f, 0.337524f, 0.247945f, 0.662476f },
+		{ BlockLayer::STONE, STONE_TEXTURE_PATH, 0.0f, 0.0f, 1.0f, 1.0f }
+	};
+
+	// Row 0 is the bottom row, just like texture coordinates
+	stbi_set_flip_vertically_on_load(true);
+
+	// Each texture is loaded once, Grass4.png holds two layers
+	std::vector<SourceImage> images;
+	bool bLoaded = true;
+
+	for (const LayerSource& source : sources)
+	{
+		if (std::any_of(images.begin(), images.end(), [&](const SourceImage& image) { return strcmp(image.path, source.texturePath) == 0; }))
+			continue;
+
+		SourceImage image;
+		image.path = source.texturePath;
+
+		int nrChannels;
+		image.data = stbi_load(source.texturePath, &image.width, &image.height, &nrChannels, 4);
+
+		if (!image.data)
+		{
+			std::cerr << "Failed to load texture: " << source.texturePath << std::endl;
+			bLoaded = false;
+			break;
+		}
+
+		images.push_back(image);
+	}
+
+	auto getImage = [&](const char* path) -> const SourceImage&
+	{
+		return *std::find_if(images.begin(), images.end(), [&](const SourceImage& image) { return strcmp(image.path, path) == 0; });
+	};
+
+	if (bLoaded)
+	{
+		// As large as the largest cut-out in source pixels, rounded up to a power of two for the mipmaps
+		m_LayerSize = layerSize;
+
+		if (m_LayerSize <= 0)
+		{
+			float fLargest = 1.0f;
+
+			for (const LayerSource& source : sources)
+			{
+				const SourceImage& image = getImage(source.texturePath);
+				fLargest = std::max({ fLargest, (source.u1 - source.u0) * image.width, (source.v1 - source.v0) * image.height });
+			}
+
+			m_LayerSize = 1;
+			while (m_LayerSize < (int)ceilf(fLargest) && m_LayerSize < MAX_LAYER_SIZE)
+				m_LayerSize *= 2;
+		}
+
+		glGenTextures(1, &m_TextureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D_ARRAY, m_TextureID);
+
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_LayerSize, m_LayerSize, getLayerCount(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		std::vector<uint8_t> pixels((size_t)m_LayerSize * m_LayerSize * 4);
+
+		for (const LayerSource& source : sources)
+		{
+			CopyLayer(pixels, getImage(source.texturePath), source.u0, source.v0, source.u1, source.v1);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (int)source.layer, m_LayerSize, m_LayerSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		}
+
+		// Filters each layer on its own
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	for (SourceImage& image : images)
+		stbi_image_free(image.data);
+
+	return bLoaded;
+}
+
+void BlockTextureArray::bind() const
+{
+	GLState::get().bindTexture(GL_TEXTURE_2D_ARRAY, m_TextureID);
+}
+
+int BlockTextureArray::getLayerCount() const
+{
+	return (int)BlockLayer::COUNT;
+}
+
+int BlockTextureArray::getLayerSize() const
+{
+	return m_LayerSize;
+}
+
+void BlockTextureArray::free()
+{
+	GLState::get().deleteTextures(1, &m_TextureID);
+	m_TextureID = 0;
+}
+
+// Private utility function - to resample a part of a texture into a layer. Each layer pixel is the average of the
+// source pixels it covers (a box filter), or the nearest source pixel where the layer is larger than the cut-out.
+void BlockTextureArray::CopyLayer(std::vector<uint8_t>& pixels, const SourceImage& image, float u0, float v0, float u1, float v1) const
+{
+	// Size of one layer pixel in source pixels
+	const float fStepX = (u1 - u0) * image.width / (float)m_LayerSize;
+	const float fStepY = (v1 - v0) * image.height / (float)m_LayerSize;
+
+	for (int y = 0; y < m_LayerSize; y++)
+	{
+		// Source rows whose centers lie inside the layer pixel, at least the nearest one
+		const float fY0 = v0 * image.height + y * fStepY;
+		const int sy0 = glm::clamp((int)ceilf(fY0 - 0.5f), 0, image.height - 1);
+		const int sy1 = glm::clamp(std::max((int)ceilf(fY0 + fStepY - 0.5f), sy0 + 1), 1, image.height);
+
+		for (int x = 0; x < m_LayerSize; x++)
+		{
+			const float fX0 = u0 * image.width + x * fStepX;
+			const int sx0 = glm::clamp((int)ceilf(fX0 - 0.5f), 0, image.width - 1);
+			const int sx1 = glm::clamp(std::max((int)ceilf(fX0 + fStepX - 0.5f), sx0 + 1), 1, image.width);
+
+			uint32_t sum[4] = { 0, 0, 0, 0 };
+			for (int sy = sy0; sy < sy1; sy++)
+			{
+				for (int sx = sx0; sx < sx1; sx++)
+				{
+					const uint8_t* src = image.data + ((size_t)sy * image.width + sx) * 4;
+					for (int c = 0; c < 4; c++)
+						sum[c] += src[c];
+				}
+			}
+
+			const uint32_t count = (uint32_t)((sy1 - sy0) * (sx1 - sx0));
+			uint8_t* dst = pixels.data() + ((size_t)y * m_LayerSize + x) * 4;
+
+			for (int c = 0; c < 4; c++)
+				dst[c] = (uint8_t)((sum[c] + count / 2) / count);
+		}
+	}
+}
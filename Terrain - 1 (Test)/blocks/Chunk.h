@@ -0,0 +1,540 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Math library
+#include <glm/glm.hpp>
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "BufferLayout.h"
+
+#include "BlockTextureArray.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Dimensions of a chunk in blocks
+constexpr int CHUNK_SIZE_X = 16;
+constexpr int CHUNK_SIZE_Y = 256;
+constexpr int CHUNK_SIZE_Z = 16;
+
+// Position (chunk space), normal, texture coordinates (in blocks, repeat once per block) and texture array layer
+constexpr int CHUNK_FLOATS_PER_VERTEX = 9;
+
+// CPU-side mesh of a chunk, filled by Chunk::buildMesh() and uploaded by Chunk::upload()
+struct ChunkMeshData
+{
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+
+	void clear()
+	{
+		vertices.clear();
+		indices.clear();
+	}
+
+	size_t getVertexCount() const { return vertices.size() / CHUNK_FLOATS_PER_VERTEX; }
+};
+
+// Block IDs of a chunk. Index = x + z * CHUNK_SIZE_X + y * CHUNK_SIZE_X * CHUNK_SIZE_Z, so every horizontal layer is contiguous.
+struct ChunkBlocks
+{
+	std::vector<BlockID> blocks;
+
+	// One above the highest layer which may contain a solid block. Meshing stops there.
+	int height = 0;
+
+	ChunkBlocks() : blocks((size_t)CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z, BlockID::AIR)
+	{}
+
+	BlockID get(int x, int y, int z) const
+	{
+		return blocks[x + z * CHUNK_SIZE_X + y * CHUNK_SIZE_X * CHUNK_SIZE_Z];
+	}
+
+	void set(int x, int y, int z, BlockID id)
+	{
+		blocks[x + z * CHUNK_SIZE_X + y * CHUNK_SIZE_X * CHUNK_SIZE_Z] = id;
+
+		if (id != BlockID::AIR && y >= height)
+			height = y + 1;
+	}
+};
+
+/**
+  * A 16x16x256 column of the world, stored as a dense array of block IDs.
+  *
+  * The whole chunk is drawn as a single mesh. Only faces between a solid block and air are meshed, and
+  * neighbouring faces which lie in the same plane and use the same texture layer are merged into one quad (greedy
+  * meshing). A flat 16x16 grass surface therefore ends up as one quad on top instead of 256 cubes.
+  *
+  * The blocks are shared with mesh jobs running on worker threads (see World::update()). Editing a block while a
+  * job still holds them copies them first, so a job always sees the blocks as they were when it was submitted.
+  */
+class Chunk
+{
+private:
+	std::shared_ptr<ChunkBlocks> m_Blocks;
+
+	// Position of the chunk in chunks (world position / chunk size)
+	int m_ChunkX = 0;
+	int m_ChunkZ = 0;
+
+	// False while the blocks are still being generated by a job
+	bool m_bGenerated = true;
+
+	bool m_bDirty = true;
+
+	// A mesh job for this chunk is running
+	bool m_bMeshing = false;
+
+	// Incremented on every change, so that a mesh built from older blocks doesn't clear the dirty flag
+	uint32_t m_Revision = 0;
+
+	// GPU mesh
+	VertexArray vao;
+	VertexBuffer<float> vbo;
+	IndexBuffer ibo;
+	GLenum indexType = GL_UNSIGNED_SHORT;
+	int nr_indices = 0;
+	bool m_bBuffersCreated = false;
+
+public:
+	// Chunks which are not 'bGenerated' are empty until their blocks are set with setBlockData()
+	Chunk(int chunkX, int chunkZ, bool bGenerated = true);
+
+	Chunk(const Chunk&) = delete;
+	Chunk& operator=(const Chunk&) = delete;
+
+	// Coordinates are local to the chunk and have to be inside it
+	BlockID getBlock(int x, int y, int z) const;
+	void setBlock(int x, int y, int z, BlockID id);
+
+	int getChunkX() const;
+	int getChunkZ() const;
+	int getHeight() const;
+
+	// World position of the chunk's (0, 0, 0) corner
+	glm::vec3 getOrigin() const;
+
+	// World space bounding box of the blocks in the chunk
+	void getBounds(glm::vec3& vMin, glm::vec3& vMax) const;
+
+	// A chunk is dirty when its blocks changed since its mesh was last built
+	bool isDirty() const;
+	void setDirty();
+
+	bool isGenerated() const;
+	bool isMeshing() const;
+	void setMeshing(bool bMeshing);
+	uint32_t getRevision() const;
+
+	// Blocks of the chunk, to be handed to a job
+	std::shared_ptr<const ChunkBlocks> getBlockData() const;
+
+	// Replaces all blocks, e.g. with the result of a generation job
+	void setBlockData(std::shared_ptr<ChunkBlocks> blocks);
+
+	// Builds the mesh of the chunk into 'mesh', see the static version below
+	void buildMesh(const Chunk* const neighbours[4], ChunkMeshData& mesh) const;
+
+	/**
+	  * Builds the mesh of 'blocks' into 'mesh'. 'neighbours' are the blocks of the chunks at -X, +X, -Z and +Z
+	  * (nullptr at the edge of the world), they decide whether the faces on the chunk's border are visible.
+	  * Doesn't touch OpenGL, so it can run on any thread.
+	  */
+	static void buildMesh(const ChunkBlocks& blocks, const ChunkBlocks* const neighbours[4], ChunkMeshData& mesh);
+
+	// Uploads a mesh built by buildMesh(). The dirty flag is cleared if the mesh was built from 'revision' and no
+	// blocks changed since.
+	void upload(const ChunkMeshData& mesh);
+	void upload(const ChunkMeshData& mesh, uint32_t revision);
+
+	// Draws the chunk. Make sure to bind the chunk shader and the block textures before calling this function.
+	void draw() const;
+
+	int getIndexCount() const;
+
+	void free();
+
+private:
+	// Block at a chunk local position which may lie inside one of the neighbouring chunks
+	static BlockID GetBlockOrNeighbour(const ChunkBlocks& blocks, const ChunkBlocks* const neighbours[4], int x, int y, int z);
+
+	static void AddQuad(ChunkMeshData& mesh, const int corner[3], const int du[3], const int dv[3], int axis, bool bPositive, BlockLayer layer);
+};
+
+Chunk::Chunk(int chunkX, int chunkZ, bool bGenerated) : m_ChunkX(chunkX), m_ChunkZ(chunkZ), m_bGenerated(bGenerated)
+{
+	m_Blocks = std::make_shared<ChunkBlocks>();
+}
+
+BlockID Chunk::getBlock(int x, int y, int z) const
+{
+	return m_Blocks->get(x, y, z);
+}
+
+void Chunk::setBlock(int x, int y, int z, BlockID id)
+{
+	// Copy on write, a job may still be reading the blocks. Workers only ever drop their references,
+	// so a count of 1 means nobody else can see the blocks.
+	if (m_Blocks.use_count() > 1)
+		m_Blocks = std::make_shared<ChunkBlocks>(*m_Blocks);
+
+	m_Blocks->set(x, y, z, id);
+
+	m_bDirty = true;
+	m_Revision++;
+}
+
+int Chunk::getChunkX() const
+{
+	return m_ChunkX;
+}
+
+int Chunk::getChunkZ() const
+{
+	return m_ChunkZ;
+}
+
+int Chunk::getHeight() const
+{
+	return m_Blocks->height;
+}
+
+glm::vec3 Chunk::getOrigin() const
+{
+	return glm::vec3((float)(m_ChunkX * CHUNK_SIZE_X), 0.0f, (float)(m_ChunkZ * CHUNK_SIZE_Z));
+}
+
+void Chunk::getBounds(glm::vec3& vMin, glm::vec3& vMax) const
+{
+	vMin = getOrigin();
+	vMax = vMin + glm::vec3((float)CHUNK_SIZE_X, (float)getHeight(), (float)CHUNK_SIZE_Z);
+}
+
+bool Chunk::isDirty() const
+{
+	return m_bDirty;
+}
+
+void Chunk::setDirty()
+{
+	m_bDirty = true;
+	m_Revision++;
+}
+
+bool Chunk::isGenerated() const
+{
+	return m_bGenerated;
+}
+
+bool Chunk::isMeshing() const
+{
+	return m_bMeshing;
+}
+
+void Chunk::setMeshing(bool bMeshing)
+{
+	m_bMeshing = bMeshing;
+}
+
+uint32_t Chunk::getRevision() const
+{
+	return m_Revision;
+}
+
+std::shared_ptr<const ChunkBlocks> Chunk::getBlockData() const
+{
+	return m_Blocks;
+}
+
+void Chunk::setBlockData(std::shared_ptr<ChunkBlocks> blocks)
+{
+	m_Blocks = std::move(blocks);
+	m_bGenerated = true;
+
+	setDirty();
+}
+
+void Chunk::buildMesh(const Chunk* const neighbours[4], ChunkMeshData& mesh) const
+{
+	const ChunkBlocks* neighbourBlocks[4];
+
+	for (int i = 0; i < 4; i++)
+		neighbourBlocks[i] = neighbours[i] ? neighbours[i]->m_Blocks.get() : nullptr;
+
+	buildMesh(*m_Blocks, neighbourBlocks, mesh);
+}
+
+void Chunk::buildMesh(const ChunkBlocks& blocks, const ChunkBlocks* const neighbours[4], ChunkMeshData& mesh)
+{
+	mesh.clear();
+
+	const int dims[3] = { CHUNK_SIZE_X, blocks.height, CHUNK_SIZE_Z };
+
+	// Layer + 1 of the visible face at each position of the current slice, 0 where there is no face
+	std::vector<uint8_t> mask;
+
+	// Faces are meshed per direction: -X, +X, -Y, +Y, -Z, +Z
+	for (int face = 0; face < 6; face++)
+	{
+		const int axis = face / 2;
+		const bool bPositive = (face & 1) != 0;
+
+		// The two axes spanning the slice. (axis, u, v) is always a right-handed cyclic order.
+		const int u = (axis + 1) % 3;
+		const int v = (axis + 2) % 3;
+
+		int q[3] = { 0, 0, 0 };
+		q[axis] = bPositive ? 1 : -1;
+
+		mask.assign((size_t)dims[u] * dims[v], 0);
+
+		int x[3] = { 0, 0, 0 };
+		for (x[axis] = 0; x[axis] < dims[axis]; x[axis]++)
+		{
+			// Find the visible faces of this slice
+			int n = 0;
+			for (x[v] = 0; x[v] < dims[v]; x[v]++)
+			{
+				for (x[u] = 0; x[u] < dims[u]; x[u]++, n++)
+				{
+					mask[n] = 0;
+
+					const BlockID block = blocks.get(x[0], x[1], x[2]);
+					if (block == BlockID::AIR)
+						continue;
+
+					if (GetBlockOrNeighbour(blocks, neighbours, x[0] + q[0], x[1] + q[1], x[2] + q[2]) != BlockID::AIR)
+						continue;
+
+					const BlockFaces faces = getBlockFaces(block);
+					const BlockLayer layer = axis != 1 ? faces.side : (bPositive ? faces.top : faces.bottom);
+
+					mask[n] = (uint8_t)layer + 1;
+				}
+			}
+
+			// Merge the faces into rectangles, growing each one along u first and then along v
+			n = 0;
+			for (int j = 0; j < dims[v]; j++)
+			{
+				for (int i = 0; i < dims[u];)
+				{
+					const uint8_t layer = mask[n];
+					if (layer == 0)
+					{
+						i++;
+						n++;
+						continue;
+					}
+
+					int w = 1;
+					while (i + w < dims[u] && mask[n + w] == layer)
+						w++;
+
+					int h = 1;
+					for (; j + h < dims[v]; h++)
+					{
+						bool bRowMatches = true;
+						for (int k = 0; k < w; k++)
+						{
+							if (mask[n + k + h * dims[u]] != layer)
+							{
+								bRowMatches = false;
+								break;
+							}
+						}
+
+						if (!bRowMatches)
+							break;
+					}
+
+					// The face lies on the far side of the block for positive directions
+					int corner[3] = { x[0], x[1], x[2] };
+					corner[axis] += bPositive ? 1 : 0;
+					corner[u] = i;
+					corner[v] = j;
+
+					int du[3] = { 0, 0, 0 };
+					int dv[3] = { 0, 0, 0 };
+					du[u] = w;
+					dv[v] = h;
+
+					AddQuad(mesh, corner, du, dv, axis, bPositive, (BlockLayer)(layer - 1));
+
+					// Remove the merged faces from the mask
+					for (int l = 0; l < h; l++)
+					{
+						for (int k = 0; k < w; k++)
+							mask[n + k + l * dims[u]] = 0;
+					}
+
+					i += w;
+					n += w;
+				}
+			}
+		}
+	}
+}
+
+void Chunk::upload(const ChunkMeshData& mesh)
+{
+	upload(mesh, m_Revision);
+}
+
+void Chunk::upload(const ChunkMeshData& mesh, uint32_t revision)
+{
+	if (!m_bBuffersCreated)
+	{
+		vao.generate();
+		vbo.generate(CHUNK_FLOATS_PER_VERTEX);
+		ibo.generate();
+
+		BufferLayout layout;
+		layout.setBufferLayout(vao, vbo, ibo, 3, BufferType::FLOAT);		// Position
+		layout.setBufferLayout(vao, vbo, ibo, 3, BufferType::FLOAT);		// Normal
+		layout.setBufferLayout(vao, vbo, ibo, 2, BufferType::FLOAT);		// Texture coordinates
+		layout.setBufferLayout(vao, vbo, ibo, 1, BufferType::FLOAT);		// Texture array layer
+
+		m_bBuffersCreated = true;
+	}
+
+	vao.bind();
+
+	vbo.bind();
+	vbo.setBuffer(mesh.vertices.size() * sizeof(float), mesh.vertices.data());
+
+	ibo.bind();
+
+	// Use 16-bit indices whenever possible, which halves the index buffer
+	if (mesh.getVertexCount() <= 0xFFFF)
+	{
+		std::vector<uint16_t> indices16(mesh.indices.begin(), mesh.indices.end());
+		ibo.setBuffer(indices16.size() * sizeof(uint16_t), indices16.data());
+		indexType = GL_UNSIGNED_SHORT;
+	}
+
+	else
+	{
+		ibo.setBuffer(mesh.indices.size() * sizeof(uint32_t), mesh.indices.data());
+		indexType = GL_UNSIGNED_INT;
+	}
+
+	nr_indices = (int)mesh.indices.size();
+
+	if (revision == m_Revision)
+		m_bDirty = false;
+}
+
+void Chunk::draw() const
+{
+	if (nr_indices == 0)
+		return;
+
+	vao.bind();
+	glDrawElements(GL_TRIANGLES, nr_indices, indexType, 0);
+}
+
+int Chunk::getIndexCount() const
+{
+	return nr_indices;
+}
+
+void Chunk::free()
+{
+	if (m_bBuffersCreated)
+	{
+		vao.free();
+		vbo.free();
+		ibo.free();
+		m_bBuffersCreated = false;
+	}
+
+	nr_indices = 0;
+}
+
+// Private utility function - looks outside of the chunk when the position isn't inside it
+BlockID Chunk::GetBlockOrNeighbour(const ChunkBlocks& blocks, const ChunkBlocks* const neighbours[4], int x, int y, int z)
+{
+	// Nothing is ever seen from below the world
+	if (y < 0)
+		return BlockID::STONE;
+
+	if (y >= CHUNK_SIZE_Y)
+		return BlockID::AIR;
+
+	if (x < 0)
+		return neighbours[0] ? neighbours[0]->get(x + CHUNK_SIZE_X, y, z) : BlockID::AIR;
+
+	if (x >= CHUNK_SIZE_X)
+		return neighbours[1] ? neighbours[1]->get(x - CHUNK_SIZE_X, y, z) : BlockID::AIR;
+
+	if (z < 0)
+		return neighbours[2] ? neighbours[2]->get(x, y, z + CHUNK_SIZE_Z) : BlockID::AIR;
+
+	if (z >= CHUNK_SIZE_Z)
+		return neighbours[3] ? neighbours[3]->get(x, y, z - CHUNK_SIZE_Z) : BlockID::AIR;
+
+	return blocks.get(x, y, z);
+}
+
+// Private utility function - appends the quad corner, corner + du, corner + du + dv, corner + dv
+void Chunk::AddQuad(ChunkMeshData& mesh, const int corner[3], const int du[3], const int dv[3], int axis, bool bPositive, BlockLayer layer)
+{
+	const uint32_t first = (uint32_t)mesh.getVertexCount();
+
+	const int corners[4][3] =
+	{
+		{ corner[0], corner[1], corner[2] },
+		{ corner[0] + du[0], corner[1] + du[1], corner[2] + du[2] },
+		{ corner[0] + du[0] + dv[0], corner[1] + du[1] + dv[1], corner[2] + du[2] + dv[2] },
+		{ corner[0] + dv[0], corner[1] + dv[1], corner[2] + dv[2] }
+	};
+
+	float vNormal[3] = { 0.0f, 0.0f, 0.0f };
+	vNormal[axis] = bPositive ? 1.0f : -1.0f;
+
+	for (const auto& p : corners)
+	{
+		// Texture coordinates follow the world axes, with 'up' along +Y on the sides, so a texture repeats once per block
+		float s, t;
+		if (axis == 0)
+		{
+			s = (float)p[2];
+			t = (float)p[1];
+		}
+
+		else if (axis == 1)
+		{
+			s = (float)p[0];
+			t = (float)p[2];
+		}
+
+		else
+		{
+			s = (float)p[0];
+			t = (float)p[1];
+		}
+
+		const float vertex[CHUNK_FLOATS_PER_VERTEX] =
+		{
+			(float)p[0], (float)p[1], (float)p[2],
+			vNormal[0], vNormal[1], vNormal[2],
+			s, t,
+			(float)layer
+		};
+
+		mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + CHUNK_FLOATS_PER_VERTEX);
+	}
+
+	// Counter-clockwise when seen from the side the face points to
+	if (bPositive)
+		mesh.indices.insert(mesh.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+	else
+		mesh.indices.insert(mesh.indices.end(), { first, first + 2, first + 1, first, first + 3, first + 2 });
+}
@@ -0,0 +1,464 @@
+#pragma once
+
+// Math library
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "Chunk.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+  * Grid of chunks making up the block terrain. The world starts at (0, 0, 0) and spans
+  * chunksX * CHUNK_SIZE_X by CHUNK_SIZE_Y by chunksZ * CHUNK_SIZE_Z blocks.
+  *
+  * Blocks are edited through setBlock(), which marks the affected chunks as dirty. build() then remeshes only the
+  * dirty chunks, and render() draws one mesh per chunk inside the view frustum.
+  *
+  * With generateAsync() and update(), generating and meshing the chunks runs on a JobSystem instead. Chunks show up
+  * as their meshes are uploaded by the job system's completions, without the render loop ever waiting for them.
+  */
+class World
+{
+private:
+	int m_ChunksX = 0;
+	int m_ChunksZ = 0;
+
+	// Row-major, index = chunkX + chunkZ * m_ChunksX
+	std::vector<std::unique_ptr<Chunk>> m_Chunks;
+
+	// Scratch mesh reused for every chunk which gets rebuilt
+	ChunkMeshData m_MeshData;
+
+	// Incremented by generate(), completions of jobs submitted for an older world are ignored
+	uint32_t m_Generation = 0;
+
+	// Bounding boxes of the chunks, same order as m_Chunks
+	BoundingBoxes m_Bounds;
+	bool m_bBoundsDirty = false;
+	std::vector<uint32_t> m_Visible;
+
+	CullingStats m_Stats;
+
+public:
+	World() = default;
+
+	// Creates chunksX x chunksZ chunks filled with a hilly terrain of stone, dirt and grass
+	void generate(int chunksX, int chunksZ, uint32_t seed);
+
+	// Like generate(), but the blocks of each chunk are generated by a job. Call update() every frame afterwards.
+	void generateAsync(int chunksX, int chunksZ, uint32_t seed, JobSystem& jobs);
+
+	/**
+	  * Submits a mesh job for every dirty chunk whose neighbours are generated, and refreshes the chunk bounds.
+	  * Meshes are uploaded by the completions, so jobs.processCompleted() has to be called every frame as well.
+	  * The world has to outlive the jobs, shut the job system down before freeing the world.
+	  */
+	void update(JobSystem& jobs);
+
+	// True when every chunk is generated and its mesh is up to date
+	bool isReady() const;
+
+	// Block at a world position, AIR outside of the world
+	BlockID getBlock(int x, int y, int z) const;
+
+	// Changes a block, positions outside of the world are ignored
+	void setBlock(int x, int y, int z, BlockID id);
+
+	Chunk* getChunk(int chunkX, int chunkZ) const;
+
+	// Rebuilds the meshes of all dirty chunks right away, returns how many were rebuilt
+	int build();
+
+	// Draws the chunks which intersect the frustum. Make sure to bind the chunk shader and the block textures first.
+	void render(Shader& shader, Uniform uChunkOffset, const Frustum& frustum);
+
+	// Number of chunks drawn and culled by the last call to render()
+	const CullingStats& getStats() const;
+
+	size_t getChunkCount() const;
+
+	// Number of triangles in all chunk meshes
+	size_t getTriangleCount() const;
+
+	void free();
+
+private:
+	// Fills the blocks of a chunk with the terrain. Only depends on its arguments, so it can run on any thread.
+	static void GenerateBlocks(int chunkX, int chunkZ, uint32_t seed, ChunkBlocks& blocks);
+
+	// Blocks of the existing neighbours at -X, +X, -Z and +Z, returns false if one of them isn't generated yet
+	bool GetNeighbours(const Chunk& chunk, const Chunk* neighbours[4]) const;
+
+	void UpdateBounds();
+
+	// Height of the terrain surface at a column, from a few octaves of value noise
+	static int GetTerrainHeight(int x, int z, uint32_t seed);
+
+	// Random values in [0, 1) on an integer grid, smoothly interpolated in between
+	static float ValueNoise(float x, float z, uint32_t seed);
+	static float Hash(int x, int z, uint32_t seed);
+};
+
+void World::generate(int chunksX, int chunksZ, uint32_t seed)
+{
+	free();
+
+	m_ChunksX = chunksX;
+	m_ChunksZ = chunksZ;
+	m_Generation++;
+
+	m_Chunks.reserve((size_t)chunksX * chunksZ);
+
+	for (int chunkZ = 0; chunkZ < chunksZ; chunkZ++)
+	{
+		for (int chunkX = 0; chunkX < chunksX; chunkX++)
+		{
+			auto blocks = std::make_shared<ChunkBlocks>();
+			GenerateBlocks(chunkX, chunkZ, seed, *blocks);
+
+			m_Chunks.push_back(std::make_unique<Chunk>(chunkX, chunkZ));
+			m_Chunks.back()->setBlockData(std::move(blocks));
+		}
+	}
+}
+
+void World::generateAsync(int chunksX, int chunksZ, uint32_t seed, JobSystem& jobs)
+{
+	free();
+
+	m_ChunksX = chunksX;
+	m_ChunksZ = chunksZ;
+	m_Generation++;
+
+	m_Chunks.reserve((size_t)chunksX * chunksZ);
+
+	for (int chunkZ = 0; chunkZ < chunksZ; chunkZ++)
+	{
+		for (int chunkX = 0; chunkX < chunksX; chunkX++)
+			m_Chunks.push_back(std::make_unique<Chunk>(chunkX, chunkZ, false));
+	}
+
+	const uint32_t generation = m_Generation;
+
+	for (size_t index = 0; index < m_Chunks.size(); index++)
+	{
+		const int chunkX = m_Chunks[index]->getChunkX();
+		const int chunkZ = m_Chunks[index]->getChunkZ();
+
+		jobs.submit<std::shared_ptr<ChunkBlocks>>(
+			[chunkX, chunkZ, seed](std::shared_ptr<ChunkBlocks>& blocks)
+			{
+				blocks = std::make_shared<ChunkBlocks>();
+				GenerateBlocks(chunkX, chunkZ, seed, *blocks);
+			},
+			[this, index, generation](std::shared_ptr<ChunkBlocks>& blocks)
+			{
+				if (generation == m_Generation)
+					m_Chunks[index]->setBlockData(std::move(blocks));
+			});
+	}
+}
+
+void World::update(JobSystem& jobs)
+{
+	const uint32_t generation = m_Generation;
+
+	for (size_t index = 0; index < m_Chunks.size(); index++)
+	{
+		Chunk& chunk = *m_Chunks[index];
+
+		if (!chunk.isGenerated() || !chunk.isDirty() || chunk.isMeshing())
+			continue;
+
+		const Chunk* neighbours[4];
+		if (!GetNeighbours(chunk, neighbours))
+			continue;
+
+		// The job keeps its own references to the blocks, edits made meanwhile go into a copy (see Chunk::setBlock())
+		std::shared_ptr<const ChunkBlocks> blocks[5] = { chunk.getBlockData() };
+		for (int i = 0; i < 4; i++)
+		{
+			if (neighbours[i])
+				blocks[i + 1] = neighbours[i]->getBlockData();
+		}
+
+		const uint32_t revision = chunk.getRevision();
+		chunk.setMeshing(true);
+
+		jobs.submit<ChunkMeshData>(
+			[blocks](ChunkMeshData& mesh)
+			{
+				const ChunkBlocks* neighbourBlocks[4] = { blocks[1].get(), blocks[2].get(), blocks[3].get(), blocks[4].get() };
+				Chunk::buildMesh(*blocks[0], neighbourBlocks, mesh);
+			},
+			[this, index, generation, revision](ChunkMeshData& mesh)
+			{
+				if (generation != m_Generation)
+					return;
+
+				Chunk& chunk = *m_Chunks[index];
+				chunk.upload(mesh, revision);
+				chunk.setMeshing(false);
+
+				m_bBoundsDirty = true;
+			});
+	}
+
+	if (m_bBoundsDirty)
+		UpdateBounds();
+}
+
+bool World::isReady() const
+{
+	for (const auto& chunk : m_Chunks)
+	{
+		if (!chunk->isGenerated() || chunk->isDirty() || chunk->isMeshing())
+			return false;
+	}
+
+	return true;
+}
+
+BlockID World::getBlock(int x, int y, int z) const
+{
+	if (x < 0 || z < 0 || y < 0 || y >= CHUNK_SIZE_Y)
+		return BlockID::AIR;
+
+	const Chunk* chunk = getChunk(x / CHUNK_SIZE_X, z / CHUNK_SIZE_Z);
+	if (!chunk)
+		return BlockID::AIR;
+
+	return chunk->getBlock(x % CHUNK_SIZE_X, y, z % CHUNK_SIZE_Z);
+}
+
+void World::setBlock(int x, int y, int z, BlockID id)
+{
+	if (x < 0 || z < 0 || y < 0 || y >= CHUNK_SIZE_Y)
+		return;
+
+	const int chunkX = x / CHUNK_SIZE_X;
+	const int chunkZ = z / CHUNK_SIZE_Z;
+
+	Chunk* chunk = getChunk(chunkX, chunkZ);
+	if (!chunk)
+		return;
+
+	const int localX = x % CHUNK_SIZE_X;
+	const int localZ = z % CHUNK_SIZE_Z;
+
+	chunk->setBlock(localX, y, localZ, id);
+
+	// Blocks on the border also decide which faces of the neighbouring chunk are visible
+	Chunk* neighbour = nullptr;
+	if (localX == 0 && (neighbour = getChunk(chunkX - 1, chunkZ)))
+		neighbour->setDirty();
+	if (localX == CHUNK_SIZE_X - 1 && (neighbour = getChunk(chunkX + 1, chunkZ)))
+		neighbour->setDirty();
+	if (localZ == 0 && (neighbour = getChunk(chunkX, chunkZ - 1)))
+		neighbour->setDirty();
+	if (localZ == CHUNK_SIZE_Z - 1 && (neighbour = getChunk(chunkX, chunkZ + 1)))
+		neighbour->setDirty();
+}
+
+Chunk* World::getChunk(int chunkX, int chunkZ) const
+{
+	if (chunkX < 0 || chunkZ < 0 || chunkX >= m_ChunksX || chunkZ >= m_ChunksZ)
+		return nullptr;
+
+	return m_Chunks[chunkX + chunkZ * m_ChunksX].get();
+}
+
+int World::build()
+{
+	int rebuilt = 0;
+
+	for (auto& chunk : m_Chunks)
+	{
+		if (!chunk->isGenerated() || !chunk->isDirty() || chunk->isMeshing())
+			continue;
+
+		const Chunk* neighbours[4];
+		GetNeighbours(*chunk, neighbours);
+
+		chunk->buildMesh(neighbours, m_MeshData);
+		chunk->upload(m_MeshData);
+
+		rebuilt++;
+	}
+
+	// Chunk heights may have changed
+	if (rebuilt > 0 || m_bBoundsDirty)
+		UpdateBounds();
+
+	return rebuilt;
+}
+
+void World::render(Shader& shader, Uniform uChunkOffset, const Frustum& frustum)
+{
+	m_Bounds.cull(frustum, m_Visible);
+
+	m_Stats.drawn = m_Visible.size();
+	m_Stats.culled = m_Chunks.size() - m_Visible.size();
+
+	for (uint32_t index : m_Visible)
+	{
+		const Chunk& chunk = *m_Chunks[index];
+
+		shader.setVec3(uChunkOffset, chunk.getOrigin());
+		chunk.draw();
+	}
+}
+
+const CullingStats& World::getStats() const
+{
+	return m_Stats;
+}
+
+size_t World::getChunkCount() const
+{
+	return m_Chunks.size();
+}
+
+size_t World::getTriangleCount() const
+{
+	size_t count = 0;
+
+	for (const auto& chunk : m_Chunks)
+		count += chunk->getIndexCount() / 3;
+
+	return count;
+}
+
+void World::free()
+{
+	for (auto& chunk : m_Chunks)
+		chunk->free();
+
+	m_Chunks.clear();
+	m_Bounds.clear();
+	m_bBoundsDirty = false;
+
+	m_ChunksX = 0;
+	m_ChunksZ = 0;
+}
+
+// Private utility function - grass on top, three layers of dirt below and stone below that
+void World::GenerateBlocks(int chunkX, int chunkZ, uint32_t seed, ChunkBlocks& blocks)
+{
+	const int originX = chunkX * CHUNK_SIZE_X;
+	const int originZ = chunkZ * CHUNK_SIZE_Z;
+
+	for (int z = 0; z < CHUNK_SIZE_Z; z++)
+	{
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			const int height = GetTerrainHeight(originX + x, originZ + z, seed);
+
+			for (int y = 0; y <= height; y++)
+			{
+				BlockID id = BlockID::STONE;
+				if (y == height)
+					id = BlockID::GRASS;
+				else if (y >= height - 3)
+					id = BlockID::DIRT;
+
+				blocks.set(x, y, z, id);
+			}
+		}
+	}
+}
+
+// Private utility function - neighbours outside of the world are nullptr
+bool World::GetNeighbours(const Chunk& chunk, const Chunk* neighbours[4]) const
+{
+	const int chunkX = chunk.getChunkX();
+	const int chunkZ = chunk.getChunkZ();
+
+	neighbours[0] = getChunk(chunkX - 1, chunkZ);
+	neighbours[1] = getChunk(chunkX + 1, chunkZ);
+	neighbours[2] = getChunk(chunkX, chunkZ - 1);
+	neighbours[3] = getChunk(chunkX, chunkZ + 1);
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (neighbours[i] && !neighbours[i]->isGenerated())
+			return false;
+	}
+
+	return true;
+}
+
+// Private utility function - to refresh the bounding boxes used for culling
+void World::UpdateBounds()
+{
+	m_Bounds.clear();
+
+	for (const auto& chunk : m_Chunks)
+	{
+		glm::vec3 vMin, vMax;
+		chunk->getBounds(vMin, vMax);
+		m_Bounds.add(vMin, vMax);
+	}
+
+	m_bBoundsDirty = false;
+}
+
+// Private utility function - to generate the height map
+int World::GetTerrainHeight(int x, int z, uint32_t seed)
+{
+	float fHeight = 0.0f;
+	float fAmplitude = 1.0f;
+	float fFrequency = 1.0f / 64.0f;
+	float fTotalAmplitude = 0.0f;
+
+	for (int octave = 0; octave < 4; octave++)
+	{
+		fHeight += ValueNoise((float)x * fFrequency, (float)z * fFrequency, seed + octave) * fAmplitude;
+		fTotalAmplitude += fAmplitude;
+
+		fAmplitude *= 0.5f;
+		fFrequency *= 2.0f;
+	}
+
+	// Surface between y = 32 and y = 80
+	return 32 + (int)(fHeight / fTotalAmplitude * 48.0f);
+}
+
+// Private utility function - bilinear interpolation of the grid values with a smoothstep curve
+float World::ValueNoise(float x, float z, uint32_t seed)
+{
+	const int ix = (int)std::floor(x);
+	const int iz = (int)std::floor(z);
+
+	float fx = x - (float)ix;
+	float fz = z - (float)iz;
+
+	fx = fx * fx * (3.0f - 2.0f * fx);
+	fz = fz * fz * (3.0f - 2.0f * fz);
+
+	const float a = Hash(ix, iz, seed);
+	const float b = Hash(ix + 1, iz, seed);
+	const float c = Hash(ix, iz + 1, seed);
+	const float d = Hash(ix + 1, iz + 1, seed);
+
+	return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fz);
+}
+
+// Private utility function - random value in [0, 1) for a grid point
+float World::Hash(int x, int z, uint32_t seed)
+{
+	uint32_t h = seed * 0x9E3779B9u;
+	h ^= (uint32_t)x * 0x85EBCA6Bu;
+	h = (h ^ (h >> 13)) * 0xC2B2AE35u;
+	h ^= (uint32_t)z * 0x27D4EB2Fu;
+	h = (h ^ (h >> 15)) * 0x85EBCA6Bu;
+	h ^= h >> 16;
+
+	return (float)(h & 0xFFFFFF) / (float)0x1000000;
+}
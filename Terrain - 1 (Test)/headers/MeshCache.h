@@ -0,0 +1,250 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "MeshData.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+/**
+  * Binary mesh format (.mesh), written next to the source model (e.g. models/Man.obj -> models/Man.obj.mesh).
+  *
+  *	MeshFileHeader		fixed size, describes everything below
+  *	vertex blob			interleaved vertices, exactly as they are uploaded into the vertex buffer
+  *	index blob			16 or 32-bit indices, exactly as they are uploaded into the index buffer
+  *
+  * The header stores the size and modification time of the source file, so a cache file is only used while
+  * it still matches the model it was built from. Loading maps the file and hands the blobs straight to
+  * glBufferData, no parsing involved.
+  */
+
+// Describes one vertex attribute in the vertex blob
+struct MeshFileAttribute
+{
+	uint32_t componentCount = 0;	// e.g. 3 for a vec3
+	uint32_t componentType = 0;		// MeshFileAttribute::FLOAT
+	uint32_t offset = 0;			// byte offset inside a vertex
+
+	static constexpr uint32_t FLOAT = 0;
+};
+
+struct MeshFileHeader
+{
+	static constexpr uint32_t MAX_ATTRIBUTES = 8;
+	static constexpr char MAGIC[4] = { 'C', 'M', 'S', 'H' };
+	static constexpr uint32_t VERSION = 2;
+
+	char magic[4] = { 'C', 'M', 'S', 'H' };
+	uint32_t version = VERSION;
+
+	// Identifies the source file the mesh was built from. Its path isn't part of the key, the cache file sits
+	// next to the model and the converter tool and the program may well reach it through different paths.
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+
+	// Vertex layout descriptor
+	uint32_t vertexStride = 0;
+	uint32_t attributeCount = 0;
+	MeshFileAttribute attributes[MAX_ATTRIBUTES];
+
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t indexType = 0;			// 0 = UINT16, 1 = UINT32 (see IndexType)
+	uint32_t flags = 0;				// MeshFileHeader::TEXTURED
+
+	// Model space bounding box of the positions
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	// Byte offsets and sizes of the blobs, relative to the beginning of the file
+	uint64_t vertexOffset = 0;
+	uint64_t vertexBytes = 0;
+	uint64_t indexOffset = 0;
+	uint64_t indexBytes = 0;
+
+	static constexpr uint32_t TEXTURED = 1;
+};
+
+// The header is written as-is, so make sure the compiler doesn't insert padding between the fields
+static_assert(sizeof(MeshFileHeader) == 200, "MeshFileHeader layout changed, bump MeshFileHeader::VERSION");
+
+// A cached mesh which is still memory-mapped. The pointers stay valid as long as the view lives.
+class MeshFileView
+{
+private:
+	MappedFile m_File;
+	const MeshFileHeader* m_Header = nullptr;
+
+public:
+	bool open(const std::string& cachePath);
+
+	const MeshFileHeader& header() const { return *m_Header; }
+	const void* vertices() const { return m_File.data() + m_Header->vertexOffset; }
+	const void* indices() const { return m_File.data() + m_Header->indexOffset; }
+};
+
+class MeshCache
+{
+public:
+	// Path of the cache file belonging to a model
+	static std::string getCachePath(const std::string& sourcePath);
+
+	// Opens the cache file of 'sourcePath'. Returns false if there is none, or if it is outdated or corrupt.
+	static bool load(const std::string& sourcePath, MeshFileView& view);
+
+	// Writes 'mesh' into the cache file of 'sourcePath'
+	static bool save(const std::string& sourcePath, const MeshData& mesh);
+
+	// Fills in the layout, counts and blob offsets of the header which 'mesh' is written with
+	static MeshFileHeader describe(const MeshData& mesh);
+
+private:
+	static bool GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& time);
+};
+
+bool MeshFileView::open(const std::string& cachePath)
+{
+	m_Header = nullptr;
+
+	if (!m_File.open(cachePath) || m_File.size() < sizeof(MeshFileHeader))
+		return false;
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(m_File.data());
+
+	if (memcmp(header->magic, MeshFileHeader::MAGIC, sizeof(header->magic)) != 0 || header->version != MeshFileHeader::VERSION)
+		return false;
+
+	if (header->attributeCount > MeshFileHeader::MAX_ATTRIBUTES ||
+		(header->indexType != (uint32_t)IndexType::UINT16 && header->indexType != (uint32_t)IndexType::UINT32))
+		return false;
+
+	// The attributes are tightly packed floats and make up the whole stride
+	uint64_t attributeBytes = 0;
+	for (uint32_t i = 0; i < header->attributeCount; i++)
+	{
+		const MeshFileAttribute& attribute = header->attributes[i];
+		if (attribute.componentType != MeshFileAttribute::FLOAT || attribute.componentCount > 4 || attribute.offset != attributeBytes)
+			return false;
+
+		attributeBytes += (uint64_t)attribute.componentCount * sizeof(float);
+	}
+
+	if (header->vertexStride == 0 || header->vertexStride != attributeBytes)
+		return false;
+
+	// The counts have to match the blob sizes, the products can't overflow as both factors are 32-bit
+	const uint64_t indexSize = header->indexType == (uint32_t)IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	if ((uint64_t)header->vertexCount * header->vertexStride != header->vertexBytes ||
+		(uint64_t)header->indexCount * indexSize != header->indexBytes)
+		return false;
+
+	// Make sure the blobs are inside the file, written so that offset + size can't wrap around
+	const uint64_t fileSize = m_File.size();
+	if (header->vertexOffset > fileSize || header->vertexBytes > fileSize - header->vertexOffset ||
+		header->indexOffset > fileSize || header->indexBytes > fileSize - header->indexOffset)
+		return false;
+
+	m_Header = header;
+	return true;
+}
+
+std::string MeshCache::getCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".mesh";
+}
+
+bool MeshCache::load(const std::string& sourcePath, MeshFileView& view)
+{
+	uint64_t size;
+	int64_t time;
+
+	if (!GetSourceInfo(sourcePath, size, time))
+		return false;
+
+	if (!view.open(getCachePath(sourcePath)))
+		return false;
+
+	const MeshFileHeader& header = view.header();
+	return header.sourceSize == size && header.sourceTime == time;
+}
+
+bool MeshCache::save(const std::string& sourcePath, const MeshData& mesh)
+{
+	MeshFileHeader header = describe(mesh);
+
+	if (!GetSourceInfo(sourcePath, header.sourceSize, header.sourceTime))
+		return false;
+
+	// Write into a temporary file first, so that a crash never leaves a half-written cache file behind
+	const std::string cachePath = getCachePath(sourcePath);
+	const std::string tempPath = cachePath + ".tmp";
+
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+			return false;
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(mesh.vertices.data()), (std::streamsize)header.vertexBytes);
+		stream.write(reinterpret_cast<const char*>(mesh.indices.data()), (std::streamsize)header.indexBytes);
+
+		if (!stream.good())
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	return !error;
+}
+
+MeshFileHeader MeshCache::describe(const MeshData& mesh)
+{
+	MeshFileHeader header;
+
+	// Position, normal and (optionally) texture coordinates, all floats
+	const uint32_t componentCounts[] = { 3, 3, 2 };
+	header.attributeCount = mesh.bTextured ? 3 : 2;
+
+	for (uint32_t i = 0; i < header.attributeCount; i++)
+	{
+		header.attributes[i].componentCount = componentCounts[i];
+		header.attributes[i].componentType = MeshFileAttribute::FLOAT;
+		header.attributes[i].offset = header.vertexStride;
+		header.vertexStride += componentCounts[i] * sizeof(float);
+	}
+
+	header.vertexCount = (uint32_t)mesh.getVertexCount();
+	header.indexCount = (uint32_t)mesh.getIndexCount();
+	header.indexType = (uint32_t)mesh.indexType;
+	header.flags = mesh.bTextured ? MeshFileHeader::TEXTURED : 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		header.boundsMin[i] = mesh.vBoundsMin[i];
+		header.boundsMax[i] = mesh.vBoundsMax[i];
+	}
+
+	header.vertexOffset = sizeof(MeshFileHeader);
+	header.vertexBytes = mesh.vertices.size() * sizeof(float);
+	header.indexOffset = header.vertexOffset + header.vertexBytes;
+	header.indexBytes = mesh.indices.size();
+
+	return header;
+}
+
+// Private utility function - to get the values the cache file is keyed on
+bool MeshCache::GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& time)
+{
+	std::error_code error;
+
+	size = (uint64_t)std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return false;
+
+	time = (int64_t)std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+	return !error;
+}
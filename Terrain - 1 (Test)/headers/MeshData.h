@@ -0,0 +1,181 @@
+#pragma once
+
+#include "ObjParser.h"
+
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Size of the indices in an index buffer. Meshes with up to 65535 unique vertices use 16-bit indices.
+enum class IndexType
+{
+	UINT16,
+	UINT32
+};
+
+/**
+  * CPU-side mesh, ready to be uploaded into a vertex and an index buffer.
+  * Vertices are interleaved floats (position, normal and, if present, texture coordinates).
+  */
+struct MeshData
+{
+	std::vector<float> vertices;
+	int floatsPerVertex = 0;
+
+	// Raw index buffer contents, either uint16_t or uint32_t values depending on 'indexType'
+	std::vector<uint8_t> indices;
+	IndexType indexType = IndexType::UINT16;
+
+	bool bTextured = false;
+
+	// Model space bounding box of the vertex positions
+	glm::vec3 vBoundsMin = glm::vec3(0.0f);
+	glm::vec3 vBoundsMax = glm::vec3(0.0f);
+
+	size_t getVertexCount() const { return floatsPerVertex ? vertices.size() / floatsPerVertex : 0; }
+	size_t getIndexSize() const { return indexType == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+	size_t getIndexCount() const { return indices.size() / getIndexSize(); }
+};
+
+/**
+  * Builds an indexed mesh from the faces of an object file.
+  *
+  * Every face vertex is expanded into its position/normal/texture coordinate tuple, and identical tuples
+  * are welded into a single vertex using a hash table keyed on the vertex contents. Shared vertices are
+  * therefore stored once and referenced by the index buffer, which lets the GPU's post-transform cache
+  * reuse them.
+  */
+class MeshBuilder
+{
+public:
+	static void build(const ObjData& obj, MeshData& mesh);
+
+private:
+	static uint32_t Hash(const float* vertex, int floatCount);
+};
+
+void MeshBuilder::build(const ObjData& obj, MeshData& mesh)
+{
+	mesh.bTextured = obj.hasTexCoords();
+	mesh.floatsPerVertex = mesh.bTextured ? 8 : 6;
+
+	const int floatCount = mesh.floatsPerVertex;
+	const size_t faceVertexCount = obj.indices.size();
+
+	mesh.vertices.clear();
+	mesh.vertices.reserve(faceVertexCount * floatCount);
+
+	std::vector<uint32_t> indices(faceVertexCount);
+
+	// Open addressing hash table storing (vertex index + 1), 0 marks an empty slot.
+	// The size is a power of two which is at least twice the number of face vertices.
+	size_t tableSize = 16;
+	while (tableSize < faceVertexCount * 2)
+		tableSize <<= 1;
+
+	std::vector<uint32_t> table(tableSize, 0);
+	const size_t mask = tableSize - 1;
+
+	float vertex[8];
+
+	mesh.vBoundsMin = glm::vec3(faceVertexCount ? FLT_MAX : 0.0f);
+	mesh.vBoundsMax = glm::vec3(faceVertexCount ? -FLT_MAX : 0.0f);
+
+	for (size_t i = 0; i < faceVertexCount; i++)
+	{
+		const ObjIndex& index = obj.indices[i];
+
+		const glm::vec3 position = obj.positions[index.position];
+		const glm::vec3 normal = index.normal >= 0 ? obj.normals[index.normal] : glm::vec3(0.0f);
+
+		vertex[0] = position.x;
+		vertex[1] = position.y;
+		vertex[2] = position.z;
+		vertex[3] = normal.x;
+		vertex[4] = normal.y;
+		vertex[5] = normal.z;
+
+		if (mesh.bTextured)
+		{
+			const glm::vec2 texCoord = index.texCoord >= 0 ? obj.texCoords[index.texCoord] : glm::vec2(0.0f);
+			vertex[6] = texCoord.x;
+			vertex[7] = texCoord.y;
+		}
+
+		// Blender writes "-0.0000", which has to match 0.0 bitwise for the comparison below
+		for (int k = 0; k < floatCount; k++)
+		{
+			if (vertex[k] == 0.0f)
+				vertex[k] = 0.0f;
+		}
+
+		size_t slot = Hash(vertex, floatCount) & mask;
+		while (true)
+		{
+			const uint32_t entry = table[slot];
+
+			// New vertex
+			if (entry == 0)
+			{
+				const uint32_t vertexIndex = (uint32_t)(mesh.vertices.size() / floatCount);
+				mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + floatCount);
+
+				mesh.vBoundsMin = glm::min(mesh.vBoundsMin, position);
+				mesh.vBoundsMax = glm::max(mesh.vBoundsMax, position);
+
+				table[slot] = vertexIndex + 1;
+				indices[i] = vertexIndex;
+				break;
+			}
+
+			// Same vertex seen before
+			if (memcmp(&mesh.vertices[(size_t)(entry - 1) * floatCount], vertex, floatCount * sizeof(float)) == 0)
+			{
+				indices[i] = entry - 1;
+				break;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	// Use 16-bit indices whenever possible, which halves the index buffer
+	if (mesh.getVertexCount() <= 0xFFFF)
+	{
+		mesh.indexType = IndexType::UINT16;
+		mesh.indices.resize(faceVertexCount * sizeof(uint16_t));
+
+		uint16_t* indices16 = reinterpret_cast<uint16_t*>(mesh.indices.data());
+		for (size_t i = 0; i < faceVertexCount; i++)
+			indices16[i] = (uint16_t)indices[i];
+	}
+
+	else
+	{
+		mesh.indexType = IndexType::UINT32;
+		mesh.indices.resize(faceVertexCount * sizeof(uint32_t));
+		memcpy(mesh.indices.data(), indices.data(), mesh.indices.size());
+	}
+}
+
+// FNV-1a over the bits of the vertex
+uint32_t MeshBuilder::Hash(const float* vertex, int floatCount)
+{
+	uint32_t hash = 2166136261u;
+
+	for (int k = 0; k < floatCount; k++)
+	{
+		uint32_t bits;
+		memcpy(&bits, &vertex[k], sizeof(bits));
+
+		hash = (hash ^ bits) * 16777619u;
+	}
+
+	// Mix the upper bits down, as the table index only uses the lower ones
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6du;
+	hash ^= hash >> 12;
+
+	return hash;
+}
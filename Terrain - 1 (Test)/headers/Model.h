@@ -5,6 +5,12 @@
 #include "Shader.h"
 #include "BufferLayout.h"
 #include "Texture2D.h"
+#include "IndexBuffer.h"
+#include "ObjParser.h"
+#include "MeshData.h"
+#include "MeshCache.h"
+#include "Frustum.h"
+#include "JobSystem.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,13 +22,31 @@
 #include <sstream>
 #include <iomanip>
 
+// Mesh of a model read on the CPU, either mapped from its cache file or parsed from the object file
+struct ModelMeshSource
+{
+	MeshFileView cached;
+	bool bCached = false;
+
+	MeshData mesh;
+	bool bLoaded = false;
+};
+
 class Model
 {
 private:
 	VertexArray vao;
 	VertexBuffer<float> vbo;
+	IndexBuffer ibo;
 	std::vector<Texture2D> textures;
 	int nr_indices = 0;
+	GLenum indexType = GL_UNSIGNED_SHORT;
+	bool m_bLoaded = false;
+	bool m_bLoadFailed = false;
+
+	// Model space bounding box
+	glm::vec3 vBoundsMin = glm::vec3(0.0f);
+	glm::vec3 vBoundsMax = glm::vec3(0.0f);
 
 public:
 	//glm::mat4 matModel = glm::mat4(1.0f);
@@ -33,31 +57,79 @@ public:
 	// Load the object file
 	bool load(const std::string& objfilePath);
 
+	// Reads the object file on a worker of 'jobs' and uploads it when the job's completion runs.
+	// The model draws nothing until then.
+	void loadAsync(const std::string& objfilePath, JobSystem& jobs);
+
+	bool isLoaded() const;
+
+	// True if the object file couldn't be read, the model then never gets loaded
+	bool hasLoadFailed() const;
+
 	// Bind textures to the model, if any
 	// For now, this function is just a placeholder and does nothing
 	void setTextures(const std::vector<std::string>& texturePaths);
 	void setTextures(const std::vector<std::string>&& texturePaths);
 
+	// Bind textures by using a function, as doing them for every draw call is inefficient.
+	void bindTextures();
+
 	// Function which draws the model onto the screen. Make sure to bind shaders before calling this function.
 	void draw();
 
+	// Model space bounding box, used for frustum culling
+	const glm::vec3& getBoundsMin() const;
+	const glm::vec3& getBoundsMax() const;
+
 	// Destructor
 	~Model();
 
 private:
 	// Utility function to load model
-	bool LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile);
+	bool LoadModel(const std::string& modelFile);
+	void UploadMesh(const MeshFileHeader& header, const void* vertices, const void* indices);
+	void UploadMesh(const ModelMeshSource& source);
+
+	// Doesn't touch OpenGL, so it can run on any thread. 'threadCount' is passed on to ObjParser.
+	static bool ReadMesh(const std::string& modelFile, ModelMeshSource& source, unsigned int threadCount);
 };
 
 Model::Model(const std::string& objfilepath, const std::vector<std::string>&& texturePaths)
 {
-	LoadModel(vao, vbo, nr_indices, objfilepath);
+	LoadModel(objfilepath);
 	setTextures(texturePaths);
 }
 
 bool Model::load(const std::string& objfilePath)
 {
-	return LoadModel(vao, vbo, nr_indices, objfilePath);
+	return LoadModel(objfilePath);
+}
+
+void Model::loadAsync(const std::string& objfilePath, JobSystem& jobs)
+{
+	jobs.submit<ModelMeshSource>(
+		[objfilePath](ModelMeshSource& source)
+		{
+			// Other jobs keep the remaining workers busy, so parse on this thread only
+			ReadMesh(objfilePath, source, 1);
+		},
+		[this](ModelMeshSource& source)
+		{
+			if (source.bLoaded)
+				UploadMesh(source);
+			else
+				m_bLoadFailed = true;
+		});
+}
+
+bool Model::isLoaded() const
+{
+	return m_bLoaded;
+}
+
+bool Model::hasLoadFailed() const
+{
+	return m_bLoadFailed;
 }
 
 void Model::setTextures(const std::vector<std::string>& texturePaths)
@@ -69,235 +141,147 @@ void Model::setTextures(const std::vector<std::string>& texturePaths)
 		textures.push_back(texture);
 	}
 
-	// Bind textures
+	// Bind textures. The wrap mode is part of the texture, so it only has to be set once instead of for every draw.
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	}
 }
 
 void Model::setTextures(const std::vector<std::string>&& texturePaths)
 {
-	for (const auto& texturePath : texturePaths)
-	{
-		Texture2D texture;
-		texture.loadTexture(texturePath.c_str());
-		textures.push_back(texture);
-	}
+	setTextures(texturePaths);
+}
 
-	// Bind textures
+void Model::bindTextures()
+{
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::get().activeTexture(i);
 		textures[i].bindTexture();
 	}
 }
 
 void Model::draw()
 {
+	if (!m_bLoaded)
+		return;
+
 	// Draw the model
 	vao.bind();
 
 	// Bind textures
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		textures[i].bindTexture();
-	}
+	bindTextures();
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glDrawElements(GL_TRIANGLES, nr_indices, indexType, 0);
+}
 
-	glDrawArrays(GL_TRIANGLES, 0, nr_indices);
+const glm::vec3& Model::getBoundsMin() const
+{
+	return vBoundsMin;
+}
+
+const glm::vec3& Model::getBoundsMax() const
+{
+	return vBoundsMax;
 }
 
 Model::~Model()
 {
+	ibo.free();
 	vbo.free();
 	vao.free();
 }
 
-// Utility function to load models (written earlier so I'm lazy to properly integrate it in load() function :/
-// TODO: Add texture functonality
-bool Model::LoadModel(VertexArray& vao, VertexBuffer<float>& vbo, int& vertexCount, const std::string& modelFile)
+// Utility function to load models
+bool Model::LoadModel(const std::string& modelFile)
+{
+	ModelMeshSource source;
+
+	if (!ReadMesh(modelFile, source, 0))
+	{
+		m_bLoadFailed = true;
+		return false;
+	}
+
+	UploadMesh(source);
+	return true;
+}
+
+// Utility function to read the mesh of a model. The model is read from its binary cache file if there is an
+// up-to-date one, otherwise the object file is parsed and the cache file gets written for the next run.
+bool Model::ReadMesh(const std::string& modelFile, ModelMeshSource& source, unsigned int threadCount)
 {
-	std::vector<glm::vec3> temp_positions;
-	std::vector<glm::vec3> temp_normals;
-	std::vector<glm::vec2> temp_textures;
+	if (MeshCache::load(modelFile, source.cached))
+	{
+		source.bCached = true;
+		source.bLoaded = true;
+		return true;
+	}
 
-	std::ifstream inputFileStream(modelFile);
-	std::string line;
-	std::stringstream ss;
+	ObjData obj;
 
-	if (!inputFileStream.is_open())
+	if (!ObjParser::parse(modelFile, obj, threadCount))
 	{
 		std::cerr << "Failed to open object file: " << modelFile << std::endl;
 		return false;
 	}
 
-	/** If the object file has "mtllib" on the third line, then the object file is
-	  * associated with some MTL file which we need to parse along with OBJ file */
+	if (obj.invalidFaces > 0)
+		std::cerr << "Skipped " << obj.invalidFaces << " invalid faces in " << modelFile << std::endl;
 
-	// Go to the third line
-	std::string lineParser;
-	
-	// Read 3 lines
-	for (int i = 0; i < 3; i++)
-		std::getline(inputFileStream, lineParser);
+	// Weld identical vertices together and build an index buffer referencing them
+	MeshBuilder::build(obj, source.mesh);
 
-	// Read the third line and see if it has mtllib
-	//std::getline(inputFileStream, lineParser);
-	
-	if (lineParser.find("mtllib") != std::string::npos)
-	{
-		struct VertexTexture
-		{
-			glm::vec3 position;
-			glm::vec3 normal;
-			glm::vec2 textures;
-		};
-		std::vector<VertexTexture> verticesTexture;
+	if (!MeshCache::save(modelFile, source.mesh))
+		std::cerr << "Failed to write mesh cache: " << MeshCache::getCachePath(modelFile) << std::endl;
 
-		while (std::getline(inputFileStream, line))
-		{
-			// Vertex normals
-			if (line.starts_with("vn"))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_normals.push_back({f1, f2, f3});
-			}
-
-			// Texture coordinates
-			else if (line.starts_with("vt"))
-			{
-				float f1, f2;
-				sscanf_s(line.c_str(), "%*s %f %f", &f1, &f2);
-				temp_textures.push_back({ f1, f2 });
-			}
-
-			// Vertex coordinates
-			else if (line.starts_with('v'))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_positions.push_back({ f1, f2, f3 });
-			}
-
-			// Indices
-			else if (line.starts_with('f'))
-			{
-				int v[3];
-				int n[3];
-				int t[3];
-
-				sscanf_s(line.c_str(), "%*s %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &t[0], &n[0], &v[1], &t[1], &n[1], &v[2], &t[2], &n[2]);
-
-				int posIndex;
-				int normIndex;
-				int textIndex;
-
-				for (int i = 0; i < 3; i++)
-				{
-					posIndex = v[i] - 1;
-					normIndex = n[i] - 1;
-					textIndex = t[i] - 1;
-
-					VertexTexture vertex;
-					vertex.position = temp_positions[posIndex];
-					vertex.normal = temp_normals[normIndex];
-					vertex.textures = temp_textures[textIndex];
-
-					verticesTexture.push_back(vertex);
-				}
-			}
-		}
-
-		BufferLayout layout;
-
-		vao.generate();
-		vbo.generate(8);		// 8 floats per vertex: 3 for vertex positions, 3 for vertex normals and 2 for texture coordinates
-
-		const void* vertexBuffer = verticesTexture.data();
-		vbo.setBuffer(verticesTexture.size() * 8 * sizeof(float), vertexBuffer);
-
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);		// Vertices
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);		// Normals
-		layout.setBufferLayout(vao, vbo, 2, BufferType::FLOAT);		// Texture coordinates
-
-		vertexCount = verticesTexture.size();
+	source.bLoaded = true;
+	return true;
+}
+
+// Utility function to upload a mesh read by ReadMesh()
+void Model::UploadMesh(const ModelMeshSource& source)
+{
+	if (source.bCached)
+	{
+		// The vertex and index blobs go straight from the mapped file into the buffers
+		UploadMesh(source.cached.header(), source.cached.vertices(), source.cached.indices());
+		nr_indices = (int)source.cached.header().indexCount;
 	}
 
-	// Else, it is just a regular object file without any textures
 	else
 	{
-		struct Vertex
-		{
-			glm::vec3 position;
-			glm::vec3 normal;
-		};
+		UploadMesh(MeshCache::describe(source.mesh), source.mesh.vertices.data(), source.mesh.indices.data());
+		nr_indices = (int)source.mesh.getIndexCount();
+	}
+}
 
-		std::vector<Vertex> vertices;
+// Utility function to create the buffers of the model, the layout is taken from the mesh header
+void Model::UploadMesh(const MeshFileHeader& header, const void* vertices, const void* indices)
+{
+	BufferLayout layout;
 
-		while (std::getline(inputFileStream, line))
-		{
-			if (line.starts_with("vn"))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_normals.push_back({ f1, f2, f3 });
-			}
-
-			if (line.starts_with('v'))
-			{
-				float f1, f2, f3;
-				sscanf_s(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
-				temp_positions.push_back({ f1, f2, f3 });
-			}
-
-			else if (line.starts_with('f'))
-			{
-				int v[3];
-				int n[3];
-
-				sscanf_s(line.c_str(), "%*s %d//%d %d//%d %d//%d", &v[0], &n[0], &v[1], &n[1], &v[2], &n[2]);
-
-				int posIndex;
-				int normIndex;
-
-				for (int i = 0; i < 3; i++)
-				{
-					posIndex = v[i] - 1;
-					normIndex = n[i] - 1;
-
-					Vertex vertex;
-					vertex.position = temp_positions[posIndex];
-					vertex.normal = temp_normals[normIndex];
-
-					vertices.push_back(vertex);
-				}
-			}
-		}
-
-		BufferLayout layout;
-
-		vao.generate();
-		vbo.generate(6);		// 6 floats per vertex: 3 for vertex positions and another 3 for normal vector
-
-		const void* vertexBuffer = vertices.data();
-		vbo.setBuffer(vertices.size() * 6 * sizeof(float), vertexBuffer);
-
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);	// positions
-		layout.setBufferLayout(vao, vbo, 3, BufferType::FLOAT);	// normals
-		vertexCount = vertices.size();
-	}
+	vao.generate();
+	vbo.generate(header.vertexStride / sizeof(float));		// 3 floats for vertex positions, 3 for vertex normals and 2 for texture coordinates (if any)
+	vbo.setBuffer(header.vertexBytes, vertices);
 
-	inputFileStream.close();
+	// The element buffer binding is stored in the VAO
+	ibo.generate();
+	ibo.setBuffer(header.indexBytes, indices);
 
-	//std::cout << "Finished loading!\n";
-	//std::cout << "Number of vertices: " << vertexCount << "\n";
-	//std::cout << "Size (bytes): " << vertexCount * sizeof(Vertex) << " bytes (" << std::fixed << std::setprecision(2) << (float)(vertexCount * sizeof(Vertex) / (1024.0f * 1024.0f)) << " MB)\n\n";
+	// Positions, normals and texture coordinates (object files which come with an MTL file)
+	for (uint32_t i = 0; i < header.attributeCount; i++)
+		layout.setBufferLayout(vao, vbo, (int)header.attributes[i].componentCount, BufferType::FLOAT);
 
-	return true;
-}
\ No newline at end of file
+	indexType = header.indexType == (uint32_t)IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	vBoundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	vBoundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+	m_bLoaded = true;
+}
@@ -0,0 +1,529 @@
+#pragma once
+
+// Math library
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Indices into the position, texture coordinate and normal arrays of an object file (0-based, -1 if missing)
+struct ObjIndex
+{
+	int position = -1;
+	int texCoord = -1;
+	int normal = -1;
+};
+
+// The parser addresses the three components as an int array
+static_assert(sizeof(ObjIndex) == 3 * sizeof(int), "ObjIndex must be tightly packed");
+
+// Raw contents of an object file. Every three indices make up a triangle, polygons are triangulated as a fan.
+// After parsing, every index is within its array (or -1 for a missing texture coordinate or normal).
+struct ObjData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<ObjIndex> indices;
+
+	// Faces with a malformed index and triangles with an index out of range, which were dropped
+	size_t invalidFaces = 0;
+
+	bool hasTexCoords() const { return !texCoords.empty(); }
+	bool hasNormals() const { return !normals.empty(); }
+
+	void clear();
+};
+
+/**
+  * Parser for Wavefront object files (v, vt, vn and f lines, everything else is skipped).
+  *
+  * The file is memory-mapped and split into line-aligned chunks which are parsed in parallel, each
+  * thread writing into its own arrays. The arrays are then concatenated in chunk order. Numbers are
+  * read with a small hand-written tokenizer instead of sscanf, so no allocation or locale lookup
+  * happens per line.
+  */
+class ObjParser
+{
+public:
+	// Files smaller than this are parsed on the calling thread only, as starting threads would cost more than it saves
+	static constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+	// Parses the object file at 'filePath'. 'threadCount' = 0 uses all hardware threads.
+	static bool parse(const std::string& filePath, ObjData& data, unsigned int threadCount = 0);
+
+	// Parses object file contents which are already in memory
+	static void parse(const char* begin, const char* end, ObjData& data, unsigned int threadCount = 0);
+
+private:
+	struct Chunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		ObjData data;
+
+		// Positions in 'data.indices' (as flat int offsets) of negative indices, which are relative to
+		// the number of elements read so far and need the chunk offset added when merging
+		std::vector<size_t> relativeIndices[3];
+	};
+
+	static void ParseChunk(Chunk& chunk);
+	static void AddIndex(Chunk& chunk, const ObjIndex& index, int relative);
+	static void Merge(std::vector<Chunk>& chunks, ObjData& data);
+	static void DropOutOfRange(ObjData& data);
+
+	static const char* SkipSpaces(const char* p, const char* end);
+	static const char* SkipLine(const char* p, const char* end);
+	static const char* ParseFloat(const char* p, const char* end, float& value);
+	static const char* ParseInt(const char* p, const char* end, int& value);
+};
+
+void ObjData::clear()
+{
+	positions.clear();
+	normals.clear();
+	texCoords.clear();
+	indices.clear();
+	invalidFaces = 0;
+}
+
+bool ObjParser::parse(const std::string& filePath, ObjData& data, unsigned int threadCount)
+{
+	MappedFile file;
+	if (!file.open(filePath))
+		return false;
+
+	parse(file.data(), file.data() + file.size(), data, threadCount);
+	return true;
+}
+
+void ObjParser::parse(const char* begin, const char* end, ObjData& data, unsigned int threadCount)
+{
+	data.clear();
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	const size_t bytes = (size_t)(end - begin);
+	const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, bytes / MIN_CHUNK_BYTES));
+
+	// Split the file into chunks of roughly the same size, moving each split point to the next line
+	std::vector<Chunk> chunks(chunkCount);
+	const char* chunkBegin = begin;
+
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		const char* chunkEnd = (i == chunkCount - 1) ? end : begin + bytes * (i + 1) / chunkCount;
+		chunkEnd = std::max(chunkEnd, chunkBegin);
+		chunkEnd = SkipLine(chunkEnd, end);
+
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	if (chunkCount == 1)
+	{
+		ParseChunk(chunks[0]);
+	}
+
+	else
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(chunkCount - 1);
+
+		// The calling thread parses the first chunk itself
+		for (size_t i = 1; i < chunkCount; i++)
+			threads.emplace_back(&ObjParser::ParseChunk, std::ref(chunks[i]));
+
+		ParseChunk(chunks[0]);
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	Merge(chunks, data);
+	DropOutOfRange(data);
+}
+
+void ObjParser::ParseChunk(Chunk& chunk)
+{
+	const char* p = chunk.begin;
+	const char* end = chunk.end;
+	ObjData& data = chunk.data;
+
+	// Rough guess of the element counts so the arrays don't keep growing (an average line is ~30 bytes)
+	const size_t estimatedLines = (size_t)(end - p) / 30 + 1;
+	data.positions.reserve(estimatedLines / 4);
+	data.normals.reserve(estimatedLines / 4);
+	data.texCoords.reserve(estimatedLines / 4);
+	data.indices.reserve(estimatedLines * 3 / 2);
+
+	while (p < end)
+	{
+		p = SkipSpaces(p, end);
+		if (p >= end)
+			break;
+
+		if (p[0] == 'v' && p + 1 < end && (p[1] == ' ' || p[1] == '\t'))
+		{
+			glm::vec3 v(0.0f);
+			p = ParseFloat(p + 2, end, v.x);
+			p = ParseFloat(p, end, v.y);
+			p = ParseFloat(p, end, v.z);
+			data.positions.push_back(v);
+		}
+
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 'n')
+		{
+			glm::vec3 n(0.0f);
+			p = ParseFloat(p + 2, end, n.x);
+			p = ParseFloat(p, end, n.y);
+			p = ParseFloat(p, end, n.z);
+			data.normals.push_back(n);
+		}
+
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 't')
+		{
+			glm::vec2 t(0.0f);
+			p = ParseFloat(p + 2, end, t.x);
+			p = ParseFloat(p, end, t.y);
+			data.texCoords.push_back(t);
+		}
+
+		else if (p[0] == 'f' && p + 1 < end && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 2;
+
+			ObjIndex first, previous;
+			int firstRelative = 0, previousRelative = 0;
+			int vertexCount = 0;
+			bool bValid = true;
+
+			// Triangles of this face are taken back if it turns out to be malformed
+			const size_t faceStart = data.indices.size();
+			const size_t relativeStarts[3] = { chunk.relativeIndices[0].size(), chunk.relativeIndices[1].size(), chunk.relativeIndices[2].size() };
+
+			// Read "v", "v/t", "v//n" or "v/t/n" groups until the end of the line
+			while (bValid)
+			{
+				p = SkipSpaces(p, end);
+				if (p >= end || *p == '\n' || *p == '\r' || *p == '#')
+					break;
+
+				// A component which is there must be a non-zero number, and the position must be there
+				int values[3] = { 0, 0, 0 };
+				for (int k = 0; k < 3; k++)
+				{
+					if (p < end && *p != '/')
+					{
+						const char* start = p;
+						p = ParseInt(p, end, values[k]);
+
+						if (p == start || values[k] == 0)
+							bValid = false;
+					}
+					else if (k == 0)
+						bValid = false;
+
+					if (bValid && k < 2 && p < end && *p == '/')
+						p++;
+					else
+						break;
+				}
+
+				if (!bValid)
+					break;
+
+				// Convert to 0-based indices. Negative indices are relative to the elements read so far in
+				// this chunk, so remember which components need fixing up in Merge() (one bit per component).
+				ObjIndex index;
+				int* components = &index.position;
+				const size_t elementCounts[3] = { data.positions.size(), data.texCoords.size(), data.normals.size() };
+				int relative = 0;
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (values[k] > 0)
+					{
+						components[k] = values[k] - 1;
+					}
+					else if (values[k] < 0)
+					{
+						components[k] = (int)elementCounts[k] + values[k];
+						relative |= 1 << k;
+					}
+				}
+
+				// Triangulate polygons as a fan around the first vertex
+				if (vertexCount == 0)
+				{
+					first = index;
+					firstRelative = relative;
+				}
+
+				else if (vertexCount >= 2)
+				{
+					AddIndex(chunk, first, firstRelative);
+					AddIndex(chunk, previous, previousRelative);
+					AddIndex(chunk, index, relative);
+				}
+
+				previous = index;
+				previousRelative = relative;
+				vertexCount++;
+			}
+
+			if (!bValid)
+			{
+				data.indices.resize(faceStart);
+				for (int k = 0; k < 3; k++)
+					chunk.relativeIndices[k].resize(relativeStarts[k]);
+
+				data.invalidFaces++;
+			}
+		}
+
+		p = SkipLine(p, end);
+	}
+}
+
+void ObjParser::AddIndex(Chunk& chunk, const ObjIndex& index, int relative)
+{
+	const size_t flatIndex = chunk.data.indices.size() * 3;
+	chunk.data.indices.push_back(index);
+
+	for (int k = 0; relative != 0 && k < 3; k++)
+	{
+		if (relative & (1 << k))
+			chunk.relativeIndices[k].push_back(flatIndex + k);
+	}
+}
+
+void ObjParser::Merge(std::vector<Chunk>& chunks, ObjData& data)
+{
+	if (chunks.size() == 1)
+	{
+		data = std::move(chunks[0].data);
+
+		// Relative indices are already correct when there is only one chunk
+		return;
+	}
+
+	size_t positionCount = 0, normalCount = 0, texCoordCount = 0, indexCount = 0;
+	for (const auto& chunk : chunks)
+	{
+		positionCount += chunk.data.positions.size();
+		normalCount += chunk.data.normals.size();
+		texCoordCount += chunk.data.texCoords.size();
+		indexCount += chunk.data.indices.size();
+	}
+
+	data.positions.reserve(positionCount);
+	data.normals.reserve(normalCount);
+	data.texCoords.reserve(texCoordCount);
+	data.indices.reserve(indexCount);
+
+	for (auto& chunk : chunks)
+	{
+		// Negative indices only know their position within the chunk, so offset them by everything before it
+		const int offsets[3] = { (int)data.positions.size(), (int)data.texCoords.size(), (int)data.normals.size() };
+		int* flatIndices = reinterpret_cast<int*>(chunk.data.indices.data());
+
+		for (int k = 0; k < 3; k++)
+		{
+			for (size_t flatIndex : chunk.relativeIndices[k])
+				flatIndices[flatIndex] += offsets[k];
+		}
+
+		data.positions.insert(data.positions.end(), chunk.data.positions.begin(), chunk.data.positions.end());
+		data.normals.insert(data.normals.end(), chunk.data.normals.begin(), chunk.data.normals.end());
+		data.texCoords.insert(data.texCoords.end(), chunk.data.texCoords.begin(), chunk.data.texCoords.end());
+		data.indices.insert(data.indices.end(), chunk.data.indices.begin(), chunk.data.indices.end());
+		data.invalidFaces += chunk.data.invalidFaces;
+
+		chunk.data.clear();
+	}
+}
+
+// Removes the triangles referring to elements which aren't in the file, e.g. "f 1 2 9" with 8 positions or a
+// relative index reaching past the first element
+void ObjParser::DropOutOfRange(ObjData& data)
+{
+	const int counts[3] = { (int)data.positions.size(), (int)data.texCoords.size(), (int)data.normals.size() };
+
+	auto isValid = [&](const ObjIndex& index)
+	{
+		const int* components = &index.position;
+
+		// The position has to be there, the texture coordinate and normal may be missing (-1)
+		for (int k = 0; k < 3; k++)
+		{
+			if (components[k] >= counts[k] || components[k] < (k == 0 ? 0 : -1))
+				return false;
+		}
+
+		return true;
+	};
+
+	size_t kept = 0;
+	for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+	{
+		if (isValid(data.indices[i]) && isValid(data.indices[i + 1]) && isValid(data.indices[i + 2]))
+		{
+			data.indices[kept++] = data.indices[i];
+			data.indices[kept++] = data.indices[i + 1];
+			data.indices[kept++] = data.indices[i + 2];
+		}
+		else
+			data.invalidFaces++;
+	}
+
+	data.indices.resize(kept);
+}
+
+const char* ObjParser::SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+
+	return p;
+}
+
+// Returns the first character after the next line break
+const char* ObjParser::SkipLine(const char* p, const char* end)
+{
+	const void* newline = p < end ? memchr(p, '\n', (size_t)(end - p)) : nullptr;
+	return newline ? (const char*)newline + 1 : end;
+}
+
+const char* ObjParser::ParseFloat(const char* p, const char* end, float& value)
+{
+	// Exact powers of ten which can be represented by a double
+	static constexpr double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	p = SkipSpaces(p, end);
+
+	bool bNegative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		bNegative = (*p == '-');
+		p++;
+	}
+
+	// Digits are accumulated into an integer and scaled once at the end
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+			digits++;
+		}
+		else
+		{
+			exponent++;
+		}
+		p++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+				digits++;
+				exponent--;
+			}
+			p++;
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+
+		bool bNegativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			bNegativeExponent = (*p == '-');
+			p++;
+		}
+
+		int e = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (e < 10000)
+				e = e * 10 + (*p - '0');
+			p++;
+		}
+
+		exponent += bNegativeExponent ? -e : e;
+	}
+
+	double result = (double)mantissa;
+
+	while (exponent > 22)
+	{
+		result *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22)
+	{
+		result /= 1e22;
+		exponent += 22;
+	}
+
+	result = exponent >= 0 ? result * powers[exponent] : result / powers[-exponent];
+
+	value = (float)(bNegative ? -result : result);
+	return p;
+}
+
+const char* ObjParser::ParseInt(const char* p, const char* end, int& value)
+{
+	const char* begin = p;
+
+	bool bNegative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		bNegative = (*p == '-');
+		p++;
+	}
+
+	const char* digits = p;
+
+	// Saturates instead of overflowing, such an index is out of range anyway
+	int result = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		result = result < 100000000 ? result * 10 + (*p - '0') : 1000000000;
+		p++;
+	}
+
+	// No digits (a lone sign or any other character): 'p' is returned unchanged
+	if (p == digits)
+	{
+		value = 0;
+		return begin;
+	}
+
+	value = bNegative ? -result : result;
+	return p;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include "Shader.h"
+
+// Binding points of the uniform blocks, the same in every shader
+constexpr unsigned int CAMERA_BLOCK_BINDING = 0;
+constexpr unsigned int LIGHTS_BLOCK_BINDING = 1;
+
+// Has to match NR_POINT_LIGHTS in the shaders
+constexpr int NR_POINT_LIGHTS = 1;
+
+/**
+  * The structs below mirror the std140 layout of the uniform blocks in the shaders:
+  *
+  *	layout (std140) uniform Camera
+  *	{
+  *		mat4 matView;
+  *		mat4 matProjection;
+  *		vec3 u_vViewPos;
+  *	};
+  *
+  *	layout (std140) uniform Lights
+  *	{
+  *		DirLight u_dirLight;
+  *		PointLight u_pointLights[NR_POINT_LIGHTS];
+  *		SpotLight u_spotLight;
+  *	};
+  *
+  * In std140 a vec3 is aligned like a vec4, so each one is followed by a float (used or padding). The light structs
+  * in the shaders list their members in the same order.
+  */
+struct CameraUniforms
+{
+	glm::mat4 matView = glm::mat4(1.0f);
+	glm::mat4 matProjection = glm::mat4(1.0f);
+	glm::vec3 vViewPos = glm::vec3(0.0f);
+	float fPadding0 = 0.0f;
+};
+
+struct DirLightUniforms
+{
+	glm::vec3 vDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	float fPadding0 = 0.0f;
+	glm::vec3 vLightColor = glm::vec3(1.0f);
+	float fPadding1 = 0.0f;
+	glm::vec3 vAmbient = glm::vec3(0.0f);
+	float fPadding2 = 0.0f;
+	glm::vec3 vDiffuse = glm::vec3(0.0f);
+	float fPadding3 = 0.0f;
+	glm::vec3 vSpecular = glm::vec3(0.0f);
+	float fPadding4 = 0.0f;
+};
+
+struct PointLightUniforms
+{
+	glm::vec3 vPosition = glm::vec3(0.0f);
+	float fConstant = 1.0f;
+	glm::vec3 vLightColor = glm::vec3(1.0f);
+	float fLinear = 0.0f;
+	glm::vec3 vAmbient = glm::vec3(0.0f);
+	float fQuadratic = 0.0f;
+	glm::vec3 vDiffuse = glm::vec3(0.0f);
+	float fPadding0 = 0.0f;
+	glm::vec3 vSpecular = glm::vec3(0.0f);
+	float fPadding1 = 0.0f;
+};
+
+struct SpotLightUniforms
+{
+	glm::vec3 vPosition = glm::vec3(0.0f);
+	float fConstant = 1.0f;
+	glm::vec3 vDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	float fLinear = 0.0f;
+	glm::vec3 vLightColor = glm::vec3(1.0f);
+	float fQuadratic = 0.0f;
+	glm::vec3 vAmbient = glm::vec3(0.0f);
+	float fCutOff = 1.0f;			// Cosine of the angle
+	glm::vec3 vDiffuse = glm::vec3(0.0f);
+	float fOuterCutOff = 1.0f;		// Cosine of the angle
+	glm::vec3 vSpecular = glm::vec3(0.0f);
+	float fPadding0 = 0.0f;
+};
+
+struct LightUniforms
+{
+	DirLightUniforms dirLight;
+	PointLightUniforms pointLights[NR_POINT_LIGHTS];
+	SpotLightUniforms spotLight;
+};
+
+static_assert(sizeof(CameraUniforms) == 144, "CameraUniforms doesn't match the std140 layout of the Camera block");
+static_assert(sizeof(DirLightUniforms) == 80, "DirLightUniforms doesn't match the std140 layout of DirLight");
+static_assert(sizeof(PointLightUniforms) == 80, "PointLightUniforms doesn't match the std140 layout of PointLight");
+static_assert(sizeof(SpotLightUniforms) == 96, "SpotLightUniforms doesn't match the std140 layout of SpotLight");
+
+/**
+  * Camera and light state shared by all shaders. Both blocks live in one uniform buffer, so the whole state is
+  * uploaded with a single glBufferSubData() per frame instead of setting the same uniforms in every program.
+  */
+class SceneUniforms
+{
+private:
+	unsigned int m_Buffer = 0;
+
+	// Uniform buffer ranges have to start at a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	size_t m_LightsOffset = 0;
+	size_t m_Size = 0;
+
+	// Both blocks at their offsets, copied into the buffer by upload()
+	std::vector<unsigned char> m_Staging;
+
+public:
+	CameraUniforms camera;
+	LightUniforms lights;
+
+	SceneUniforms() = default;
+
+	// Creates the buffer and binds both blocks to their binding points
+	void generate();
+
+	// Connects the Camera and Lights blocks of a shader (if it has them) to the binding points. Once per shader.
+	void attach(Shader& shader);
+
+	// Uploads 'camera' and 'lights'. Call once per frame before drawing.
+	void upload();
+
+	void free();
+};
+
+void SceneUniforms::generate()
+{
+	int alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	m_LightsOffset = (sizeof(CameraUniforms) + alignment - 1) / alignment * alignment;
+	m_Size = m_LightsOffset + sizeof(LightUniforms);
+	m_Staging.assign(m_Size, 0);
+
+	glGenBuffers(1, &m_Buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+	glBufferData(GL_UNIFORM_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, m_Buffer, 0, sizeof(CameraUniforms));
+	glBindBufferRange(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, m_Buffer, m_LightsOffset, sizeof(LightUniforms));
+}
+
+void SceneUniforms::attach(Shader& shader)
+{
+	shader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	shader.bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+}
+
+void SceneUniforms::upload()
+{
+	memcpy(m_Staging.data(), &camera, sizeof(CameraUniforms));
+	memcpy(m_Staging.data() + m_LightsOffset, &lights, sizeof(LightUniforms));
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, m_Size, m_Staging.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SceneUniforms::free()
+{
+	if (m_Buffer)
+	{
+		glDeleteBuffers(1, &m_Buffer);
+		m_Buffer = 0;
+	}
+}
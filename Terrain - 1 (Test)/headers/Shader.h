@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLState.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -12,9 +14,21 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+
+// Handle to a uniform of a shader program. Fetch it once with Shader::getUniform() and pass it to the
+// set functions to avoid looking up the uniform location by name every time.
+struct Uniform
+{
+	int location = -1;
+};
 
 class Shader
 {
+private:
+	// Uniform locations of the linked program, indexed by name
+	std::unordered_map<std::string, int> m_UniformLocations;
+
 public:
 	unsigned int id;
 
@@ -27,6 +41,9 @@ public:
 
 	void use();
 
+	// Connects the uniform block 'blockName' to a binding point. Does nothing if the program has no such block.
+	void bindUniformBlock(const std::string& blockName, unsigned int binding);
+
 	void setBool(const std::string& name, bool value);
 	void setInt(const std::string& name, int value);
 	void setFloat(const std::string& name, float value);
@@ -34,8 +51,23 @@ public:
 	void setVec3(const std::string& name, const float& f1, const float& f2, const float& f3);
 	void setVec3(const std::string& name, const glm::vec3& vec);
 
+	// Returns a handle to the uniform 'name'. If no such uniform is active, setting it does nothing.
+	Uniform getUniform(const std::string& name);
+
+	void setBool(Uniform uniform, bool value);
+	void setInt(Uniform uniform, int value);
+	void setFloat(Uniform uniform, float value);
+	void setMat4(Uniform uniform, const glm::mat4& mat);
+	void setVec3(Uniform uniform, const float& f1, const float& f2, const float& f3);
+	void setVec3(Uniform uniform, const glm::vec3& vec);
+
 private:
 	unsigned int CompileShader(unsigned int type, const std::string& source, const std::string& shaderPath);
+
+	// Stores the location of every active uniform, so that they don't have to be queried from OpenGL later on
+	void CacheUniformLocations();
+
+	int getUniformLocation(const std::string& name);
 };
 
 void Shader::load(const std::string& shaderPath)
@@ -108,41 +140,85 @@ void Shader::load(const std::string& shaderPath)
 
 	glDeleteShader(vs);
 	glDeleteShader(fs);
+
+	CacheUniformLocations();
 }
 
 void Shader::use()
 {
-	glUseProgram(id);
+	GLState::get().useProgram(id);
+}
+
+void Shader::bindUniformBlock(const std::string& blockName, unsigned int binding)
+{
+	unsigned int index = glGetUniformBlockIndex(id, blockName.c_str());
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(id, index, binding);
 }
 
 void Shader::setBool(const std::string& name, bool value)
 {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
+	glUniform1i(getUniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value)
 {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value)
 {
-	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 {
-	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::setVec3(const std::string& name, const float& f1, const float& f2, const float& f3)
 {
-	glUniform3f(glGetUniformLocation(id, name.c_str()), f1, f2, f3);
+	glUniform3f(getUniformLocation(name), f1, f2, f3);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& vec)
 {
-	glUniform3f(glGetUniformLocation(id, name.c_str()), vec.x, vec.y, vec.z);
+	glUniform3f(getUniformLocation(name), vec.x, vec.y, vec.z);
+}
+
+Uniform Shader::getUniform(const std::string& name)
+{
+	return Uniform{ getUniformLocation(name) };
+}
+
+void Shader::setBool(Uniform uniform, bool value)
+{
+	glUniform1i(uniform.location, (int)value);
+}
+
+void Shader::setInt(Uniform uniform, int value)
+{
+	glUniform1i(uniform.location, value);
+}
+
+void Shader::setFloat(Uniform uniform, float value)
+{
+	glUniform1f(uniform.location, value);
+}
+
+void Shader::setMat4(Uniform uniform, const glm::mat4& mat)
+{
+	glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setVec3(Uniform uniform, const float& f1, const float& f2, const float& f3)
+{
+	glUniform3f(uniform.location, f1, f2, f3);
+}
+
+void Shader::setVec3(Uniform uniform, const glm::vec3& vec)
+{
+	glUniform3f(uniform.location, vec.x, vec.y, vec.z);
 }
 
 // Private utility function - to compile vertex and fragment shader
@@ -178,4 +254,48 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source,
 	return shader;
 }
 
+// Private utility function - to enumerate the active uniforms of the program once it has been linked
+void Shader::CacheUniformLocations()
+{
+	m_UniformLocations.clear();
+
+	int count = 0;
+	int maxLength = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::string name(maxLength, '\0');
+
+	for (int i = 0; i < count; i++)
+	{
+		int length = 0;
+		int size = 0;
+		GLenum type;
+		glGetActiveUniform(id, (GLuint)i, maxLength, &length, &size, &type, name.data());
+
+		const std::string uniformName = name.substr(0, length);
+		int location = glGetUniformLocation(id, uniformName.c_str());
+		m_UniformLocations[uniformName] = location;
+
+		// Arrays are reported as "name[0]", but are usually set using just "name"
+		if (uniformName.ends_with("[0]"))
+			m_UniformLocations[uniformName.substr(0, uniformName.size() - 3)] = location;
+	}
+}
+
+// Private utility function - to look up a uniform location in the cache
+int Shader::getUniformLocation(const std::string& name)
+{
+	auto it = m_UniformLocations.find(name);
+	if (it != m_UniformLocations.end())
+		return it->second;
+
+	// Elements other than the first one of an array of basic types (e.g. "fValues[2]") are not enumerated.
+	// Query them once and remember the result, including -1 for uniforms which don't exist.
+	int location = glGetUniformLocation(id, name.c_str());
+	m_UniformLocations[name] = location;
+
+	return location;
+}
+
 #endif
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 #include "stb_image_impl.h"
 
 #include <iostream>
@@ -29,7 +31,7 @@ public:
 void Texture2D::load(GLenum wrapType, GLint minFilter, GLint magFilter, const std::string textureFile, GLint internalFormat, GLenum format)
 {
 	glGenTextures(1, &m_TextureID);
-	glBindTexture(GL_TEXTURE_2D, m_TextureID);
+	GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapType);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapType);
@@ -61,7 +63,7 @@ unsigned int Texture2D::getTextureID() const
 
 void Texture2D::bindTexture() const
 {
-	glBindTexture(GL_TEXTURE_2D, m_TextureID);
+	GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 }
 
 void Texture2D::loadTexture(char const* path)
@@ -82,7 +84,7 @@ void Texture2D::loadTexture(char const* path)
 		else
 			exit(-1);
 
-		glBindTexture(GL_TEXTURE_2D, m_TextureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 class VertexArray
 {
 private:
@@ -22,20 +24,20 @@ public:
 void VertexArray::generate()
 {
 	glGenVertexArrays(1, &m_VertexArrayID);
-	glBindVertexArray(m_VertexArrayID);
+	GLState::get().bindVertexArray(m_VertexArrayID);
 }
 
 void VertexArray::bind() const
 {
-	glBindVertexArray(m_VertexArrayID);
+	GLState::get().bindVertexArray(m_VertexArrayID);
 }
 
 void VertexArray::unbind() const
 {
-	glBindVertexArray(0);
+	GLState::get().bindVertexArray(0);
 }
 
 void VertexArray::free() const
 {
-	glDeleteVertexArrays(1, &m_VertexArrayID);
+	GLState::get().deleteVertexArrays(1, &m_VertexArrayID);
 }
\ No newline at end of file
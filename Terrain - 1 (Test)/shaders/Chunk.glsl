@@ -2,23 +2,33 @@
 
 layout (location = 0) in vec3 vPos;
 layout (location = 1) in vec3 vNorm;
-layout (location = 2) in vec2 aTexCoords;
+layout (location = 2) in vec2 aTexCoords;		// In blocks, a tile repeats once per block
+layout (location = 3) in float aLayer;			// Layer in the block texture array
 
-uniform mat4 matModel;
-uniform mat4 matView;
-uniform mat4 matProjection;
+// Chunk meshes are in chunk space, this moves them into world space
+uniform vec3 u_vChunkOffset;
+
+// Shared by all shaders, see SceneUniforms.h
+layout (std140) uniform Camera
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec3 u_vViewPos;
+};
 
 out vec3 vNormal;
 out vec3 vFragPos;
 out vec2 TexCoords;
+flat out float fLayer;
 
 void main()
 {
-	gl_Position = matProjection * matView * matModel * vec4(vPos, 1.0f);
+	vFragPos = vPos + u_vChunkOffset;
+	gl_Position = matProjection * matView * vec4(vFragPos, 1.0f);
 
-	vFragPos = vec3(matModel * vec4(vPos, 1.0f));
-	vNormal = mat3(transpose(inverse(matModel))) * vNorm;
+	vNormal = vNorm;
 	TexCoords = aTexCoords;
+	fLayer = aLayer;
 }
 #endif
 
@@ -26,12 +36,13 @@ void main()
 
 struct Material
 {
-	sampler2D diffuse;
-	sampler2D specular;
+	// Block textures, one per layer, used for both the diffuse and the specular color
+	sampler2DArray blocks;
 
 	float fShininess;
 };
 
+// The members are ordered for the std140 layout of the Lights block, see SceneUniforms.h
 struct DirLight
 {
 	vec3 vDirection;
@@ -45,13 +56,12 @@ struct DirLight
 struct PointLight
 {
 	vec3 vPosition;
-	vec3 vLightColor;
-	
 	float fConstant;
+	vec3 vLightColor;
 	float fLinear;
-	float fQuadratic;
 
 	vec3 vAmbient;
+	float fQuadratic;
 	vec3 vDiffuse;
 	vec3 vSpecular;
 };
@@ -59,34 +69,46 @@ struct PointLight
 struct SpotLight
 {
 	vec3 vPosition;
+	float fConstant;
 	vec3 vDirection;
+	float fLinear;
 	vec3 vLightColor;
+	float fQuadratic;
 
 	vec3 vAmbient;
-	vec3 vDiffuse;
-	vec3 vSpecular;
-
 	float fCutOff;
+	vec3 vDiffuse;
 	float fOuterCutOff;
-
-	float fConstant;
-	float fLinear;
-	float fQuadratic;
+	vec3 vSpecular;
 };
 
 // Uniforms are indicated by the 'u_' prefix
 
 #define	NR_POINT_LIGHTS 1
-uniform DirLight u_dirLight;
-uniform PointLight u_pointLights[NR_POINT_LIGHTS];
-uniform SpotLight u_spotLight;
+layout (std140) uniform Lights
+{
+	DirLight u_dirLight;
+	PointLight u_pointLights[NR_POINT_LIGHTS];
+	SpotLight u_spotLight;
+};
+
+// Shared by all shaders, see SceneUniforms.h
+layout (std140) uniform Camera
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec3 u_vViewPos;
+};
 
-uniform vec3 u_vViewPos;
 uniform Material u_material;
 
 in vec3 vNormal;
 in vec3 vFragPos;
 in vec2 TexCoords;
+flat in float fLayer;
+
+// Color of the block, sampled once in main()
+vec3 vColor;
 
 out vec4 FragColor;
 
@@ -94,8 +116,16 @@ vec3 CalcDirLight(DirLight light, vec3 vNormal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir);
 
+vec3 SampleBlockTexture()
+{
+	// The layers wrap with GL_REPEAT, so a texture repeats once per block across merged faces
+	return texture(u_material.blocks, vec3(TexCoords, fLayer)).rgb;
+}
+
 void main()
 {
+	vColor = SampleBlockTexture();
+
 	vec3 vNorm = normalize(vNormal);
 	vec3 vViewDir = normalize(u_vViewPos - vFragPos);
 
@@ -121,16 +151,16 @@ vec3 CalcSpotLight(SpotLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir)
 	vec3 vLightDir = normalize(light.vPosition - vFragPos);
 
 	// Ambient shading
-	vec3 vAmbient = light.vAmbient * light.vLightColor * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vAmbient = light.vAmbient * light.vLightColor * vColor;
 
 	// Diffuse shading
 	float fDiff = max(dot(vLightDir, vNormal), 0.0f);
-	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * vColor;
 
 	// Specular shading
 	vec3 vReflectDir = reflect(-vLightDir, vNormal);
 	float fSpec = pow(max(dot(vViewDir, vReflectDir), 0.0f), u_material.fShininess);
-	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * texture(u_material.specular, TexCoords).rgb;
+	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * vColor;
 
 	// SpotLight
 	float fTheta = dot(vLightDir, normalize(-light.vDirection));
@@ -155,16 +185,16 @@ vec3 CalcPointLight(PointLight light, vec3 vNormal, vec3 vFragPos, vec3 vViewDir
 	vec3 vLightDir = normalize(light.vPosition - vFragPos);
 
 	// Ambient shading
-	vec3 vAmbient = light.vAmbient * light.vLightColor * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vAmbient = light.vAmbient * light.vLightColor * vColor;
 
 	// Diffuse shading
 	float fDiff = max(dot(vNormal, vLightDir), 0.0f);
-	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * vColor;
 
 	// Specular shading
 	vec3 vReflectDir = reflect(-vLightDir, vNormal);
 	float fSpec = pow(max(dot(vViewDir, vReflectDir), 0.0f), u_material.fShininess);
-	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * texture(u_material.specular, TexCoords).rgb;
+	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * vColor;
 
 	// Attenuation
 	float fDistance = length(light.vPosition - vFragPos);
@@ -182,16 +212,16 @@ vec3 CalcDirLight(DirLight light, vec3 vNormal, vec3 vViewDir)
 	vec3 vLightDir = normalize(-light.vDirection);
 
 	// Ambient shading
-	vec3 vAmbient = light.vAmbient * light.vLightColor * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vAmbient = light.vAmbient * light.vLightColor * vColor;
 
 	// Diffuse shading
 	float fDiff = max(dot(vNormal, vLightDir), 0.0f);
-	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * texture(u_material.diffuse, TexCoords).rgb;
+	vec3 vDiffuse = light.vDiffuse * light.vLightColor * fDiff * vColor;
 
 	// Specular shading
 	vec3 vReflectDir = reflect(-vLightDir, vNormal);
 	float fSpec = pow(max(dot(vViewDir, vReflectDir), 0.0f), u_material.fShininess);
-	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * texture(u_material.specular, TexCoords).rgb;
+	vec3 vSpecular = light.vSpecular * light.vLightColor * fSpec * vColor;
 
 	return (vAmbient + vDiffuse + vSpecular);
 }
@@ -0,0 +1,97 @@
+/**
+  * Offline converter which bakes object files into the binary .mesh format (see headers/MeshCache.h),
+  * so that the first run of the program doesn't have to parse them either.
+  *
+  * Build from the project directory (no OpenGL needed), for example:
+  *		g++ -std=c++20 -O2 -Iheaders -I../externals tools/MeshConverter.cpp -o MeshConverter -pthread
+  *
+  * Usage: MeshConverter [--force] <model.obj | directory>...
+  *	Directories are searched (non-recursively) for .obj files. Up-to-date .mesh files are skipped unless --force is given.
+  */
+
+#include "../headers/MeshCache.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	bool bForce = false;
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--force")
+		{
+			bForce = true;
+		}
+
+		else if (std::filesystem::is_directory(arg))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(arg))
+			{
+				if (entry.path().extension() == ".obj")
+					files.push_back(entry.path().generic_string());
+			}
+		}
+
+		else
+		{
+			files.push_back(arg);
+		}
+	}
+
+	if (files.empty())
+	{
+		std::cout << "Usage: MeshConverter [--force] <model.obj | directory>..." << std::endl;
+		return 1;
+	}
+
+	int failed = 0;
+
+	for (const auto& file : files)
+	{
+		MeshFileView existing;
+		if (!bForce && MeshCache::load(file, existing))
+		{
+			std::cout << file << ": up to date" << std::endl;
+			continue;
+		}
+
+		auto t1 = std::chrono::steady_clock::now();
+
+		ObjData obj;
+		if (!ObjParser::parse(file, obj))
+		{
+			std::cerr << file << ": failed to open" << std::endl;
+			failed++;
+			continue;
+		}
+
+		if (obj.invalidFaces > 0)
+			std::cerr << file << ": skipped " << obj.invalidFaces << " invalid faces" << std::endl;
+
+		MeshData mesh;
+		MeshBuilder::build(obj, mesh);
+
+		if (!MeshCache::save(file, mesh))
+		{
+			std::cerr << file << ": failed to write " << MeshCache::getCachePath(file) << std::endl;
+			failed++;
+			continue;
+		}
+
+		auto t2 = std::chrono::steady_clock::now();
+		std::chrono::duration<float, std::milli> elapsedTime = t2 - t1;
+
+		std::cout << file << ": " << mesh.getVertexCount() << " vertices, " << mesh.getIndexCount() << " indices ("
+			<< (mesh.indexType == IndexType::UINT16 ? 16 : 32) << "-bit), " << elapsedTime.count() << " ms" << std::endl;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+/**
+  * Compares the load time of the object files in models/ between the old line-by-line loader
+  * (std::getline + sscanf, as Model::LoadModel used to do it) and ObjParser.
+  *
+  * Build from the project directory (no OpenGL needed), for example:
+  *		g++ -std=c++20 -O2 -Iheaders -I../externals tools/ObjBenchmark.cpp -o ObjBenchmark -pthread
+  *
+  * Usage: ObjBenchmark [iterations] [model files...]	(defaults to 10 iterations over every model in models/)
+  */
+
+#include "../headers/ObjParser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The loader which ObjParser replaces, kept here as a baseline. Returns the number of face vertices read.
+static size_t LoadLegacy(const std::string& modelFile)
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<float> vertices;
+
+	std::ifstream inputFileStream(modelFile);
+	std::string line;
+
+	while (std::getline(inputFileStream, line))
+	{
+		if (line.starts_with("vn"))
+		{
+			float f1, f2, f3;
+			sscanf(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
+			normals.push_back({ f1, f2, f3 });
+		}
+
+		else if (line.starts_with("vt"))
+		{
+			float f1, f2;
+			sscanf(line.c_str(), "%*s %f %f", &f1, &f2);
+			texCoords.push_back({ f1, f2 });
+		}
+
+		else if (line.starts_with('v'))
+		{
+			float f1, f2, f3;
+			sscanf(line.c_str(), "%*s %f %f %f", &f1, &f2, &f3);
+			positions.push_back({ f1, f2, f3 });
+		}
+
+		else if (line.starts_with('f'))
+		{
+			int v[3], t[3] = { 1, 1, 1 }, n[3];
+
+			if (texCoords.empty())
+				sscanf(line.c_str(), "%*s %d//%d %d//%d %d//%d", &v[0], &n[0], &v[1], &n[1], &v[2], &n[2]);
+			else
+				sscanf(line.c_str(), "%*s %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &t[0], &n[0], &v[1], &t[1], &n[1], &v[2], &t[2], &n[2]);
+
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3& p = positions[v[i] - 1];
+				const glm::vec3& nrm = normals[n[i] - 1];
+				vertices.insert(vertices.end(), { p.x, p.y, p.z, nrm.x, nrm.y, nrm.z });
+
+				if (!texCoords.empty())
+				{
+					const glm::vec2& uv = texCoords[t[i] - 1];
+					vertices.insert(vertices.end(), { uv.x, uv.y });
+				}
+			}
+		}
+	}
+
+	return vertices.size() / (texCoords.empty() ? 6 : 8);
+}
+
+template<typename Function>
+static double TimeMilliseconds(int iterations, Function&& function)
+{
+	auto t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+		function();
+	auto t2 = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+	std::vector<std::string> files;
+	for (int i = 2; i < argc; i++)
+		files.push_back(argv[i]);
+
+	if (files.empty())
+	{
+		for (const auto& entry : std::filesystem::directory_iterator("models"))
+		{
+			if (entry.path().extension() == ".obj")
+				files.push_back(entry.path().string());
+		}
+		std::sort(files.begin(), files.end());
+	}
+
+	std::cout << std::left << std::setw(32) << "Model" << std::right << std::setw(14) << "Legacy (ms)" << std::setw(14) << "ObjParser (ms)" << std::setw(10) << "Speedup" << '\n';
+
+	double totalLegacy = 0.0, totalParser = 0.0;
+
+	for (const auto& file : files)
+	{
+		size_t legacyVertices = 0, parserVertices = 0;
+		ObjData data;
+
+		double legacy = TimeMilliseconds(iterations, [&]() { legacyVertices = LoadLegacy(file); });
+		double parser = TimeMilliseconds(iterations, [&]() { ObjParser::parse(file, data); parserVertices = data.indices.size(); });
+
+		totalLegacy += legacy;
+		totalParser += parser;
+
+		std::cout << std::left << std::setw(32) << file << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(14) << legacy << std::setw(14) << parser << std::setw(9) << std::setprecision(1) << legacy / parser << 'x';
+
+		if (legacyVertices != parserVertices)
+			std::cout << "  (vertex count mismatch: " << legacyVertices << " vs " << parserVertices << ")";
+
+		std::cout << '\n';
+	}
+
+	std::cout << std::left << std::setw(32) << "Total" << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(14) << totalLegacy << std::setw(14) << totalParser << std::setw(9) << std::setprecision(1) << totalLegacy / totalParser << "x\n";
+
+	return 0;
+}
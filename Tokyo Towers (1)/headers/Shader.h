@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLState.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -30,6 +32,7 @@ public:
 	void setBool(const std::string& name, bool value);
 	void setInt(const std::string& name, int value);
 	void setFloat(const std::string& name, float value);
+	void setMat3(const std::string& name, const glm::mat3& mat);
 	void setMat4(const std::string& name, const glm::mat4& mat);
 	void setVec3(const std::string& name, const float& f1, const float& f2, const float& f3);
 	void setVec3(const std::string& name, const glm::vec3& vec);
@@ -112,7 +115,7 @@ void Shader::load(const std::string& shaderPath)
 
 void Shader::use()
 {
-	glUseProgram(id);
+	GLState::get().useProgram(id);
 }
 
 void Shader::setBool(const std::string& name, bool value)
@@ -130,6 +133,11 @@ void Shader::setFloat(const std::string& name, float value)
 	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
 }
 
+void Shader::setMat3(const std::string& name, const glm::mat3& mat)
+{
+	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 {
 	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
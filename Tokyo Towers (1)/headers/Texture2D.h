@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 #include "stb_image_impl.h"
 
 #include <iostream>
@@ -22,7 +24,7 @@ public:
 	void load(GLenum wrapType, GLint minFilter, GLint magFilter, const std::string textureFile, GLint internalFormat, GLenum format)
 	{
 		glGenTextures(1, &m_TextureID);
-		glBindTexture(GL_TEXTURE_2D, m_TextureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapType);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapType);
@@ -54,7 +56,7 @@ public:
 
 	void bindTexture() const
 	{
-		glBindTexture(GL_TEXTURE_2D, m_TextureID);
+		GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 	}
 
 	void loadTexture(char const* path)
@@ -75,7 +77,7 @@ public:
 			else
 				exit(-1);
 
-			glBindTexture(GL_TEXTURE_2D, m_TextureID);
+			GLState::get().bindTexture(GL_TEXTURE_2D, m_TextureID);
 			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 			glGenerateMipmap(GL_TEXTURE_2D);
 
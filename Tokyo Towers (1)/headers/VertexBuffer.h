@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "GLState.h"
+
 template<typename T>
 class VertexBuffer
 {
@@ -19,17 +21,17 @@ public:
 		m_VertexCount = vertexCount;
 
 		glGenBuffers(1, &m_VertexBufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
 	}
 
 	void bind() const
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
 	}
 
 	void unbind() const
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		GLState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	void setBuffer(size_t bytes, const void* data)
@@ -50,7 +52,7 @@ public:
 
 	void free() const
 	{
-		glDeleteBuffers(1, &m_VertexBufferID);
+		GLState::get().deleteBuffers(1, &m_VertexBufferID);
 	}
 
 	const unsigned int getID() const
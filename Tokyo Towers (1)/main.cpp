@@ -215,6 +215,7 @@ public:
 		matModel = glm::translate(matModel, glm::vec3(-20.0f, 0.0f, 0.0f));
 		//matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 		modelShader.setMat4("matModel", matModel);
+		modelShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		glDrawArrays(GL_TRIANGLES, 0, modelVertexCount);
 
@@ -223,6 +224,7 @@ public:
 		matModel = glm::translate(matModel, glm::vec3(-20.0f, 0.0f, 50.0f));
 		matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 		modelShader.setMat4("matModel", matModel);
+		modelShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		glDrawArrays(GL_TRIANGLES, 0, modelVertexCount);
 	}
@@ -242,6 +244,7 @@ public:
 		matModel = glm::translate(matModel, glm::vec3(5.0f, 0.0f, 0.0f));
 		//matModel = glm::rotate(matModel, fTimeSinceStart, glm::vec3(0.0f, 1.0f, 0.0f));
 		cubeShader.setMat4("matModel", matModel);
+		cubeShader.setMat3("matNormal", glm::transpose(glm::inverse(glm::mat3(matModel))));
 
 		glDrawArrays(GL_TRIANGLES, 0, cubeVertexCount);
 	}